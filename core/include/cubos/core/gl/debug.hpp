@@ -4,23 +4,35 @@
 
 #pragma once
 
-#include <list>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
 #include <cubos/core/geom/box.hpp>
 #include <cubos/core/gl/render_device.hpp>
+#include <cubos/core/gl/upload_ring.hpp>
 
 namespace cubos::core::gl
 {
     /// @brief Singleton with static methods used to draw primitive objects on screen for debugging
     /// purposes.
+    ///
+    /// Requests are recorded into per-thread buffers, so that threads drawing at the same time
+    /// don't contend on a single lock. On @ref flush(), requests of the same object and raster
+    /// state are drawn together, with a single instanced draw for up to @ref MaxInstanceCount
+    /// requests.
+    ///
     /// @ingroup core-gl
     class Debug
     {
     public:
+        /// @brief Maximum number of requests drawn by a single instanced draw. Their instance data
+        /// must fit in the minimum uniform block size guaranteed by OpenGL, 16 KB.
+        static constexpr std::size_t MaxInstanceCount = 204;
+
         /// @brief Initializes the debug rendering system.
         /// @param renderDevice Render device to use.
         static void init(RenderDevice& renderDevice);
@@ -75,33 +87,55 @@ namespace cubos::core::gl
         struct DebugDrawObject
         {
             gl::VertexArray va = nullptr;
-            gl::IndexBuffer ib = nullptr;
-            unsigned int numIndices;
+            gl::IndexBuffer ib = nullptr; ///< Null if the object is a line list.
+            unsigned int numIndices;      ///< Number of indices, or of vertices if there's no index buffer.
 
             void clear();
         };
 
         struct DebugDrawRequest
         {
-            DebugDrawObject& obj;
+            DebugDrawObject* obj;
             gl::RasterState rasterState;
             glm::mat4 modelMatrix;
             double timeLeft;
             glm::vec3 color;
         };
 
+        /// @brief Per-instance data read by the vertex shader, laid out as in std140.
+        struct Instance
+        {
+            glm::mat4 mvp;
+            glm::vec4 color;
+        };
+
+        static_assert(MaxInstanceCount * sizeof(Instance) <= 16384);
+
+        /// @brief Requests recorded by a single thread since the last flush.
+        struct ThreadRequests
+        {
+            std::mutex mutex; ///< Only contended while the requests are being flushed.
+            std::vector<DebugDrawRequest> requests;
+        };
+
         static void initCube();
         static void initSphere();
+        static void initLine();
+
+        /// @brief Records a request into the calling thread's buffer.
+        /// @param request Request.
+        static void push(const DebugDrawRequest& request);
 
         static gl::RenderDevice* renderDevice;
-        static gl::ConstantBuffer mvpBuffer;
-        static gl::ShaderBindingPoint mvpBindingPoint, colorBindingPoint;
+        static std::unique_ptr<gl::UploadRing> uploads;
+        static gl::ShaderBindingPoint instancesBindingPoint;
         static gl::ShaderPipeline pipeline;
 
         static gl::RasterState fillRasterState, wireframeRasterState;
-        static DebugDrawObject objCube, objSphere;
+        static DebugDrawObject objCube, objSphere, objLine;
 
-        static std::list<DebugDrawRequest> requests;
+        static std::vector<DebugDrawRequest> requests;
+        static std::vector<std::shared_ptr<ThreadRequests>> threadRequests;
 
         static std::mutex debugDrawMutex;
     };
@@ -0,0 +1,100 @@
+/// @file
+/// @brief Class @ref cubos::core::gl::NullRenderDevice.
+/// @ingroup core-gl
+
+#pragma once
+
+#include <cstddef>
+
+#include <cubos/core/gl/render_device.hpp>
+
+namespace cubos::core::gl
+{
+    /// @brief Render device implementation which doesn't render anything, and instead only
+    /// records statistics about the commands it receives.
+    ///
+    /// Useful to test code which uses a render device without a graphics context, such as in
+    /// headless CI machines, and to measure the CPU-side cost of a renderer. Mapped buffers are
+    /// backed by CPU memory, shaders are never compiled, and any binding point name is valid.
+    ///
+    /// @ingroup core-gl
+    class NullRenderDevice : public RenderDevice
+    {
+    public:
+        /// @brief Statistics about the commands received by the device.
+        struct Stats
+        {
+            std::size_t drawCalls = 0;      ///< Number of draw calls.
+            std::size_t instances = 0;      ///< Number of instances drawn, with non-instanced draws counting one.
+            std::size_t elements = 0;       ///< Number of vertices or indices drawn, summed over all instances.
+            std::size_t dispatches = 0;     ///< Number of compute dispatches.
+            std::size_t clears = 0;         ///< Number of clears.
+            std::size_t stateChanges = 0;   ///< Number of calls to the device's `set` methods.
+            std::size_t bindings = 0;       ///< Number of resources bound and constants set on binding points.
+            std::size_t resources = 0;      ///< Number of resources created.
+            std::size_t bytesUploaded = 0;  ///< Number of bytes passed as initial data of buffers.
+            std::size_t textureUpdates = 0; ///< Number of texture updates.
+            std::size_t maps = 0;           ///< Number of buffer maps.
+            std::size_t bytesMapped = 0;    ///< Number of bytes mapped.
+        };
+
+        /// @brief Constructs.
+        NullRenderDevice();
+
+        /// @brief Gets the statistics recorded since construction or the last call to
+        /// @ref resetStats().
+        /// @return Recorded statistics.
+        const Stats& stats() const;
+
+        /// @brief Resets the recorded statistics to zero.
+        void resetStats();
+
+        Framebuffer createFramebuffer(const FramebufferDesc& desc) override;
+        void setFramebuffer(Framebuffer fb) override;
+        RasterState createRasterState(const RasterStateDesc& desc) override;
+        void setRasterState(RasterState rs) override;
+        DepthStencilState createDepthStencilState(const DepthStencilStateDesc& desc) override;
+        void setDepthStencilState(DepthStencilState dss) override;
+        BlendState createBlendState(const BlendStateDesc& desc) override;
+        void setBlendState(BlendState bs) override;
+        Sampler createSampler(const SamplerDesc& desc) override;
+        Texture1D createTexture1D(const Texture1DDesc& desc) override;
+        Texture2D createTexture2D(const Texture2DDesc& desc) override;
+        Texture2DArray createTexture2DArray(const Texture2DArrayDesc& desc) override;
+        Texture3D createTexture3D(const Texture3DDesc& desc) override;
+        CubeMap createCubeMap(const CubeMapDesc& desc) override;
+        CubeMapArray createCubeMapArray(const CubeMapArrayDesc& desc) override;
+        ConstantBuffer createConstantBuffer(std::size_t size, const void* data, Usage usage) override;
+        IndexBuffer createIndexBuffer(std::size_t size, const void* data, IndexFormat format, Usage usage) override;
+        void setIndexBuffer(IndexBuffer ib) override;
+        VertexBuffer createVertexBuffer(std::size_t size, const void* data, Usage usage) override;
+        VertexArray createVertexArray(const VertexArrayDesc& desc) override;
+        void setVertexArray(VertexArray va) override;
+        ShaderStage createShaderStage(Stage stage, const char* src) override;
+        ShaderPipeline createShaderPipeline(ShaderStage vs, ShaderStage ps) override;
+        ShaderPipeline createShaderPipeline(ShaderStage vs, ShaderStage gs, ShaderStage ps) override;
+        ShaderPipeline createShaderPipeline(ShaderStage cs) override;
+        void setShaderPipeline(ShaderPipeline pipeline) override;
+        void clearColor(float r, float g, float b, float a) override;
+        void clearTargetColor(std::size_t target, float r, float g, float b, float a) override;
+        void clearDepth(float depth) override;
+        void clearStencil(int stencil) override;
+        void drawTriangles(std::size_t offset, std::size_t count) override;
+        void drawTrianglesIndexed(std::size_t offset, std::size_t count) override;
+        void drawTrianglesInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount) override;
+        void drawTrianglesIndexedInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount) override;
+        void drawLines(std::size_t offset, std::size_t count) override;
+        void drawLinesInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount) override;
+        void dispatchCompute(std::size_t x, std::size_t y, std::size_t z) override;
+        void memoryBarrier(MemoryBarriers barriers) override;
+        Fence createFence() override;
+        void setViewport(int x, int y, int w, int h) override;
+        void setScissor(int x, int y, int w, int h) override;
+        int getProperty(Property prop) override;
+        void setShaderPipelineCache(std::string directory) override;
+
+    private:
+        /// @brief Shared with the resources created by the device, which may outlive it.
+        std::shared_ptr<Stats> mStats;
+    };
+} // namespace cubos::core::gl
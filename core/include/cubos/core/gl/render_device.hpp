@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <variant>
 
 #include <glm/glm.hpp>
@@ -74,6 +75,8 @@ namespace cubos::core::gl
         class ShaderStage;
         class ShaderPipeline;
         class ShaderBindingPoint;
+
+        class Fence;
     } // namespace impl
 
     /// @brief Handle to a framebuffer.
@@ -166,6 +169,11 @@ namespace cubos::core::gl
     /// @ingroup core-gl
     using ShaderBindingPoint = impl::ShaderBindingPoint*;
 
+    /// @brief Handle to a fence.
+    /// @see @ref impl::Fence - fence interface.
+    /// @ingroup core-gl
+    using Fence = std::shared_ptr<impl::Fence>;
+
     /// @brief Render device properties that can be queried at runtime.
     /// @see @ref RenderDevice::getProperty().
     /// @ingroup core-gl
@@ -176,6 +184,9 @@ namespace cubos::core::gl
 
         /// @brief Specifies whether compute shaders and memory barriers are supported (0 or 1).
         ComputeSupported,
+
+        /// @brief Specifies the alignment required for offsets of constant buffer ranges, in bytes.
+        ConstantBufferOffsetAlignment,
     };
 
     /// @brief Usage mode for buffers and textures.
@@ -907,6 +918,17 @@ namespace cubos::core::gl
         virtual void drawTrianglesIndexedInstanced(std::size_t offset, std::size_t count,
                                                    std::size_t instanceCount) = 0;
 
+        /// @brief Draws lines, with each pair of vertices forming a line.
+        /// @param offset Index of the first vertex to be drawn.
+        /// @param count Number of vertices that will be drawn.
+        virtual void drawLines(std::size_t offset, std::size_t count) = 0;
+
+        /// @brief Draws lines multiple times, with each pair of vertices forming a line.
+        /// @param offset Index of the first vertex to be drawn.
+        /// @param count Number of vertices that will be drawn.
+        /// @param instanceCount Number of instances drawn.
+        virtual void drawLinesInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount) = 0;
+
         /// @brief Dispatches a compute pipeline.
         /// @param x X dimension of the work group.
         /// @param y Y dimension of the work group.
@@ -922,6 +944,11 @@ namespace cubos::core::gl
         /// @param barriers Barriers to apply.
         virtual void memoryBarrier(MemoryBarriers barriers) = 0;
 
+        /// @brief Inserts a fence after the commands issued so far, which is signaled once they
+        /// have all been executed.
+        /// @return Fence handle, or nullptr on failure.
+        virtual Fence createFence() = 0;
+
         /// @brief Sets the current viewport.
         /// @param x Bottom left viewport corner X coordinate.
         /// @param y Bottom left viewport corner Y coordinate.
@@ -939,6 +966,15 @@ namespace cubos::core::gl
         /// @brief Gets a runtime property of the render device.
         /// @param prop Property name.
         virtual int getProperty(Property prop) = 0;
+
+        /// @brief Sets the directory where linked shader pipelines are cached between runs, which
+        /// reduces startup time. Ignored by devices which don't support it.
+        ///
+        /// While enabled, shader stages may only be compiled when a pipeline which uses them must
+        /// be linked, and thus compilation errors may only be reported by createShaderPipeline().
+        ///
+        /// @param directory Cache directory, or an empty string to disable the cache.
+        virtual void setShaderPipelineCache(std::string directory) = 0;
     };
 
     namespace impl
@@ -1151,6 +1187,20 @@ namespace cubos::core::gl
             /// @return Pointer to the memory region.
             virtual void* map() = 0;
 
+            /// @brief Maps a range of the constant buffer to a region in memory, without waiting
+            /// for previous draw calls which use the buffer. Must be matched with a call to
+            /// @ref unmap().
+            ///
+            /// The range must not be in use by draw calls which may still be running, unless
+            /// @p discard is set, in which case the previous contents of the whole buffer are
+            /// discarded, and draw calls which use them are unaffected.
+            ///
+            /// @param offset Offset of the range, in bytes.
+            /// @param size Size of the range, in bytes.
+            /// @param discard Whether to discard the previous contents of the whole buffer.
+            /// @return Pointer to the memory region.
+            virtual void* mapRange(std::size_t offset, std::size_t size, bool discard) = 0;
+
             /// @brief Unmaps the constant buffer, updating it with data written to the mapped
             /// region.
             virtual void unmap() = 0;
@@ -1296,6 +1346,16 @@ namespace cubos::core::gl
             /// @param cb Constant buffer to bind.
             virtual void bind(gl::ConstantBuffer cb) = 0;
 
+            /// @brief Binds a range of a constant buffer to the binding point.
+            ///
+            /// If this binding point doesn't support a constant buffer, an error is logged.
+            ///
+            /// @param cb Constant buffer to bind.
+            /// @param offset Offset of the range, in bytes. Must be a multiple of
+            /// @ref Property::ConstantBufferOffsetAlignment.
+            /// @param size Size of the range, in bytes.
+            virtual void bind(gl::ConstantBuffer cb, std::size_t offset, std::size_t size) = 0;
+
             /// @brief Binds a level of a 2D texture to an image unit.
             ///
             /// If this binding point doesn't support an image unit, an error is logged.
@@ -1382,6 +1442,23 @@ namespace cubos::core::gl
         protected:
             ShaderBindingPoint() = default;
         };
+
+        /// @brief Abstract fence, used to know when the commands issued before it have finished.
+        class Fence
+        {
+        public:
+            virtual ~Fence() = default;
+
+            /// @brief Checks if the fence has been signaled, without waiting.
+            /// @return Whether the commands issued before the fence have finished.
+            virtual bool signaled() = 0;
+
+            /// @brief Waits until the fence is signaled.
+            virtual void wait() = 0;
+
+        protected:
+            Fence() = default;
+        };
     } // namespace impl
 
     // Operator overloads for MemoryBarriers.
@@ -0,0 +1,96 @@
+/// @file
+/// @brief Class @ref cubos::core::gl::UploadRing.
+/// @ingroup core-gl
+
+#pragma once
+
+#include <deque>
+
+#include <cubos/core/gl/render_device.hpp>
+
+namespace cubos::core::gl
+{
+    /// @brief Sub-allocates per-frame constant buffer data from a single ring buffer.
+    ///
+    /// Allocations are written without waiting for the GPU, as a range is only handed out again
+    /// after the fence inserted by the @ref fence() call which followed it has been signaled.
+    /// If the ring runs out of space and there's nothing left to wait for, it grows.
+    ///
+    /// @ingroup core-gl
+    class UploadRing final
+    {
+    public:
+        /// @brief Range of the ring buffer.
+        struct Allocation
+        {
+            ConstantBuffer buffer; ///< Buffer the range belongs to.
+            std::size_t offset;    ///< Offset of the range, in bytes.
+            std::size_t size;      ///< Size of the range, in bytes.
+        };
+
+        /// @brief Constructs.
+        /// @param renderDevice Render device used to create the buffer and fences.
+        /// @param size Initial size of the ring buffer, in bytes.
+        UploadRing(RenderDevice& renderDevice, std::size_t size);
+
+        /// @brief Allocates a range of the ring buffer, aligned to
+        /// @ref Property::ConstantBufferOffsetAlignment.
+        ///
+        /// The range stays valid until the next call to @ref fence() and the commands issued
+        /// before it finish.
+        ///
+        /// @param size Size of the range, in bytes.
+        /// @return Allocated range.
+        Allocation allocate(std::size_t size);
+
+        /// @brief Allocates a range of the ring buffer and copies data into it.
+        /// @param data Data to copy.
+        /// @param size Size of the data, in bytes.
+        /// @return Allocated range.
+        Allocation upload(const void* data, std::size_t size);
+
+        /// @brief Maps an allocated range to a region in memory, without waiting for the GPU.
+        /// Must be matched with a call to @ref unmap().
+        /// @param allocation Allocated range.
+        /// @return Pointer to the memory region.
+        static void* map(const Allocation& allocation);
+
+        /// @brief Unmaps a range mapped with @ref map().
+        /// @param allocation Allocated range.
+        static void unmap(const Allocation& allocation);
+
+        /// @brief Marks the end of the commands which use the ranges allocated since the last
+        /// call, so that they are reused once those commands finish. Should be called once per
+        /// frame, after its draws.
+        void fence();
+
+        /// @brief Gets the alignment of the allocated ranges.
+        /// @return Alignment, in bytes.
+        std::size_t alignment() const;
+
+        /// @brief Gets the current size of the ring buffer.
+        /// @return Size, in bytes.
+        std::size_t size() const;
+
+    private:
+        /// @brief Ranges guarded by a fence.
+        struct Pending
+        {
+            Fence fence;       ///< Signaled when the ranges are no longer in use.
+            std::size_t bytes; ///< Bytes allocated before the fence, including padding.
+        };
+
+        /// @brief Creates a new, empty, ring buffer.
+        /// @param size Size of the buffer.
+        void reset(std::size_t size);
+
+        RenderDevice& mRenderDevice;
+        std::size_t mAlignment;       ///< Alignment of allocations.
+        ConstantBuffer mBuffer;       ///< Ring buffer.
+        std::size_t mSize;            ///< Size of the ring buffer.
+        std::size_t mHead = 0;        ///< Offset where the next allocation starts looking for space.
+        std::size_t mUsed = 0;        ///< Bytes from the oldest range in use up to the head.
+        std::size_t mUnfenced = 0;    ///< Bytes allocated since the last fence.
+        std::deque<Pending> mPending; ///< Fences guarding the ranges in use, from oldest to newest.
+    };
+} // namespace cubos::core::gl
@@ -162,6 +162,13 @@ namespace cubos::core::io
         /// @brief Swaps the window buffers.
         virtual void swapBuffers() = 0;
 
+        /// @brief Makes the window's render context current on the calling thread, so that the
+        /// render device can be used from it. The context must not be current on another thread.
+        virtual void makeContextCurrent() = 0;
+
+        /// @brief Releases the window's render context from the calling thread.
+        virtual void releaseContext() = 0;
+
         /// @brief Gets the render device associated with this window.
         /// @return Render device associated with this window.
         virtual gl::RenderDevice& renderDevice() const = 0;
@@ -1,5 +1,6 @@
+#include <algorithm>
 #include <array>
-#include <list>
+#include <functional>
 #include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -13,12 +14,13 @@ using namespace cubos::core;
 using namespace cubos::core::gl;
 
 RenderDevice* Debug::renderDevice;
-ConstantBuffer Debug::mvpBuffer;
-ShaderBindingPoint Debug::mvpBindingPoint, Debug::colorBindingPoint;
+std::unique_ptr<UploadRing> Debug::uploads;
+ShaderBindingPoint Debug::instancesBindingPoint;
 ShaderPipeline Debug::pipeline;
 RasterState Debug::fillRasterState, Debug::wireframeRasterState;
-Debug::DebugDrawObject Debug::objCube, Debug::objSphere;
-std::list<Debug::DebugDrawRequest> Debug::requests;
+Debug::DebugDrawObject Debug::objCube, Debug::objSphere, Debug::objLine;
+std::vector<Debug::DebugDrawRequest> Debug::requests;
+std::vector<std::shared_ptr<Debug::ThreadRequests>> Debug::threadRequests;
 std::mutex Debug::debugDrawMutex;
 
 void Debug::DebugDrawObject::clear()
@@ -145,6 +147,28 @@ void Debug::initSphere()
     objSphere.va = renderDevice->createVertexArray(vaDesc);
 }
 
+void Debug::initLine()
+{
+    // Goes from the origin to (0, 0, 1), so that the model matrix of each line only needs its
+    // start in the last column and its direction in the third.
+    float verts[] = {0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F};
+
+    auto vb = renderDevice->createVertexBuffer(sizeof(verts), verts, gl::Usage::Static);
+    objLine.numIndices = 2;
+
+    gl::VertexArrayDesc vaDesc;
+    vaDesc.elementCount = 1;
+    vaDesc.elements[0].name = "position";
+    vaDesc.elements[0].type = gl::Type::Float;
+    vaDesc.elements[0].size = 3;
+    vaDesc.elements[0].buffer.index = 0;
+    vaDesc.elements[0].buffer.offset = 0;
+    vaDesc.elements[0].buffer.stride = 3 * sizeof(float);
+    vaDesc.buffers[0] = vb;
+    vaDesc.shaderPipeline = pipeline;
+    objLine.va = renderDevice->createVertexArray(vaDesc);
+}
+
 void Debug::init(RenderDevice& renderDevice)
 {
     Debug::renderDevice = &renderDevice;
@@ -154,27 +178,37 @@ void Debug::init(RenderDevice& renderDevice)
 
             in vec3 position;
 
-            uniform MVP
+            out vec3 fragColor;
+
+            struct Instance
             {
                 mat4 mvp;
+                vec4 color;
+            };
+
+            // Must match Debug::MaxInstanceCount.
+            layout(std140) uniform Instances
+            {
+                Instance instances[204];
             };
 
             void main()
             {
-                gl_Position = mvp * vec4(position, 1.0f);
+                gl_Position = instances[gl_InstanceID].mvp * vec4(position, 1.0f);
+                fragColor = instances[gl_InstanceID].color.rgb;
             }
         )");
 
     auto ps = renderDevice.createShaderStage(gl::Stage::Pixel, R"(
             #version 330 core
 
-            out vec4 color;
+            in vec3 fragColor;
 
-            uniform vec3 objColor;
+            out vec4 color;
 
             void main()
             {
-                color = vec4(objColor, 1.0f);
+                color = vec4(fragColor, 1.0f);
             }
         )");
 
@@ -182,10 +216,10 @@ void Debug::init(RenderDevice& renderDevice)
 
     initCube();
     initSphere();
+    initLine();
 
-    mvpBuffer = renderDevice.createConstantBuffer(sizeof(glm::mat4), nullptr, gl::Usage::Dynamic);
-    mvpBindingPoint = pipeline->getBindingPoint("MVP");
-    colorBindingPoint = pipeline->getBindingPoint("objColor");
+    uploads = std::make_unique<UploadRing>(renderDevice, 16 * MaxInstanceCount * sizeof(Instance));
+    instancesBindingPoint = pipeline->getBindingPoint("Instances");
 
     RasterStateDesc rsDesc;
     rsDesc.rasterMode = RasterMode::Fill;
@@ -197,84 +231,177 @@ void Debug::init(RenderDevice& renderDevice)
 void Debug::drawLine(glm::vec3 start, glm::vec3 end, bool relative, glm::vec3 color, float time)
 {
     auto vec = relative ? end : end - start;
-    auto transform = glm::translate(start) * glm::translate(vec / 2.0F) *
-                     glm::orientation(glm::normalize(vec), glm::vec3{0.0F, 1.0F, 0.0F}) *
-                     glm::scale(glm::vec3{0.1F, glm::length(vec), 0.1F});
-    debugDrawMutex.lock();
-    requests.push_back(DebugDrawRequest{objCube, fillRasterState, transform, time, color});
-    debugDrawMutex.unlock();
+    glm::mat4 transform{0.0F};
+    transform[2] = glm::vec4(vec, 0.0F);
+    transform[3] = glm::vec4(start, 1.0F);
+    push(DebugDrawRequest{&objLine, fillRasterState, transform, time, color});
 }
 
 void Debug::drawBox(geom::Box box, glm::mat4 transform, glm::vec3 color, float time)
 {
-    debugDrawMutex.lock();
-    requests.push_back(
-        DebugDrawRequest{objCube, fillRasterState, transform * glm::scale(2.0F * box.halfSize), time, color});
-    debugDrawMutex.unlock();
+    push(DebugDrawRequest{&objCube, fillRasterState, transform * glm::scale(2.0F * box.halfSize), time, color});
 }
 
 void Debug::drawWireBox(geom::Box box, glm::mat4 transform, glm::vec3 color, float time)
 {
-    debugDrawMutex.lock();
-    requests.push_back(
-        DebugDrawRequest{objCube, wireframeRasterState, transform * glm::scale(2.0F * box.halfSize), time, color});
-    debugDrawMutex.unlock();
+    push(DebugDrawRequest{&objCube, wireframeRasterState, transform * glm::scale(2.0F * box.halfSize), time, color});
 }
 
 void Debug::drawSphere(glm::vec3 center, float radius, float time, glm::vec3 color)
 {
-    debugDrawMutex.lock();
-    requests.push_back(DebugDrawRequest{objSphere, fillRasterState,
-                                        glm::translate(center) * glm::scale(glm::vec3(radius)), time, color});
-    debugDrawMutex.unlock();
+    push(DebugDrawRequest{&objSphere, fillRasterState, glm::translate(center) * glm::scale(glm::vec3(radius)), time,
+                          color});
 }
 
 void Debug::drawWireSphere(glm::vec3 center, float radius, float time, glm::vec3 color)
 {
-    debugDrawMutex.lock();
-    requests.push_back(DebugDrawRequest{objSphere, wireframeRasterState,
-                                        glm::translate(center) * glm::scale(glm::vec3(radius)), time, color});
-    debugDrawMutex.unlock();
+    push(DebugDrawRequest{&objSphere, wireframeRasterState, glm::translate(center) * glm::scale(glm::vec3(radius)),
+                          time, color});
+}
+
+void Debug::push(const DebugDrawRequest& request)
+{
+    // Each thread registers its buffer once. The registry keeps the buffer alive after the thread
+    // exits, until its requests are flushed.
+    thread_local std::shared_ptr<ThreadRequests> local;
+    if (local == nullptr)
+    {
+        local = std::make_shared<ThreadRequests>();
+        std::lock_guard<std::mutex> lock(debugDrawMutex);
+        threadRequests.push_back(local);
+    }
+
+    std::lock_guard<std::mutex> lock(local->mutex);
+    local->requests.push_back(request);
 }
 
 void Debug::flush(glm::mat4 vp, double deltaT)
 {
-    renderDevice->setShaderPipeline(pipeline);
+    std::lock_guard<std::mutex> lock(debugDrawMutex);
 
-    debugDrawMutex.lock();
-    for (auto it = requests.begin(); it != requests.end();)
+    // Gather the requests recorded by each thread, and forget the threads which have exited.
+    for (const auto& local : threadRequests)
     {
-        renderDevice->setVertexArray(it->obj.va);
-        renderDevice->setIndexBuffer(it->obj.ib);
-        mvpBindingPoint->bind(mvpBuffer);
+        std::lock_guard<std::mutex> localLock(local->mutex);
+        requests.insert(requests.end(), local->requests.begin(), local->requests.end());
+        local->requests.clear();
+    }
+    std::erase_if(threadRequests, [](const auto& local) { return local.use_count() == 1; });
 
-        auto& mvp = *(glm::mat4*)mvpBuffer->map();
-        mvp = vp * it->modelMatrix;
-        mvpBuffer->unmap();
+    if (requests.empty())
+    {
+        return;
+    }
 
-        colorBindingPoint->setConstant(it->color);
+    // Group the requests by object and raster state, and split each group into batches of at most
+    // MaxInstanceCount requests, each drawn with a single instanced draw.
+    std::sort(requests.begin(), requests.end(), [](const DebugDrawRequest& a, const DebugDrawRequest& b) {
+        if (a.obj != b.obj)
+        {
+            return std::less<>{}(a.obj, b.obj);
+        }
+        return std::less<>{}(a.rasterState.get(), b.rasterState.get());
+    });
 
-        renderDevice->setRasterState(it->rasterState);
-        renderDevice->drawTrianglesIndexed(0, it->obj.numIndices);
+    struct Batch
+    {
+        std::size_t first;
+        std::size_t count;
+        std::size_t offset; ///< Offset of the batch's instances in the instance buffer.
+    };
+
+    std::vector<Batch> batches;
+    std::size_t instanceBytes = 0;
+    for (std::size_t first = 0; first < requests.size();)
+    {
+        std::size_t count = 1;
+        while (count < MaxInstanceCount && first + count < requests.size() &&
+               requests[first + count].obj == requests[first].obj &&
+               requests[first + count].rasterState == requests[first].rasterState)
+        {
+            count += 1;
+        }
 
-        it->timeLeft -= deltaT;
+        auto offset = (instanceBytes + uploads->alignment() - 1) / uploads->alignment() * uploads->alignment();
+        batches.push_back({first, count, offset});
+        instanceBytes = offset + count * sizeof(Instance);
+        first += count;
+    }
 
-        auto current = it++;
-        if (current->timeLeft <= 0)
+    // Write the instances of every batch at once. Each batch is bound as a whole uniform block, so
+    // the allocation must extend a whole block past the start of the last batch.
+    auto blockBytes = MaxInstanceCount * sizeof(Instance);
+    auto allocation = uploads->allocate(batches.back().offset + blockBytes);
+    auto* data = static_cast<char*>(UploadRing::map(allocation));
+    for (const auto& batch : batches)
+    {
+        auto* instances = reinterpret_cast<Instance*>(data + batch.offset);
+        for (std::size_t i = 0; i < batch.count; ++i)
         {
-            requests.erase(current);
+            const auto& request = requests[batch.first + i];
+            instances[i] = {vp * request.modelMatrix, glm::vec4(request.color, 1.0F)};
         }
     }
-    debugDrawMutex.unlock();
+    UploadRing::unmap(allocation);
+
+    renderDevice->setShaderPipeline(pipeline);
+    DebugDrawObject* currentObj = nullptr;
+    RasterState currentRasterState = nullptr;
+    for (const auto& batch : batches)
+    {
+        const auto& request = requests[batch.first];
+        if (request.obj != currentObj)
+        {
+            currentObj = request.obj;
+            renderDevice->setVertexArray(currentObj->va);
+            if (currentObj->ib != nullptr)
+            {
+                renderDevice->setIndexBuffer(currentObj->ib);
+            }
+        }
+
+        if (request.rasterState != currentRasterState)
+        {
+            currentRasterState = request.rasterState;
+            renderDevice->setRasterState(currentRasterState);
+        }
+
+        instancesBindingPoint->bind(allocation.buffer, allocation.offset + batch.offset, blockBytes);
+        if (currentObj->ib == nullptr)
+        {
+            renderDevice->drawLinesInstanced(0, currentObj->numIndices, batch.count);
+        }
+        else
+        {
+            renderDevice->drawTrianglesIndexedInstanced(0, currentObj->numIndices, batch.count);
+        }
+    }
+
+    uploads->fence();
+
+    for (auto& request : requests)
+    {
+        request.timeLeft -= deltaT;
+    }
+    std::erase_if(requests, [](const DebugDrawRequest& request) { return request.timeLeft <= 0; });
 }
 
 void Debug::terminate()
 {
-    mvpBuffer = nullptr;
-    mvpBindingPoint = colorBindingPoint = nullptr;
+    uploads = nullptr;
+    instancesBindingPoint = nullptr;
     pipeline = nullptr;
     fillRasterState = wireframeRasterState = nullptr;
     objCube.clear();
     objSphere.clear();
+    objLine.clear();
+
+    // Threads keep their buffers registered, so only their contents are dropped.
+    std::lock_guard<std::mutex> lock(debugDrawMutex);
+    for (const auto& local : threadRequests)
+    {
+        std::lock_guard<std::mutex> localLock(local->mutex);
+        local->requests.clear();
+    }
     requests.clear();
 }
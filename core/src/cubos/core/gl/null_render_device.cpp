@@ -0,0 +1,724 @@
+#include <cstring>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cubos/core/gl/null_render_device.hpp>
+
+using namespace cubos::core::gl;
+
+using Stats = NullRenderDevice::Stats;
+
+class NullFramebuffer : public impl::Framebuffer
+{
+};
+
+class NullRasterState : public impl::RasterState
+{
+};
+
+class NullDepthStencilState : public impl::DepthStencilState
+{
+};
+
+class NullBlendState : public impl::BlendState
+{
+};
+
+class NullSampler : public impl::Sampler
+{
+};
+
+class NullTexture1D : public impl::Texture1D
+{
+public:
+    NullTexture1D(std::shared_ptr<Stats> stats)
+        : stats(std::move(stats))
+    {
+    }
+
+    void update(std::size_t /*x*/, std::size_t /*width*/, const void* /*data*/, std::size_t /*level*/) override
+    {
+        this->stats->textureUpdates += 1;
+    }
+
+    void generateMipmaps() override
+    {
+    }
+
+    std::shared_ptr<Stats> stats;
+};
+
+class NullTexture2D : public impl::Texture2D
+{
+public:
+    NullTexture2D(std::shared_ptr<Stats> stats)
+        : stats(std::move(stats))
+    {
+    }
+
+    void update(std::size_t /*x*/, std::size_t /*y*/, std::size_t /*width*/, std::size_t /*height*/,
+                const void* /*data*/, std::size_t /*level*/) override
+    {
+        this->stats->textureUpdates += 1;
+    }
+
+    void generateMipmaps() override
+    {
+    }
+
+    std::shared_ptr<Stats> stats;
+};
+
+class NullTexture2DArray : public impl::Texture2DArray
+{
+public:
+    NullTexture2DArray(std::shared_ptr<Stats> stats)
+        : stats(std::move(stats))
+    {
+    }
+
+    void update(std::size_t /*x*/, std::size_t /*y*/, std::size_t /*i*/, std::size_t /*width*/,
+                std::size_t /*height*/, const void* /*data*/, std::size_t /*level*/) override
+    {
+        this->stats->textureUpdates += 1;
+    }
+
+    void generateMipmaps() override
+    {
+    }
+
+    std::shared_ptr<Stats> stats;
+};
+
+class NullTexture3D : public impl::Texture3D
+{
+public:
+    NullTexture3D(std::shared_ptr<Stats> stats)
+        : stats(std::move(stats))
+    {
+    }
+
+    void update(std::size_t /*x*/, std::size_t /*y*/, std::size_t /*z*/, std::size_t /*width*/,
+                std::size_t /*height*/, std::size_t /*depth*/, const void* /*data*/, std::size_t /*level*/) override
+    {
+        this->stats->textureUpdates += 1;
+    }
+
+    void generateMipmaps() override
+    {
+    }
+
+    std::shared_ptr<Stats> stats;
+};
+
+class NullCubeMap : public impl::CubeMap
+{
+public:
+    NullCubeMap(std::shared_ptr<Stats> stats)
+        : stats(std::move(stats))
+    {
+    }
+
+    void update(std::size_t /*x*/, std::size_t /*y*/, std::size_t /*width*/, std::size_t /*height*/,
+                const void* /*data*/, CubeFace /*face*/, std::size_t /*level*/) override
+    {
+        this->stats->textureUpdates += 1;
+    }
+
+    void generateMipmaps() override
+    {
+    }
+
+    std::shared_ptr<Stats> stats;
+};
+
+class NullCubeMapArray : public impl::CubeMapArray
+{
+public:
+    NullCubeMapArray(std::shared_ptr<Stats> stats)
+        : stats(std::move(stats))
+    {
+    }
+
+    void update(std::size_t /*x*/, std::size_t /*y*/, std::size_t /*i*/, std::size_t /*width*/,
+                std::size_t /*height*/, const void* /*data*/, CubeFace /*face*/, std::size_t /*level*/) override
+    {
+        this->stats->textureUpdates += 1;
+    }
+
+    void generateMipmaps() override
+    {
+    }
+
+    std::shared_ptr<Stats> stats;
+};
+
+/// Buffer whose contents live in CPU memory, so that they can be mapped.
+class NullBuffer
+{
+public:
+    NullBuffer(std::shared_ptr<Stats> stats, std::size_t size, const void* data)
+        : stats(std::move(stats))
+        , data(size, 0)
+    {
+        if (data != nullptr)
+        {
+            std::memcpy(this->data.data(), data, size);
+            this->stats->bytesUploaded += size;
+        }
+    }
+
+    void* mapRange(std::size_t offset, std::size_t size)
+    {
+        this->stats->maps += 1;
+        this->stats->bytesMapped += size;
+        return this->data.data() + offset;
+    }
+
+    std::shared_ptr<Stats> stats;
+    std::vector<char> data;
+};
+
+class NullConstantBuffer : public impl::ConstantBuffer
+{
+public:
+    NullConstantBuffer(std::shared_ptr<Stats> stats, std::size_t size, const void* data)
+        : buffer(std::move(stats), size, data)
+    {
+    }
+
+    void* map() override
+    {
+        return this->buffer.mapRange(0, this->buffer.data.size());
+    }
+
+    void* mapRange(std::size_t offset, std::size_t size, bool /*discard*/) override
+    {
+        return this->buffer.mapRange(offset, size);
+    }
+
+    void unmap() override
+    {
+    }
+
+    NullBuffer buffer;
+};
+
+class NullIndexBuffer : public impl::IndexBuffer
+{
+public:
+    NullIndexBuffer(std::shared_ptr<Stats> stats, std::size_t size, const void* data)
+        : buffer(std::move(stats), size, data)
+    {
+    }
+
+    void* map() override
+    {
+        return this->buffer.mapRange(0, this->buffer.data.size());
+    }
+
+    void unmap() override
+    {
+    }
+
+    NullBuffer buffer;
+};
+
+class NullVertexBuffer : public impl::VertexBuffer
+{
+public:
+    NullVertexBuffer(std::shared_ptr<Stats> stats, std::size_t size, const void* data)
+        : buffer(std::move(stats), size, data)
+    {
+    }
+
+    void* map() override
+    {
+        return this->buffer.mapRange(0, this->buffer.data.size());
+    }
+
+    void unmap() override
+    {
+    }
+
+    NullBuffer buffer;
+};
+
+class NullVertexArray : public impl::VertexArray
+{
+};
+
+class NullShaderStage : public impl::ShaderStage
+{
+public:
+    NullShaderStage(Stage type)
+        : type(type)
+    {
+    }
+
+    Stage getType() override
+    {
+        return this->type;
+    }
+
+    Stage type;
+};
+
+class NullShaderBindingPoint : public impl::ShaderBindingPoint
+{
+public:
+    NullShaderBindingPoint(std::shared_ptr<Stats> stats, std::string name)
+        : stats(std::move(stats))
+        , name(std::move(name))
+    {
+    }
+
+    void bind(Sampler /*sampler*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(Texture1D /*tex*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(Texture2D /*tex*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(Texture2DArray /*tex*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(Texture3D /*tex*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(CubeMap /*cubeMap*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(CubeMapArray /*cubeMap*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(ConstantBuffer /*cb*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(ConstantBuffer /*cb*/, std::size_t /*offset*/, std::size_t /*size*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void bind(Texture2D /*tex*/, int /*level*/, Access /*access*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::vec2 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::vec3 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::vec4 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::ivec2 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::ivec3 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::ivec4 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::uvec2 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::uvec3 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::uvec4 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(glm::mat4 /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(float /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(int /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    void setConstant(unsigned int /*val*/) override
+    {
+        this->stats->bindings += 1;
+    }
+
+    bool queryConstantBufferStructure(ConstantBufferStructure* /*structure*/) override
+    {
+        // Shaders are never compiled, so the layout of their constant buffers is unknown.
+        return false;
+    }
+
+    std::shared_ptr<Stats> stats;
+    std::string name;
+};
+
+class NullFence : public impl::Fence
+{
+public:
+    bool signaled() override
+    {
+        return true;
+    }
+
+    void wait() override
+    {
+    }
+};
+
+class NullShaderPipeline : public impl::ShaderPipeline
+{
+public:
+    NullShaderPipeline(std::shared_ptr<Stats> stats)
+        : stats(std::move(stats))
+    {
+    }
+
+    ShaderBindingPoint getBindingPoint(const char* name) override
+    {
+        // Search for already existing binding point.
+        for (auto& bp : this->bps)
+        {
+            if (bp.name == name)
+            {
+                return &bp;
+            }
+        }
+
+        // As shaders are never compiled, every name is accepted.
+        this->bps.emplace_back(this->stats, name);
+        return &this->bps.back();
+    }
+
+    std::shared_ptr<Stats> stats;
+    std::list<NullShaderBindingPoint> bps;
+};
+
+NullRenderDevice::NullRenderDevice()
+    : mStats(std::make_shared<Stats>())
+{
+}
+
+const Stats& NullRenderDevice::stats() const
+{
+    return *mStats;
+}
+
+void NullRenderDevice::resetStats()
+{
+    *mStats = Stats{};
+}
+
+Framebuffer NullRenderDevice::createFramebuffer(const FramebufferDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullFramebuffer>();
+}
+
+void NullRenderDevice::setFramebuffer(Framebuffer /*fb*/)
+{
+    mStats->stateChanges += 1;
+}
+
+RasterState NullRenderDevice::createRasterState(const RasterStateDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullRasterState>();
+}
+
+void NullRenderDevice::setRasterState(RasterState /*rs*/)
+{
+    mStats->stateChanges += 1;
+}
+
+DepthStencilState NullRenderDevice::createDepthStencilState(const DepthStencilStateDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullDepthStencilState>();
+}
+
+void NullRenderDevice::setDepthStencilState(DepthStencilState /*dss*/)
+{
+    mStats->stateChanges += 1;
+}
+
+BlendState NullRenderDevice::createBlendState(const BlendStateDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullBlendState>();
+}
+
+void NullRenderDevice::setBlendState(BlendState /*bs*/)
+{
+    mStats->stateChanges += 1;
+}
+
+Sampler NullRenderDevice::createSampler(const SamplerDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullSampler>();
+}
+
+Texture1D NullRenderDevice::createTexture1D(const Texture1DDesc& desc)
+{
+    mStats->resources += 1;
+    auto tex = std::make_shared<NullTexture1D>(mStats);
+    if (desc.data[0] != nullptr)
+    {
+        mStats->textureUpdates += 1;
+    }
+    return tex;
+}
+
+Texture2D NullRenderDevice::createTexture2D(const Texture2DDesc& desc)
+{
+    mStats->resources += 1;
+    auto tex = std::make_shared<NullTexture2D>(mStats);
+    if (desc.data[0] != nullptr)
+    {
+        mStats->textureUpdates += 1;
+    }
+    return tex;
+}
+
+Texture2DArray NullRenderDevice::createTexture2DArray(const Texture2DArrayDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullTexture2DArray>(mStats);
+}
+
+Texture3D NullRenderDevice::createTexture3D(const Texture3DDesc& desc)
+{
+    mStats->resources += 1;
+    auto tex = std::make_shared<NullTexture3D>(mStats);
+    if (desc.data[0] != nullptr)
+    {
+        mStats->textureUpdates += 1;
+    }
+    return tex;
+}
+
+CubeMap NullRenderDevice::createCubeMap(const CubeMapDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullCubeMap>(mStats);
+}
+
+CubeMapArray NullRenderDevice::createCubeMapArray(const CubeMapArrayDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullCubeMapArray>(mStats);
+}
+
+ConstantBuffer NullRenderDevice::createConstantBuffer(std::size_t size, const void* data, Usage /*usage*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullConstantBuffer>(mStats, size, data);
+}
+
+IndexBuffer NullRenderDevice::createIndexBuffer(std::size_t size, const void* data, IndexFormat /*format*/,
+                                                Usage /*usage*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullIndexBuffer>(mStats, size, data);
+}
+
+void NullRenderDevice::setIndexBuffer(IndexBuffer /*ib*/)
+{
+    mStats->stateChanges += 1;
+}
+
+VertexBuffer NullRenderDevice::createVertexBuffer(std::size_t size, const void* data, Usage /*usage*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullVertexBuffer>(mStats, size, data);
+}
+
+VertexArray NullRenderDevice::createVertexArray(const VertexArrayDesc& /*desc*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullVertexArray>();
+}
+
+void NullRenderDevice::setVertexArray(VertexArray /*va*/)
+{
+    mStats->stateChanges += 1;
+}
+
+ShaderStage NullRenderDevice::createShaderStage(Stage stage, const char* /*src*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullShaderStage>(stage);
+}
+
+ShaderPipeline NullRenderDevice::createShaderPipeline(ShaderStage /*vs*/, ShaderStage /*ps*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullShaderPipeline>(mStats);
+}
+
+ShaderPipeline NullRenderDevice::createShaderPipeline(ShaderStage /*vs*/, ShaderStage /*gs*/, ShaderStage /*ps*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullShaderPipeline>(mStats);
+}
+
+ShaderPipeline NullRenderDevice::createShaderPipeline(ShaderStage /*cs*/)
+{
+    mStats->resources += 1;
+    return std::make_shared<NullShaderPipeline>(mStats);
+}
+
+void NullRenderDevice::setShaderPipeline(ShaderPipeline /*pipeline*/)
+{
+    mStats->stateChanges += 1;
+}
+
+void NullRenderDevice::clearColor(float /*r*/, float /*g*/, float /*b*/, float /*a*/)
+{
+    mStats->clears += 1;
+}
+
+void NullRenderDevice::clearTargetColor(std::size_t /*target*/, float /*r*/, float /*g*/, float /*b*/, float /*a*/)
+{
+    mStats->clears += 1;
+}
+
+void NullRenderDevice::clearDepth(float /*depth*/)
+{
+    mStats->clears += 1;
+}
+
+void NullRenderDevice::clearStencil(int /*stencil*/)
+{
+    mStats->clears += 1;
+}
+
+void NullRenderDevice::drawTriangles(std::size_t /*offset*/, std::size_t count)
+{
+    this->drawTrianglesInstanced(0, count, 1);
+}
+
+void NullRenderDevice::drawTrianglesIndexed(std::size_t /*offset*/, std::size_t count)
+{
+    this->drawTrianglesIndexedInstanced(0, count, 1);
+}
+
+void NullRenderDevice::drawTrianglesInstanced(std::size_t /*offset*/, std::size_t count, std::size_t instanceCount)
+{
+    mStats->drawCalls += 1;
+    mStats->instances += instanceCount;
+    mStats->elements += count * instanceCount;
+}
+
+void NullRenderDevice::drawTrianglesIndexedInstanced(std::size_t /*offset*/, std::size_t count,
+                                                     std::size_t instanceCount)
+{
+    mStats->drawCalls += 1;
+    mStats->instances += instanceCount;
+    mStats->elements += count * instanceCount;
+}
+
+void NullRenderDevice::drawLines(std::size_t /*offset*/, std::size_t count)
+{
+    this->drawLinesInstanced(0, count, 1);
+}
+
+void NullRenderDevice::drawLinesInstanced(std::size_t /*offset*/, std::size_t count, std::size_t instanceCount)
+{
+    mStats->drawCalls += 1;
+    mStats->instances += instanceCount;
+    mStats->elements += count * instanceCount;
+}
+
+void NullRenderDevice::dispatchCompute(std::size_t /*x*/, std::size_t /*y*/, std::size_t /*z*/)
+{
+    mStats->dispatches += 1;
+}
+
+void NullRenderDevice::memoryBarrier(MemoryBarriers /*barriers*/)
+{
+}
+
+Fence NullRenderDevice::createFence()
+{
+    mStats->resources += 1;
+    return std::make_shared<NullFence>();
+}
+
+void NullRenderDevice::setViewport(int /*x*/, int /*y*/, int /*w*/, int /*h*/)
+{
+    mStats->stateChanges += 1;
+}
+
+void NullRenderDevice::setScissor(int /*x*/, int /*y*/, int /*w*/, int /*h*/)
+{
+    mStats->stateChanges += 1;
+}
+
+int NullRenderDevice::getProperty(Property prop)
+{
+    switch (prop)
+    {
+    case Property::MaxAnisotropy:
+        return 16;
+    case Property::ComputeSupported:
+        return 1;
+    case Property::ConstantBufferOffsetAlignment:
+        return 256;
+    default:
+        return -1;
+    }
+}
+
+void NullRenderDevice::setShaderPipelineCache(std::string /*directory*/)
+{
+    // Nothing is ever compiled, so there's nothing to cache.
+}
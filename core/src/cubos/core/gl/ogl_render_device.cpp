@@ -1,9 +1,17 @@
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <list>
 #include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
+#include <fmt/format.h>
 #include <glad/gl.h>
 
 #include <cubos/core/log.hpp>
@@ -460,6 +468,119 @@ static void blendOpToGL(BlendOp blendOp, GLenum& glBlendOp)
     }
 }
 
+/// Hashes bytes with FNV-1a, which, unlike std::hash, is stable between runs.
+static uint64_t hashBytes(const void* data, std::size_t size, uint64_t hash = 14695981039346656037ULL)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/// Hashes the fields which identify a state object, as returned by its key() method.
+template <typename... Ts>
+static std::size_t hashKey(const std::tuple<Ts...>& key)
+{
+    std::size_t hash = 0;
+    std::apply(
+        [&](const auto&... fields) {
+            ((hash ^= std::hash<std::decay_t<decltype(fields)>>{}(fields) + 0x9e3779b9 + (hash << 6) + (hash >> 2)),
+             ...);
+        },
+        key);
+    return hash;
+}
+
+/// Returns a previously created state object equal to the given one, or caches the given one if
+/// there's none, so that identical states are shared and setting them again can be skipped.
+template <typename T, typename Base>
+static std::shared_ptr<Base> deduplicate(std::unordered_multimap<std::size_t, std::weak_ptr<Base>>& cache,
+                                         std::shared_ptr<T> state)
+{
+    auto hash = hashKey(state->key());
+    auto [it, end] = cache.equal_range(hash);
+    while (it != end)
+    {
+        auto cached = it->second.lock();
+        if (cached == nullptr)
+        {
+            it = cache.erase(it);
+        }
+        else if (std::static_pointer_cast<T>(cached)->key() == state->key())
+        {
+            return cached;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    cache.emplace(hash, state);
+    return state;
+}
+
+/// Loads a program from a binary in the pipeline cache.
+/// @param program Program to load into.
+/// @param path Path of the binary.
+/// @return Whether the binary was found and accepted by the driver.
+static bool loadProgramBinary(GLuint program, const std::filesystem::path& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    GLenum format;
+    if (!file.read(reinterpret_cast<char*>(&format), sizeof(format)))
+    {
+        return false;
+    }
+
+    std::vector<char> binary{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+/// Stores the binary of a linked program in the pipeline cache.
+/// @param program Linked program.
+/// @param path Path of the binary.
+static void saveProgramBinary(GLuint program, const std::filesystem::path& path)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    GLenum format;
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    // Write to a temporary file first, so that other instances never read a partial binary.
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file{tmpPath, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(binary.data(), length);
+        if (!file)
+        {
+            CUBOS_WARN("Could not write shader pipeline cache file {}", tmpPath.string());
+            return;
+        }
+    }
+
+    std::error_code err;
+    std::filesystem::rename(tmpPath, path, err);
+    if (err)
+    {
+        CUBOS_WARN("Could not write shader pipeline cache file {}: {}", path.string(), err.message());
+    }
+}
+
 class OGLFramebuffer : public impl::Framebuffer
 {
 public:
@@ -482,6 +603,11 @@ public:
     OGLRasterState() = default;
     ~OGLRasterState() override = default;
 
+    auto key() const
+    {
+        return std::tie(cullEnabled, scissorEnabled, frontFace, cullFace, polygonMode);
+    }
+
     GLboolean cullEnabled;
     GLboolean scissorEnabled;
     GLenum frontFace;
@@ -495,6 +621,14 @@ public:
     OGLDepthStencilState() = default;
     ~OGLDepthStencilState() override = default;
 
+    auto key() const
+    {
+        return std::tie(depthEnabled, depthWriteEnabled, depthNear, depthFar, depthFunc, stencilRef, stencilEnabled,
+                        stencilReadMask, stencilWriteMask, frontStencilFunc, frontFaceStencilFail,
+                        frontFaceStencilPass, frontFaceDepthFail, backStencilFunc, backFaceStencilFail,
+                        backFaceStencilPass, backFaceDepthFail);
+    }
+
     GLboolean depthEnabled;
     GLboolean depthWriteEnabled;
     GLfloat depthNear;
@@ -523,6 +657,11 @@ public:
     OGLBlendState() = default;
     ~OGLBlendState() override = default;
 
+    auto key() const
+    {
+        return std::tie(blendEnabled, srcFactor, dstFactor, blendOp, srcAlphaFactor, dstAlphaFactor, alphaBlendOp);
+    }
+
     GLboolean blendEnabled;
     GLenum srcFactor;
     GLenum dstFactor;
@@ -788,6 +927,15 @@ public:
         return glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY);
     }
 
+    void* mapRange(std::size_t offset, std::size_t size, bool discard) override
+    {
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        access |= discard ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_INVALIDATE_RANGE_BIT;
+        glBindBuffer(GL_UNIFORM_BUFFER, this->id);
+        return glMapBufferRange(GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size),
+                                access);
+    }
+
     void unmap() override
     {
         glUnmapBuffer(GL_UNIFORM_BUFFER);
@@ -878,15 +1026,21 @@ public:
 class OGLShaderStage : public impl::ShaderStage
 {
 public:
-    OGLShaderStage(Stage type, GLuint shader)
+    OGLShaderStage(Stage type, GLenum glType, std::string source, uint64_t hash)
         : type(type)
-        , shader(shader)
+        , glType(glType)
+        , source(std::move(source))
+        , hash(hash)
+        , shader(0)
     {
     }
 
     ~OGLShaderStage() override
     {
-        glDeleteShader(this->shader);
+        if (this->shader != 0)
+        {
+            glDeleteShader(this->shader);
+        }
     }
 
     Stage getType() override
@@ -894,8 +1048,51 @@ public:
         return this->type;
     }
 
+    /// Compiles the stage, if it hasn't been compiled yet.
+    /// @return Whether the stage was compiled successfully.
+    bool compile()
+    {
+        if (this->shader != 0)
+        {
+            return true;
+        }
+
+        // Initialize shader
+        GLuint id = glCreateShader(this->glType);
+        const GLchar* src = this->source.c_str();
+        glShaderSource(id, 1, &src, nullptr);
+        glCompileShader(id);
+
+        // Check for errors
+        GLint success;
+        glGetShaderiv(id, GL_COMPILE_STATUS, &success);
+        if (success == 0)
+        {
+            GLchar infoLog[512];
+            glGetShaderInfoLog(id, sizeof(infoLog), nullptr, infoLog);
+            glDeleteShader(id);
+            CUBOS_ERROR("Could not compile shader: {}", infoLog);
+            return false;
+        }
+
+        // Check for OpenGL errors
+        GLenum glErr = glGetError();
+        if (glErr != 0)
+        {
+            glDeleteShader(id);
+            LOG_GL_ERROR(glErr);
+            return false;
+        }
+
+        this->shader = id;
+        return true;
+    }
+
     Stage type;
-    GLuint shader;
+    GLenum glType;
+    std::string source;
+    uint64_t hash; ///< Hash of the stage's type and source.
+    GLuint shader; ///< Compiled shader, or 0 if it hasn't been compiled yet.
 };
 
 class OGLShaderBindingPoint : public impl::ShaderBindingPoint
@@ -1017,6 +1214,20 @@ public:
         }
     }
 
+    void bind(ConstantBuffer cb, std::size_t offset, std::size_t size) override
+    {
+        if (cb)
+        {
+            glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(this->loc),
+                              std::static_pointer_cast<OGLConstantBuffer>(cb)->id, static_cast<GLintptr>(offset),
+                              static_cast<GLsizeiptr>(size));
+        }
+        else
+        {
+            glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(this->loc), 0);
+        }
+    }
+
     void bind(gl::Texture2D tex, int level, Access access) override
     {
         auto texImpl = std::static_pointer_cast<OGLTexture2D>(tex);
@@ -1115,6 +1326,51 @@ public:
     int loc, tex;
 };
 
+class OGLFence : public impl::Fence
+{
+public:
+    OGLFence(GLsync sync)
+        : sync(sync)
+    {
+    }
+
+    ~OGLFence() override
+    {
+        glDeleteSync(this->sync);
+    }
+
+    bool signaled() override
+    {
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv(this->sync, GL_SYNC_STATUS, 1, nullptr, &status);
+        return status == GL_SIGNALED;
+    }
+
+    void wait() override
+    {
+        // Flush on the first try, as otherwise the fence might never be submitted.
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (true)
+        {
+            GLenum result = glClientWaitSync(this->sync, flags, 1000000);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            {
+                return;
+            }
+
+            if (result == GL_WAIT_FAILED)
+            {
+                CUBOS_ERROR("Failed to wait for fence");
+                return;
+            }
+
+            flags = 0;
+        }
+    }
+
+    GLsync sync;
+};
+
 class OGLShaderPipeline : public impl::ShaderPipeline
 {
 public:
@@ -1230,6 +1486,16 @@ OGLRenderDevice::OGLRenderDevice()
     mDefaultRS = OGLRenderDevice::createRasterState({});
     mDefaultDSS = OGLRenderDevice::createDepthStencilState({});
     mDefaultBS = OGLRenderDevice::createBlendState({});
+
+    // Identify the driver, as program binaries can only be loaded by the driver which created them.
+    mDriverHash = hashBytes(nullptr, 0);
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        if (const auto* str = reinterpret_cast<const char*>(glGetString(name)))
+        {
+            mDriverHash = hashBytes(str, std::strlen(str), mDriverHash);
+        }
+    }
 }
 
 Framebuffer OGLRenderDevice::createFramebuffer(const FramebufferDesc& desc)
@@ -1286,6 +1552,7 @@ Framebuffer OGLRenderDevice::createFramebuffer(const FramebufferDesc& desc)
     GLuint id;
     glGenFramebuffers(1, &id);
     glBindFramebuffer(GL_FRAMEBUFFER, id);
+    mCurrentFb.reset();
 
     // Attach targets
     std::vector<GLenum> drawBuffers;
@@ -1439,6 +1706,12 @@ Framebuffer OGLRenderDevice::createFramebuffer(const FramebufferDesc& desc)
 
 void OGLRenderDevice::setFramebuffer(Framebuffer fb)
 {
+    if (mCurrentFb == fb)
+    {
+        return;
+    }
+    mCurrentFb = fb;
+
     if (fb)
     {
         glBindFramebuffer(GL_FRAMEBUFFER, std::static_pointer_cast<OGLFramebuffer>(fb)->id);
@@ -1457,12 +1730,23 @@ RasterState OGLRenderDevice::createRasterState(const RasterStateDesc& desc)
     faceToGL(desc.cullFace, rs->cullFace);
     windingToGL(desc.frontFace, rs->frontFace);
     rasterModeToGL(desc.rasterMode, rs->polygonMode);
-    return rs;
+    return deduplicate(mRasterStates, rs);
 }
 
 void OGLRenderDevice::setRasterState(RasterState rs)
 {
-    auto rsImpl = std::static_pointer_cast<OGLRasterState>(rs ? rs : mDefaultRS);
+    if (!rs)
+    {
+        rs = mDefaultRS;
+    }
+
+    if (rs == mCurrentRS)
+    {
+        return;
+    }
+    mCurrentRS = rs;
+
+    auto rsImpl = std::static_pointer_cast<OGLRasterState>(rs);
 
     if (rsImpl->cullEnabled == 0U)
     {
@@ -1512,12 +1796,23 @@ DepthStencilState OGLRenderDevice::createDepthStencilState(const DepthStencilSta
     stencilActionToGL(desc.stencil.backFace.pass, dss->backFaceStencilPass);
     stencilActionToGL(desc.stencil.backFace.depthFail, dss->backFaceDepthFail);
 
-    return dss;
+    return deduplicate(mDepthStencilStates, dss);
 }
 
 void OGLRenderDevice::setDepthStencilState(DepthStencilState dss)
 {
-    auto dssImpl = std::static_pointer_cast<OGLDepthStencilState>(dss ? dss : mDefaultDSS);
+    if (!dss)
+    {
+        dss = mDefaultDSS;
+    }
+
+    if (dss == mCurrentDSS)
+    {
+        return;
+    }
+    mCurrentDSS = dss;
+
+    auto dssImpl = std::static_pointer_cast<OGLDepthStencilState>(dss);
 
     if (dssImpl->depthEnabled == 0U)
     {
@@ -1564,12 +1859,23 @@ BlendState OGLRenderDevice::createBlendState(const BlendStateDesc& desc)
     blendFactorToGL(desc.color.dst, bs->dstFactor);
     blendOpToGL(desc.color.op, bs->blendOp);
 
-    return bs;
+    return deduplicate(mBlendStates, bs);
 }
 
 void OGLRenderDevice::setBlendState(BlendState bs)
 {
-    auto bsImpl = std::static_pointer_cast<OGLBlendState>(bs ? bs : mDefaultBS);
+    if (!bs)
+    {
+        bs = mDefaultBS;
+    }
+
+    if (bs == mCurrentBS)
+    {
+        return;
+    }
+    mCurrentBS = bs;
+
+    auto bsImpl = std::static_pointer_cast<OGLBlendState>(bs);
 
     if (bsImpl->blendEnabled == 0U)
     {
@@ -2138,6 +2444,7 @@ VertexArray OGLRenderDevice::createVertexArray(const VertexArrayDesc& desc)
     GLuint id;
     glGenVertexArrays(1, &id);
     glBindVertexArray(id);
+    mCurrentVA = nullptr;
 
     // Link elements
     assert(desc.elementCount <= CUBOS_CORE_GL_MAX_VERTEX_ARRAY_ELEMENT_COUNT);
@@ -2254,6 +2561,12 @@ VertexArray OGLRenderDevice::createVertexArray(const VertexArrayDesc& desc)
 
 void OGLRenderDevice::setVertexArray(VertexArray va)
 {
+    if (va == mCurrentVA)
+    {
+        return;
+    }
+    mCurrentVA = va;
+
     glBindVertexArray(std::static_pointer_cast<OGLVertexArray>(va)->id);
 }
 
@@ -2279,114 +2592,111 @@ ShaderStage OGLRenderDevice::createShaderStage(Stage stage, const char* src)
         return nullptr;
     }
 
-    // Initialize shader
-    GLuint id = glCreateShader(shaderType);
-    glShaderSource(id, 1, (const GLchar* const*)&src, nullptr);
-    glCompileShader(id);
-
-    // Check for errors
-    GLint success;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &success);
-    if (success == 0)
+    // Reuse the stage if one with the same source was already created.
+    auto hash = hashBytes(src, std::strlen(src), hashBytes(&shaderType, sizeof(shaderType)));
+    auto [it, end] = mShaderStages.equal_range(hash);
+    while (it != end)
     {
-        GLchar infoLog[512];
-        glGetShaderInfoLog(id, sizeof(infoLog), nullptr, infoLog);
-        glDeleteShader(id);
-        CUBOS_ERROR("Could not compile shader: {}", infoLog);
-        return nullptr;
+        auto cached = std::static_pointer_cast<OGLShaderStage>(it->second.lock());
+        if (cached == nullptr)
+        {
+            it = mShaderStages.erase(it);
+        }
+        else if (cached->type == stage && cached->source == src)
+        {
+            return cached;
+        }
+        else
+        {
+            ++it;
+        }
     }
 
-    // Check for OpenGL errors
-    GLenum glErr = glGetError();
-    if (glErr != 0)
+    // With the pipeline cache enabled, the stage is only compiled if a pipeline which uses it
+    // isn't in the cache.
+    auto stageImpl = std::make_shared<OGLShaderStage>(stage, shaderType, src, hash);
+    if (mPipelineCacheDir.empty() && !stageImpl->compile())
     {
-        glDeleteShader(id);
-        LOG_GL_ERROR(glErr);
         return nullptr;
     }
 
-    return std::make_shared<OGLShaderStage>(stage, id);
+    mShaderStages.emplace(hash, stageImpl);
+    return stageImpl;
 }
 
 ShaderPipeline OGLRenderDevice::createShaderPipeline(ShaderStage vs, ShaderStage ps)
 {
-    auto vsImpl = std::static_pointer_cast<OGLShaderStage>(vs);
-    auto psImpl = std::static_pointer_cast<OGLShaderStage>(ps);
-
-    // Initialize program
-    auto id = glCreateProgram();
-    glAttachShader(id, vsImpl->shader);
-    glAttachShader(id, psImpl->shader);
-    glLinkProgram(id);
-
-    // Check for linking errors
-    GLint success;
-    glGetProgramiv(id, GL_LINK_STATUS, &success);
-    if (success == 0)
-    {
-        char infoLog[512];
-        glGetProgramInfoLog(id, sizeof(infoLog), nullptr, infoLog);
-        glDeleteProgram(id);
-        CUBOS_ERROR("Could not link program (shader pipeline): {}", infoLog);
-        return nullptr;
-    }
-
-    // Check for OpenGL errors
-    GLenum glErr = glGetError();
-    if (glErr != 0)
+    auto id = this->linkProgram({vs, ps});
+    if (id == 0)
     {
-        glDeleteProgram(id);
-        LOG_GL_ERROR(glErr);
         return nullptr;
     }
 
-    return std::make_shared<OGLShaderPipeline>(vsImpl, psImpl, id);
+    return std::make_shared<OGLShaderPipeline>(vs, ps, id);
 }
 
 ShaderPipeline OGLRenderDevice::createShaderPipeline(ShaderStage vs, ShaderStage gs, ShaderStage ps)
 {
-    auto vsImpl = std::static_pointer_cast<OGLShaderStage>(vs);
-    auto gsImpl = std::static_pointer_cast<OGLShaderStage>(gs);
-    auto psImpl = std::static_pointer_cast<OGLShaderStage>(ps);
-
-    // Initialize program
-    auto id = glCreateProgram();
-    glAttachShader(id, vsImpl->shader);
-    glAttachShader(id, gsImpl->shader);
-    glAttachShader(id, psImpl->shader);
-    glLinkProgram(id);
-
-    // Check for linking errors
-    GLint success;
-    glGetProgramiv(id, GL_LINK_STATUS, &success);
-    if (success == 0)
+    auto id = this->linkProgram({vs, gs, ps});
+    if (id == 0)
     {
-        char infoLog[512];
-        glGetProgramInfoLog(id, sizeof(infoLog), nullptr, infoLog);
-        glDeleteProgram(id);
-        CUBOS_ERROR("Could not link program (shader pipeline): {}", infoLog);
         return nullptr;
     }
 
-    // Check for OpenGL errors
-    GLenum glErr = glGetError();
-    if (glErr != 0)
+    return std::make_shared<OGLShaderPipeline>(vs, gs, ps, id);
+}
+
+ShaderPipeline OGLRenderDevice::createShaderPipeline(ShaderStage cs)
+{
+    auto id = this->linkProgram({cs});
+    if (id == 0)
     {
-        glDeleteProgram(id);
-        LOG_GL_ERROR(glErr);
         return nullptr;
     }
 
-    return std::make_shared<OGLShaderPipeline>(vsImpl, gsImpl, psImpl, id);
+    return std::make_shared<OGLShaderPipeline>(cs, id);
 }
 
-ShaderPipeline OGLRenderDevice::createShaderPipeline(ShaderStage cs)
+unsigned int OGLRenderDevice::linkProgram(std::initializer_list<ShaderStage> stages)
 {
-    auto csImpl = std::static_pointer_cast<OGLShaderStage>(cs);
+    // Programs are identified in the cache by their stages and by the driver.
+    std::filesystem::path cachePath;
+    if (!mPipelineCacheDir.empty())
+    {
+        uint64_t key = mDriverHash;
+        for (const auto& stage : stages)
+        {
+            auto hash = std::static_pointer_cast<OGLShaderStage>(stage)->hash;
+            key = hashBytes(&hash, sizeof(hash), key);
+        }
+        cachePath = std::filesystem::path{mPipelineCacheDir} / fmt::format("{:016x}.bin", key);
+    }
 
-    // Initialize program
     auto id = glCreateProgram();
-    glAttachShader(id, csImpl->shader);
+    if (!cachePath.empty())
+    {
+        if (loadProgramBinary(id, cachePath))
+        {
+            return id;
+        }
+
+        // The binary may be missing, or have been rejected by the driver, e.g. after an update.
+        glDeleteProgram(id);
+        glGetError();
+        id = glCreateProgram();
+        glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    for (const auto& stage : stages)
+    {
+        auto stageImpl = std::static_pointer_cast<OGLShaderStage>(stage);
+        if (!stageImpl->compile())
+        {
+            glDeleteProgram(id);
+            return 0;
+        }
+        glAttachShader(id, stageImpl->shader);
+    }
     glLinkProgram(id);
 
     // Check for linking errors
@@ -2398,7 +2708,7 @@ ShaderPipeline OGLRenderDevice::createShaderPipeline(ShaderStage cs)
         glGetProgramInfoLog(id, sizeof(infoLog), nullptr, infoLog);
         glDeleteProgram(id);
         CUBOS_ERROR("Could not link program (shader pipeline): {}", infoLog);
-        return nullptr;
+        return 0;
     }
 
     // Check for OpenGL errors
@@ -2407,14 +2717,25 @@ ShaderPipeline OGLRenderDevice::createShaderPipeline(ShaderStage cs)
     {
         glDeleteProgram(id);
         LOG_GL_ERROR(glErr);
-        return nullptr;
+        return 0;
+    }
+
+    if (!cachePath.empty())
+    {
+        saveProgramBinary(id, cachePath);
     }
 
-    return std::make_shared<OGLShaderPipeline>(csImpl, id);
+    return id;
 }
 
 void OGLRenderDevice::setShaderPipeline(ShaderPipeline pipeline)
 {
+    if (pipeline == mCurrentPipeline)
+    {
+        return;
+    }
+    mCurrentPipeline = pipeline;
+
     glUseProgram(std::static_pointer_cast<OGLShaderPipeline>(pipeline)->program);
 }
 
@@ -2466,6 +2787,17 @@ void OGLRenderDevice::drawTrianglesIndexedInstanced(std::size_t offset, std::siz
                             static_cast<GLsizei>(instanceCount));
 }
 
+void OGLRenderDevice::drawLines(std::size_t offset, std::size_t count)
+{
+    glDrawArrays(GL_LINES, static_cast<GLint>(offset), static_cast<GLsizei>(count));
+}
+
+void OGLRenderDevice::drawLinesInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount)
+{
+    glDrawArraysInstanced(GL_LINES, static_cast<GLint>(offset), static_cast<GLsizei>(count),
+                          static_cast<GLsizei>(instanceCount));
+}
+
 void OGLRenderDevice::dispatchCompute(std::size_t x, std::size_t y, std::size_t z)
 {
     glDispatchCompute(static_cast<GLuint>(x), static_cast<GLuint>(y), static_cast<GLuint>(z));
@@ -2501,13 +2833,39 @@ void OGLRenderDevice::memoryBarrier(MemoryBarriers barriers)
     glMemoryBarrier(barrier);
 }
 
+Fence OGLRenderDevice::createFence()
+{
+    GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (sync == nullptr)
+    {
+        CUBOS_ERROR("Failed to create fence");
+        return nullptr;
+    }
+
+    return std::make_shared<OGLFence>(sync);
+}
+
 void OGLRenderDevice::setViewport(int x, int y, int w, int h)
 {
+    int viewport[4] = {x, y, w, h};
+    if (std::memcmp(viewport, mCurrentViewport, sizeof(viewport)) == 0)
+    {
+        return;
+    }
+    std::memcpy(mCurrentViewport, viewport, sizeof(viewport));
+
     glViewport(x, y, w, h);
 }
 
 void OGLRenderDevice::setScissor(int x, int y, int w, int h)
 {
+    int scissor[4] = {x, y, w, h};
+    if (std::memcmp(scissor, mCurrentScissor, sizeof(scissor)) == 0)
+    {
+        return;
+    }
+    std::memcpy(mCurrentScissor, scissor, sizeof(scissor));
+
     glScissor(x, y, w, h);
 }
 
@@ -2535,7 +2893,39 @@ int OGLRenderDevice::getProperty(Property prop)
         glGetIntegerv(GL_MINOR_VERSION, &minor);
         return (major >= 4 && minor >= 3) ? 1 : 0;
 
+    case Property::ConstantBufferOffsetAlignment: {
+        GLint alignment;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        return static_cast<int>(alignment);
+    }
+
     default:
         return -1;
     }
 }
+
+void OGLRenderDevice::setShaderPipelineCache(std::string directory)
+{
+    if (!directory.empty())
+    {
+        GLint formats = 0;
+        if (GLAD_GL_ARB_get_program_binary != 0)
+        {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+
+        std::error_code err;
+        if (GLAD_GL_ARB_get_program_binary == 0 || formats == 0)
+        {
+            CUBOS_WARN("Program binaries aren't supported by the driver, shader pipelines won't be cached");
+            directory.clear();
+        }
+        else if (std::filesystem::create_directories(directory, err), err)
+        {
+            CUBOS_WARN("Could not create shader pipeline cache directory {}: {}", directory, err.message());
+            directory.clear();
+        }
+    }
+
+    mPipelineCacheDir = std::move(directory);
+}
@@ -1,10 +1,21 @@
 #pragma once
 
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
 #include <cubos/core/gl/render_device.hpp>
 
 namespace cubos::core::gl
 {
     /// Render device implementation using OpenGL.
+    ///
+    /// Identical state objects and shader stages are only created once, and setting state which
+    /// is already set doesn't reach the driver. Linked shader pipelines may also be cached on disk,
+    /// see @ref setShaderPipelineCache.
+    ///
     /// @see RenderDevice.
     class OGLRenderDevice : public RenderDevice
     {
@@ -45,18 +56,46 @@ namespace cubos::core::gl
         void drawTrianglesIndexed(std::size_t offset, std::size_t count) override;
         void drawTrianglesInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount) override;
         void drawTrianglesIndexedInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount) override;
+        void drawLines(std::size_t offset, std::size_t count) override;
+        void drawLinesInstanced(std::size_t offset, std::size_t count, std::size_t instanceCount) override;
         void dispatchCompute(std::size_t x, std::size_t y, std::size_t z) override;
         void memoryBarrier(MemoryBarriers barriers) override;
+        Fence createFence() override;
         void setViewport(int x, int y, int w, int h) override;
         void setScissor(int x, int y, int w, int h) override;
         int getProperty(Property prop) override;
+        void setShaderPipelineCache(std::string directory) override;
 
     private:
+        /// Links a program from the given stages, or loads it from the pipeline cache.
+        /// @param stages Stages of the program.
+        /// @return Program id, or 0 on failure.
+        unsigned int linkProgram(std::initializer_list<ShaderStage> stages);
+
         int mCurrentIndexFormat;
         std::size_t mCurrentIndexSz;
 
         RasterState mDefaultRS;
         DepthStencilState mDefaultDSS;
         BlendState mDefaultBS;
+
+        // Previously created objects, by the hash of their description, so that identical objects are shared.
+        std::unordered_multimap<std::size_t, std::weak_ptr<impl::RasterState>> mRasterStates;
+        std::unordered_multimap<std::size_t, std::weak_ptr<impl::DepthStencilState>> mDepthStencilStates;
+        std::unordered_multimap<std::size_t, std::weak_ptr<impl::BlendState>> mBlendStates;
+        std::unordered_multimap<uint64_t, std::weak_ptr<impl::ShaderStage>> mShaderStages;
+
+        // Currently set state, used to skip redundant state changes. Null or empty when unknown.
+        std::optional<Framebuffer> mCurrentFb;
+        RasterState mCurrentRS;
+        DepthStencilState mCurrentDSS;
+        BlendState mCurrentBS;
+        VertexArray mCurrentVA;
+        ShaderPipeline mCurrentPipeline;
+        int mCurrentViewport[4] = {0, 0, -1, -1};
+        int mCurrentScissor[4] = {0, 0, -1, -1};
+
+        std::string mPipelineCacheDir; ///< Directory where program binaries are cached, or empty if disabled.
+        uint64_t mDriverHash;          ///< Hash of the driver's identification, as binaries are driver specific.
     };
 } // namespace cubos::core::gl
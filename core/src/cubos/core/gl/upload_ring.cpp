@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstring>
+
+#include <cubos/core/gl/upload_ring.hpp>
+
+using cubos::core::gl::UploadRing;
+
+UploadRing::UploadRing(RenderDevice& renderDevice, std::size_t size)
+    : mRenderDevice(renderDevice)
+{
+    mAlignment =
+        static_cast<std::size_t>(std::max(mRenderDevice.getProperty(Property::ConstantBufferOffsetAlignment), 1));
+    this->reset(std::max<std::size_t>(size, 1));
+}
+
+UploadRing::Allocation UploadRing::allocate(std::size_t size)
+{
+    if (size > mSize)
+    {
+        this->reset(std::max(size, mSize * 2));
+    }
+
+    while (true)
+    {
+        // Skip the padding needed for alignment, and wrap around if the range doesn't fit before
+        // the end of the buffer, counting the skipped bytes as used.
+        auto offset = (mHead + mAlignment - 1) / mAlignment * mAlignment;
+        if (offset + size > mSize)
+        {
+            offset = 0;
+        }
+        auto bytes = (offset >= mHead ? offset - mHead : mSize - mHead + offset) + size;
+
+        if (mUsed + bytes <= mSize)
+        {
+            mHead = offset + size;
+            mUsed += bytes;
+            mUnfenced += bytes;
+            return {mBuffer, offset, size};
+        }
+
+        if (mPending.empty())
+        {
+            // Everything in use was allocated since the last fence, so waiting wouldn't free
+            // anything. Previous allocations keep the old buffer alive.
+            this->reset(mSize * 2);
+            continue;
+        }
+
+        // Free the oldest ranges. Usually their commands have long finished, and this doesn't block.
+        if (mPending.front().fence != nullptr)
+        {
+            mPending.front().fence->wait();
+        }
+        mUsed -= mPending.front().bytes;
+        mPending.pop_front();
+    }
+}
+
+UploadRing::Allocation UploadRing::upload(const void* data, std::size_t size)
+{
+    auto allocation = this->allocate(size);
+    std::memcpy(map(allocation), data, size);
+    unmap(allocation);
+    return allocation;
+}
+
+void* UploadRing::map(const Allocation& allocation)
+{
+    return allocation.buffer->mapRange(allocation.offset, allocation.size, false);
+}
+
+void UploadRing::unmap(const Allocation& allocation)
+{
+    allocation.buffer->unmap();
+}
+
+void UploadRing::fence()
+{
+    if (mUnfenced == 0)
+    {
+        return;
+    }
+
+    mPending.push_back({mRenderDevice.createFence(), mUnfenced});
+    mUnfenced = 0;
+}
+
+std::size_t UploadRing::alignment() const
+{
+    return mAlignment;
+}
+
+std::size_t UploadRing::size() const
+{
+    return mSize;
+}
+
+void UploadRing::reset(std::size_t size)
+{
+    mSize = size;
+    mBuffer = mRenderDevice.createConstantBuffer(mSize, nullptr, Usage::Dynamic);
+    mHead = 0;
+    mUsed = 0;
+    mUnfenced = 0;
+    mPending.clear();
+}
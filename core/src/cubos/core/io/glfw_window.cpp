@@ -127,6 +127,24 @@ void GLFWWindow::swapBuffers()
 #endif
 }
 
+void GLFWWindow::makeContextCurrent()
+{
+#ifdef WITH_GLFW
+    glfwMakeContextCurrent(mHandle);
+#else
+    UNSUPPORTED();
+#endif
+}
+
+void GLFWWindow::releaseContext()
+{
+#ifdef WITH_GLFW
+    glfwMakeContextCurrent(nullptr);
+#else
+    UNSUPPORTED();
+#endif
+}
+
 gl::RenderDevice& GLFWWindow::renderDevice() const
 {
 #ifdef WITH_GLFW
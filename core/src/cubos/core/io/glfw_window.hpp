@@ -26,6 +26,8 @@ namespace cubos::core::io
 
         void pollEvents() override;
         void swapBuffers() override;
+        void makeContextCurrent() override;
+        void releaseContext() override;
         gl::RenderDevice& renderDevice() const override;
         glm::ivec2 size() const override;
         glm::ivec2 framebufferSize() const override;
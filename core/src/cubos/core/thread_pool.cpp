@@ -30,10 +30,16 @@ ThreadPool::ThreadPool(std::size_t numThreads)
                 }
 
                 task();
-                mNumTasks -= 1; // Task has finished executing.
 
-                // Signal that a thread has finished executing a task.
-                mTaskDone.notify_one();
+                {
+                    // Must be changed while holding the lock, otherwise a waiting thread could check the
+                    // counter before the change and only block after the notification.
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mNumTasks -= 1; // Task has finished executing.
+                }
+
+                // Signal that a thread has finished executing a task. There may be several waiters.
+                mTaskDone.notify_all();
             }
         });
     }
@@ -41,7 +47,11 @@ ThreadPool::ThreadPool(std::size_t numThreads)
 
 ThreadPool::~ThreadPool()
 {
-    mStop = true;
+    {
+        // Must be set while holding the lock, otherwise a thread could miss the notification.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStop = true;
+    }
     mNewTask.notify_all();
     for (auto& thread : mThreads)
     {
@@ -0,0 +1,49 @@
+#include <thread>
+
+#include <doctest/doctest.h>
+
+#include <cubos/core/gl/debug.hpp>
+#include <cubos/core/gl/null_render_device.hpp>
+
+using cubos::core::geom::Box;
+using cubos::core::gl::Debug;
+using cubos::core::gl::NullRenderDevice;
+
+TEST_CASE("gl::Debug")
+{
+    NullRenderDevice device{};
+    Debug::init(device);
+
+    // Record requests from two threads at once.
+    auto drawBoxes = [] {
+        for (int i = 0; i < 150; ++i)
+        {
+            Debug::drawWireBox(Box{}, glm::mat4{1.0F});
+            Debug::drawLine(glm::vec3{0.0F}, glm::vec3{1.0F});
+        }
+    };
+    std::thread first{drawBoxes};
+    std::thread second{drawBoxes};
+    first.join();
+    second.join();
+    Debug::drawSphere(glm::vec3{0.0F}, 1.0F, 1.0F);
+
+    // Requests of the same object and raster state are drawn together, in batches of at most
+    // Debug::MaxInstanceCount requests.
+    device.resetStats();
+    Debug::flush(glm::mat4{1.0F}, 0.5);
+    CHECK(device.stats().drawCalls == 5);
+    CHECK(device.stats().instances == 601);
+
+    // Only the sphere is still visible.
+    device.resetStats();
+    Debug::flush(glm::mat4{1.0F}, 0.5);
+    CHECK(device.stats().drawCalls == 1);
+    CHECK(device.stats().instances == 1);
+
+    device.resetStats();
+    Debug::flush(glm::mat4{1.0F}, 0.5);
+    CHECK(device.stats().drawCalls == 0);
+
+    Debug::terminate();
+}
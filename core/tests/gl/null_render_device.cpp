@@ -0,0 +1,59 @@
+#include <cstring>
+
+#include <doctest/doctest.h>
+
+#include <cubos/core/gl/null_render_device.hpp>
+
+using cubos::core::gl::NullRenderDevice;
+using cubos::core::gl::Stage;
+using cubos::core::gl::Usage;
+
+TEST_CASE("gl::NullRenderDevice")
+{
+    NullRenderDevice device{};
+
+    SUBCASE("draws are counted")
+    {
+        device.drawTrianglesIndexed(0, 36);
+        device.drawTrianglesIndexedInstanced(0, 36, 10);
+        CHECK(device.stats().drawCalls == 2);
+        CHECK(device.stats().instances == 11);
+        CHECK(device.stats().elements == 36 * 11);
+
+        device.resetStats();
+        CHECK(device.stats().drawCalls == 0);
+    }
+
+    SUBCASE("buffers can be mapped")
+    {
+        int data[4] = {1, 2, 3, 4};
+        auto cb = device.createConstantBuffer(sizeof(data), data, Usage::Dynamic);
+        CHECK(device.stats().bytesUploaded == sizeof(data));
+
+        int value = 5;
+        std::memcpy(cb->mapRange(sizeof(int), sizeof(int), false), &value, sizeof(int));
+        cb->unmap();
+        int* mapped = static_cast<int*>(cb->map());
+        CHECK(mapped[0] == 1);
+        CHECK(mapped[1] == 5);
+        cb->unmap();
+        CHECK(device.stats().maps == 2);
+        CHECK(device.stats().bytesMapped == sizeof(int) + sizeof(data));
+    }
+
+    SUBCASE("binding points are found and bindings counted")
+    {
+        auto vs = device.createShaderStage(Stage::Vertex, "");
+        auto ps = device.createShaderStage(Stage::Pixel, "");
+        auto pipeline = device.createShaderPipeline(vs, ps);
+        auto bp = pipeline->getBindingPoint("color");
+        REQUIRE(bp != nullptr);
+        CHECK(pipeline->getBindingPoint("color") == bp);
+
+        device.setShaderPipeline(pipeline);
+        bp->setConstant(1.0F);
+        CHECK(device.stats().resources == 3);
+        CHECK(device.stats().stateChanges == 1);
+        CHECK(device.stats().bindings == 1);
+    }
+}
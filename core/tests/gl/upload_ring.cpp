@@ -0,0 +1,48 @@
+#include <cstring>
+
+#include <doctest/doctest.h>
+
+#include <cubos/core/gl/null_render_device.hpp>
+#include <cubos/core/gl/upload_ring.hpp>
+
+using cubos::core::gl::NullRenderDevice;
+using cubos::core::gl::UploadRing;
+
+TEST_CASE("gl::UploadRing")
+{
+    NullRenderDevice device{};
+    UploadRing ring{device, 1024};
+    REQUIRE(ring.alignment() == 256);
+
+    // Fill the ring with four allocations, each one aligned.
+    UploadRing::Allocation allocations[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        int value = i;
+        allocations[i] = ring.upload(&value, sizeof(int));
+        CHECK(allocations[i].offset == static_cast<std::size_t>(i) * 256);
+    }
+
+    SUBCASE("ranges are reused after their fence")
+    {
+        ring.fence();
+        auto allocation = ring.allocate(sizeof(int));
+        CHECK(allocation.offset == 0);
+        CHECK(allocation.buffer == allocations[0].buffer);
+        CHECK(ring.size() == 1024);
+    }
+
+    SUBCASE("the ring grows when the ranges in use haven't been fenced")
+    {
+        auto allocation = ring.allocate(sizeof(int));
+        CHECK(allocation.offset == 0);
+        CHECK(allocation.buffer != allocations[0].buffer);
+        CHECK(ring.size() == 2048);
+
+        // Previous allocations keep their data.
+        int value = 0;
+        std::memcpy(&value, UploadRing::map(allocations[3]), sizeof(int));
+        UploadRing::unmap(allocations[3]);
+        CHECK(value == 3);
+    }
+}
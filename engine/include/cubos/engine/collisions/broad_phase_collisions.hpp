@@ -4,17 +4,33 @@
 
 #pragma once
 
+#include <any>
+#include <cstddef>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include <cubos/core/ecs/entity_manager.hpp>
 
+#include <cubos/engine/collisions/collision_layers.hpp>
+
 using cubos::core::ecs::Entity;
 
 namespace cubos::engine
 {
     /// @brief Resource which stores data used in broad phase collision detection.
+    ///
+    /// Colliders whose AABBs and collision layers stay unchanged for @ref framesToSleep frames
+    /// fall asleep: their markers are moved to separate lists which are only sorted when colliders
+    /// fall asleep, and pairs of sleeping colliders are no longer tested, but are kept in the pair
+    /// cache. Colliders are tested against the other sleeping colliders once, in the frame they
+    /// fall asleep, so that colliders which fall asleep together still find their pairs.
+    /// Colliders wake up as soon as their AABBs or collision layers change. The AABBs of sleeping
+    /// colliders are only recomputed once their world transform changes, so changing only the
+    /// shape of a sleeping collider requires waking it with @ref wake first.
+    ///
     /// @ingroup collisions-plugin
     struct BroadPhaseCollisions
     {
@@ -47,29 +63,84 @@ namespace cubos::engine
             Count ///< Number of collision types.
         };
 
+        /// @brief Persistent data of a pair of colliders which has been a candidate for one or
+        /// more consecutive frames.
+        struct PairData
+        {
+            CollisionType type;     ///< Collision type of the pair.
+            std::size_t firstFrame; ///< Frame in which the pair became a candidate.
+            std::size_t lastFrame;  ///< Last frame in which the pair was a candidate.
+            std::any userData = {}; ///< Data attached to the pair by gameplay or narrow phase systems.
+        };
+
         /// @brief Marker used for sweep and prune.
         struct SweepMarker
         {
-            Entity entity; ///< Entity referenced by the marker.
-            bool isMin;    ///< Whether the marker is a min or max marker.
+            Entity entity;          ///< Entity referenced by the marker.
+            bool isMin;             ///< Whether the marker is a min or max marker.
+            float position;         ///< Position of the marker on its axis, as of the last marker update.
+            CollisionLayers layers; ///< Collision layers of the entity, used to filter pairs during the sweep.
+        };
+
+        /// @brief Motion tracking data of a collider, used to put colliders which stopped moving
+        /// to sleep.
+        struct Motion
+        {
+            glm::vec3 min{INFINITY};    ///< Minimum point of the AABB in the last marker update.
+            glm::vec3 max{-INFINITY};   ///< Maximum point of the AABB in the last marker update.
+            CollisionLayers layers;     ///< Collision layers in the last marker update.
+            glm::mat4 localToWorld{};   ///< World transform of the collider when it fell asleep.
+            std::size_t idleFrames = 0; ///< Number of consecutive updates in which nothing changed.
+            bool isSleeping = false;    ///< Whether the collider is sleeping.
         };
 
-        /// @brief List of ordered sweep markers for each axis. Stores the index of the marker in mMarkers.
+        /// @brief Number of consecutive frames a collider's AABB must stay unchanged for it to
+        /// fall asleep.
+        std::size_t framesToSleep = 60;
+
+        /// @brief List of ordered sweep markers of awake colliders for each axis. Sorted every frame.
         std::vector<SweepMarker> markersPerAxis[3];
 
+        /// @brief List of ordered sweep markers of sleeping colliders for each axis. Only sorted
+        /// when colliders fall asleep.
+        std::vector<SweepMarker> sleepingMarkersPerAxis[3];
+
+        /// @brief Motion tracking data of each collider tracked by sweep and prune.
+        std::unordered_map<Entity, Motion> motions;
+
+        /// @brief Colliders which fell asleep in the last marker update, and which must still be
+        /// tested against the other sleeping colliders in the next sweep.
+        std::unordered_set<Entity> fellAsleep;
+
         /// @brief Maps of overlapping entities for each axis calculated by sweep and prune.
         ///
         /// For each each map, the key is an entity and the value is a list of entities that
         /// overlap with the key. Symmetrical pairs are not stored.
         std::unordered_map<Entity, std::vector<Entity>> sweepOverlapMaps[3];
 
-        /// @brief Set of active entities during sweep for each axis.
-        std::unordered_set<Entity> activePerAxis[3];
+        /// @brief Active awake entities during sweep for each axis, mapped to their collision layers.
+        std::unordered_map<Entity, CollisionLayers> activePerAxis[3];
+
+        /// @brief Active sleeping entities during sweep for each axis, mapped to their collision layers.
+        std::unordered_map<Entity, CollisionLayers> sleepingActivePerAxis[3];
 
         /// @brief Sets of collision candidates for each collision type. The index of the array is
         /// the collision type.
         std::unordered_set<Candidate, CandidateHash> candidatesPerType[static_cast<std::size_t>(CollisionType::Count)];
 
+        /// @brief Pairs which were candidates in the last frame, kept across frames. Keys are
+        /// always in canonical order (see @ref canonical).
+        std::unordered_map<Candidate, PairData, CandidateHash> pairs;
+
+        /// @brief Number of times the pair cache has been updated.
+        std::size_t frame = 0;
+
+        /// @brief Orders the entities of a pair so that the same pair always maps to the same key.
+        /// @param a Entity.
+        /// @param b Other entity.
+        /// @return Candidate with the entity with the lowest index (or generation) first.
+        static Candidate canonical(Entity a, Entity b);
+
         /// @brief Adds an entity to the list of entities tracked by sweep and prune.
         /// @param entity Entity to add.
         void addEntity(Entity entity);
@@ -81,7 +152,24 @@ namespace cubos::engine
         /// @brief Clears the list of entities tracked by sweep and prune.
         void clearEntities();
 
+        /// @brief Moves the markers of an entity to the sleeping markers. The caller must sort
+        /// the sleeping markers afterwards.
+        /// @param entity Entity to put to sleep.
+        void sleep(Entity entity);
+
+        /// @brief Moves the markers of an entity back to the awake markers.
+        /// @param entity Entity to wake up.
+        void wake(Entity entity);
+
+        /// @brief Checks whether an entity is sleeping.
+        /// @param entity Entity.
+        /// @return Whether the entity is tracked and sleeping.
+        bool isSleeping(Entity entity) const;
+
         /// @brief Adds a collision candidate to the list of candidates for a specific collision type.
+        ///
+        /// The candidate is stored in canonical order, so each pair is stored only once.
+        ///
         /// @param type Collision type.
         /// @param candidate Collision candidate.
         void addCandidate(CollisionType type, Candidate candidate);
@@ -93,5 +181,14 @@ namespace cubos::engine
 
         /// @brief Clears the list of collision candidates.
         void clearCandidates();
+
+        /// @brief Gets the persistent data of a pair, if it is currently a candidate.
+        /// @param a Entity.
+        /// @param b Other entity, in any order.
+        /// @return Pair data, or nullptr if the entities aren't a candidate pair.
+        PairData* pair(Entity a, Entity b);
+
+        /// @copydoc pair(Entity, Entity)
+        const PairData* pair(Entity a, Entity b) const;
     };
 } // namespace cubos::engine
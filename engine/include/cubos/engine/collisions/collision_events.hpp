@@ -0,0 +1,34 @@
+/// @file
+/// @brief Events @ref cubos::engine::CollisionStarted and @ref cubos::engine::CollisionEnded.
+/// @ingroup collisions-plugin
+
+#pragma once
+
+#include <cubos/engine/collisions/broad_phase_collisions.hpp>
+
+namespace cubos::engine
+{
+    /// @brief Event sent when two colliders become a broad phase candidate pair.
+    ///
+    /// The entities are in canonical order (see @ref BroadPhaseCollisions::canonical).
+    ///
+    /// @ingroup collisions-plugin
+    struct CollisionStarted
+    {
+        Entity entity;                            ///< First entity of the pair.
+        Entity other;                             ///< Second entity of the pair.
+        BroadPhaseCollisions::CollisionType type; ///< Collision type of the pair.
+    };
+
+    /// @brief Event sent when two colliders stop being a broad phase candidate pair.
+    ///
+    /// The entities are in canonical order (see @ref BroadPhaseCollisions::canonical).
+    ///
+    /// @ingroup collisions-plugin
+    struct CollisionEnded
+    {
+        Entity entity;                            ///< First entity of the pair.
+        Entity other;                             ///< Second entity of the pair.
+        BroadPhaseCollisions::CollisionType type; ///< Collision type of the pair.
+    };
+} // namespace cubos::engine
@@ -0,0 +1,37 @@
+/// @file
+/// @brief Component @ref cubos::engine::CollisionLayers.
+/// @ingroup collisions-plugin
+
+#pragma once
+
+#include <cstdint>
+
+namespace cubos::engine
+{
+    /// @brief Component which filters which colliders an entity may collide with.
+    ///
+    /// Two colliders are only considered for collision if each one's layers intersect the
+    /// other's mask, and if at least one of them isn't static. Colliders without this component
+    /// belong to the first layer, collide with every layer and aren't static.
+    ///
+    /// @ingroup collisions-plugin
+    struct [[cubos::component("cubos/collision_layers", VecStorage)]] CollisionLayers
+    {
+        uint32_t layers = 1;        ///< Bitmask of the layers the collider belongs to.
+        uint32_t mask = 0xFFFFFFFF; ///< Bitmask of the layers the collider collides with.
+        bool isStatic = false;      ///< Whether the collider never moves.
+
+        /// @brief Checks whether this collider may collide with another.
+        /// @param other Layers of the other collider.
+        /// @return Whether the colliders may collide.
+        bool canCollide(const CollisionLayers& other) const
+        {
+            return (!isStatic || !other.isStatic) && (layers & other.mask) != 0 && (other.layers & mask) != 0;
+        }
+
+        /// @brief Compares with other layers.
+        /// @param other Other layers.
+        /// @return Whether both are equal.
+        bool operator==(const CollisionLayers& other) const = default;
+    };
+} // namespace cubos::engine
@@ -0,0 +1,155 @@
+/// @file
+/// @brief Resource @ref cubos::engine::CollisionQueries.
+/// @ingroup collisions-plugin
+
+#pragma once
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <cubos/core/ecs/entity_manager.hpp>
+#include <cubos/core/thread_pool.hpp>
+
+#include <cubos/engine/collisions/aabb.hpp>
+
+namespace cubos::engine
+{
+    /// @brief Ray used in collision queries.
+    /// @ingroup collisions-plugin
+    struct Ray
+    {
+        glm::vec3 origin{0.0F};                ///< Origin of the ray.
+        glm::vec3 direction{0.0F, 0.0F, 1.0F}; ///< Normalized direction of the ray.
+        float maxDistance = INFINITY;          ///< Maximum distance at which hits are reported.
+    };
+
+    /// @brief Result of a successful ray or shape cast.
+    /// @ingroup collisions-plugin
+    struct RaycastHit
+    {
+        core::ecs::Entity entity; ///< Entity which was hit.
+        float distance;           ///< Distance along the ray to the hit.
+        glm::vec3 point;          ///< World position of the hit. For sphere sweeps, the center of the sphere.
+        glm::vec3 normal;         ///< World normal of the surface which was hit.
+    };
+
+    /// @brief Resource which allows querying the colliders of the world, such as casting rays.
+    ///
+    /// Holds a snapshot of the box, capsule and plane colliders taken every frame, ordered by
+    /// the X axis sweep markers of the broad phase, which lets casts stop as soon as the
+    /// remaining colliders start past the furthest point the cast can reach.
+    ///
+    /// Simplex colliders are not supported yet and are ignored by every query.
+    ///
+    /// @ingroup collisions-plugin
+    class CollisionQueries
+    {
+    public:
+        /// @brief Clears the snapshot.
+        void clear();
+
+        /// @brief Adds a box collider to the snapshot. Must be called in sweep marker order.
+        /// @param entity Entity.
+        /// @param aabb World space AABB of the collider.
+        /// @param transform Collider to world transform.
+        /// @param halfSize Half size of the box.
+        void addBox(core::ecs::Entity entity, const ColliderAABB& aabb, const glm::mat4& transform,
+                    const glm::vec3& halfSize);
+
+        /// @brief Adds a capsule collider to the snapshot. Must be called in sweep marker order.
+        /// @param entity Entity.
+        /// @param aabb World space AABB of the collider.
+        /// @param transform Collider to world transform.
+        /// @param radius Radius of the capsule.
+        /// @param length Length of the capsule, along its local Y axis.
+        void addCapsule(core::ecs::Entity entity, const ColliderAABB& aabb, const glm::mat4& transform, float radius,
+                        float length);
+
+        /// @brief Adds a plane collider to the snapshot. Must be called in sweep marker order.
+        /// @param entity Entity.
+        /// @param point World position of a point in the plane.
+        /// @param normal World normal of the plane.
+        void addPlane(core::ecs::Entity entity, const glm::vec3& point, const glm::vec3& normal);
+
+        /// @brief Casts a ray and finds the closest collider it hits.
+        /// @param ray Ray.
+        /// @return Closest hit, if any.
+        std::optional<RaycastHit> raycast(const Ray& ray) const;
+
+        /// @brief Casts many rays at once, in packets of four rays which are traversed together,
+        /// splitting the packets among the threads of the given pool.
+        ///
+        /// Coherent rays, such as rays with close origins, should be placed next to each other
+        /// in @p rays, as packets are formed from consecutive rays.
+        ///
+        /// @param pool Thread pool used to split the work.
+        /// @param rays Rays to cast.
+        /// @return Closest hit of each ray, in the same order as @p rays.
+        std::vector<std::optional<RaycastHit>> raycastBatch(core::ThreadPool& pool, std::span<const Ray> rays) const;
+
+        /// @brief Finds the colliders which overlap a world aligned box.
+        ///
+        /// Boxes and planes are tested exactly, while capsules are tested by their AABB.
+        ///
+        /// @param center Center of the box.
+        /// @param halfSize Half size of the box.
+        /// @return Entities of the colliders which overlap the box.
+        std::vector<core::ecs::Entity> overlapBox(const glm::vec3& center, const glm::vec3& halfSize) const;
+
+        /// @brief Sweeps a sphere along a ray and finds the closest collider it hits.
+        ///
+        /// Capsules and planes are tested exactly. Boxes are inflated by the radius, so hits near
+        /// their edges and corners may be reported slightly early.
+        ///
+        /// @param ray Path of the center of the sphere.
+        /// @param radius Radius of the sphere.
+        /// @return Closest hit, if any.
+        std::optional<RaycastHit> sweepSphere(const Ray& ray, float radius) const;
+
+    private:
+        /// @brief Shape of a collider in the snapshot.
+        enum class Shape
+        {
+            Box,
+            Capsule,
+            Plane,
+        };
+
+        /// @brief Collider in the snapshot.
+        struct Collider
+        {
+            core::ecs::Entity entity; ///< Entity of the collider.
+            Shape shape;              ///< Shape of the collider.
+            ColliderAABB aabb;        ///< World space AABB.
+            glm::mat4 localToWorld;   ///< Collider to world transform. Planes only store a point in it.
+            glm::mat4 worldToLocal;   ///< World to collider transform.
+            glm::vec3 extents;        ///< Box half size, capsule radius and half length, or plane normal.
+        };
+
+        /// @brief Casts a sphere against a single collider.
+        /// @param collider Collider.
+        /// @param ray Ray.
+        /// @param radius Radius of the cast sphere, zero for rays.
+        /// @param maxDistance Maximum distance at which a hit is accepted.
+        /// @param[out] hit Hit, written only if there was a hit.
+        /// @return Whether there was a hit closer than @p maxDistance.
+        static bool cast(const Collider& collider, const Ray& ray, float radius, float maxDistance, RaycastHit& hit);
+
+        /// @brief Casts a sphere against every collider.
+        /// @param ray Ray.
+        /// @param radius Radius of the cast sphere, zero for rays.
+        /// @return Closest hit, if any.
+        std::optional<RaycastHit> castAll(const Ray& ray, float radius) const;
+
+        /// @brief Casts a packet of up to four rays against every collider.
+        /// @param rays Rays.
+        /// @param[out] hits Closest hit of each ray.
+        void castPacket(std::span<const Ray> rays, std::span<std::optional<RaycastHit>> hits) const;
+
+        std::vector<Collider> mColliders; ///< Bounded colliders, ordered by the minimum of their AABB in X.
+        std::vector<Collider> mPlanes;    ///< Plane colliders, which are unbounded.
+    };
+} // namespace cubos::engine
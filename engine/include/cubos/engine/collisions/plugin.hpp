@@ -23,20 +23,26 @@ namespace cubos::engine
     /// - @ref CapsuleCollider - holds the capsule collider data.
     /// - @ref PlaneCollider - holds the plane collider data.
     /// - @ref SimplexCollider - holds the simplex collider data.
+    /// - @ref CollisionLayers - filters which colliders may collide with each other.
     ///
     /// ## Events
+    /// - @ref CollisionStarted - emitted when two colliders start overlapping in the broad phase.
+    /// - @ref CollisionEnded - emitted when two colliders stop overlapping in the broad phase.
     /// - @ref CollisionEvent - (TODO) emitted when a collision occurs.
     /// - @ref TriggerEvent - (TODO) emitted when a trigger is entered or exited.
     ///
     /// ## Resources
     /// - @ref BroadPhaseCollisions - stores broad phase collision data.
+    /// - @ref CollisionQueries - allows casting rays and shapes against the colliders.
     ///
     /// ## Tags
     /// - `cubos.collisions.aabb.missing` - missing aabb colliders are added.
     /// - `cubos.collisions.aabb` - collider aabbs are updated.
     /// - `cubos.collisions.broad.markers` - sweep markers are updated.
     /// - `cubos.collisions.broad.sweep` - sweep is performed.
+    /// - `cubos.collisions.queries` - collider snapshot used by @ref CollisionQueries is updated.
     /// - `cubos.collisions.broad` - broad phase collision detection.
+    /// - `cubos.collisions.broad.pairs` - persistent pair cache is updated and pair events are sent.
     /// - `cubos.collisions` - collisions are resolved.
     ///
     /// ## Dependencies
@@ -121,6 +121,11 @@ namespace cubos::engine
 
     /// @brief Represents the engine itself, and exposes the interface with which the game
     /// developer interacts with. Ties up all the different parts of the engine together.
+    ///
+    /// Besides @ref DeltaTime, @ref ShouldQuit and @ref Arguments, a @ref core::ThreadPool
+    /// resource with one thread per hardware thread is also added, which systems may use to split
+    /// data-parallel work.
+    ///
     /// @ingroup engine
     class Cubos final
     {
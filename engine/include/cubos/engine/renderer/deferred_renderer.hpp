@@ -4,28 +4,44 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #include <cubos/core/gl/render_device.hpp>
+#include <cubos/core/gl/upload_ring.hpp>
+#include <cubos/core/thread_pool.hpp>
 
+#include <cubos/engine/renderer/light_clusters.hpp>
 #include <cubos/engine/renderer/renderer.hpp>
 #include <cubos/engine/renderer/vertex.hpp>
 #include <cubos/engine/settings/settings.hpp>
 
-// TODO: make these defines proper constants (we're using C++!)
-#define CUBOS_DEFERRED_RENDERER_MAX_SPOT_LIGHT_COUNT 128
-#define CUBOS_DEFERRED_RENDERER_MAX_DIRECTIONAL_LIGHT_COUNT 128
-#define CUBOS_DEFERRED_RENDERER_MAX_POINT_LIGHT_COUNT 128
-
 namespace cubos::engine
 {
     /// @brief Renderer implementation which uses deferred rendering.
     ///
-    /// Voxel grids are first triangulated, and then the triangles are uploaded to the GPU.
+    /// Voxel grids are first triangulated, and then the triangles are uploaded to the GPU, with
+    /// their vertices packed as @ref PackedVoxelVertex and 16 bit indices whenever possible.
+    /// Draws of the same grid are batched into instanced draws.
     /// The rendering is done in two passes:
     /// 1. Render the scene to the GBuffer textures: position, normal and material.
     /// 2. Take the GBuffer textures and calculate the color of the pixels with the lighting applied.
     ///
+    /// Spot and point lights are binned into view space clusters with @ref LightClusters, so that
+    /// each pixel is only lit by the lights which may reach it.
+    ///
+    /// SSAO is computed at a lower resolution, set by the `renderer.ssao.downscale` setting,
+    /// and then blurred and upsampled with a depth-aware filter.
+    ///
+    /// When drawing from multiple cameras, the lights are uploaded once, the draw list of each
+    /// camera is culled and sorted in parallel, and every pass only covers the camera's viewport
+    /// of the shared GBuffer.
+    ///
+    /// Grids whose handles are dropped are only destroyed on the next render, so that handles may
+    /// be dropped from threads where the render device can't be used.
+    ///
     /// @ingroup renderer-plugin
     class DeferredRenderer : public BaseRenderer
     {
@@ -40,20 +56,54 @@ namespace cubos::engine
 
         // Implement interface methods.
 
-        RendererGrid upload(const VoxelGrid& grid) override;
-        void setPalette(const VoxelPalette& palette) override;
+        using BaseRenderer::upload;
+        RendererGrid upload(const VoxelMesh& mesh) override;
 
     protected:
         // Implement interface methods.
 
         void onResize(glm::uvec2 size) override;
-        void onRender(const glm::mat4& view, const Viewport& viewport, const Camera& camera, const RendererFrame& frame,
+        void onSetPalette(const VoxelPalette& palette) override;
+        void onRender(std::span<const CameraView> views, const RendererFrame& frame,
                       core::gl::Framebuffer target) override;
 
     private:
+        /// @brief Consecutive sorted draws of the same grid, drawn with a single instanced draw.
+        struct InstanceBatch
+        {
+            std::size_t first;  ///< Index of the first draw in the sorted draw order.
+            std::size_t count;  ///< Number of instances.
+            std::size_t offset; ///< Offset of the model matrices of the instances in their allocation.
+        };
+
+        /// @brief Work of a single camera, prepared in parallel with the other cameras of the frame.
+        struct ViewPass
+        {
+            glm::mat4 v;                                             ///< View matrix.
+            glm::mat4 p;                                             ///< Projection matrix.
+            LightClusters clusters;                                  ///< Lights binned into the camera's clusters.
+            std::vector<uint8_t> visible;                            ///< Whether each draw command may be visible.
+            std::vector<std::pair<uint64_t, std::size_t>> drawOrder; ///< Sort key and index of each visible draw.
+            std::vector<InstanceBatch> batches;                      ///< Instanced draws of the camera.
+            std::size_t instanceBytes;                               ///< Size of the model matrices of every batch.
+            std::size_t instanceOffset;                              ///< Offset of the model matrices in the frame.
+        };
+
+        /// @brief Grids whose handles were dropped, waiting to be destroyed.
+        struct ReleasedGrids
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<impl::RendererGrid>> grids;
+        };
+
         void createSSAOTextures();
         void generateSSAONoise();
 
+        /// @brief Shared with the deleters of the uploaded grids, which may outlive the renderer.
+        std::shared_ptr<ReleasedGrids> mReleasedGrids;
+
+        core::gl::UploadRing mUploads; ///< Holds the constant buffer data uploaded every frame.
+
         // GBuffer.
 
         glm::uvec2 mSize;
@@ -67,10 +117,17 @@ namespace cubos::engine
 
         core::gl::ShaderPipeline mGeometryPipeline;
         core::gl::ShaderBindingPoint mVpBp;
-        core::gl::ConstantBuffer mVpBuffer;
+        core::gl::ShaderBindingPoint mInstancesBp;
+        core::gl::ShaderPipeline mUnpackedGeometryPipeline; ///< Draws meshes too large to be packed.
+        core::gl::ShaderBindingPoint mUnpackedVpBp;
+        core::gl::ShaderBindingPoint mUnpackedInstancesBp;
         core::gl::RasterState mGeometryRasterState;
         core::gl::BlendState mGeometryBlendState;
         core::gl::DepthStencilState mGeometryDepthStencilState;
+        uint32_t mNextGridId = 0;           ///< Identifier of the next uploaded grid, if none is free.
+        std::vector<uint32_t> mFreeGridIds; ///< Identifiers of destroyed grids, to be reused.
+        std::vector<ViewPass> mViewPasses;  ///< Work of each camera of the frame.
+        core::ThreadPool mViewPool;         ///< Prepares the work of each camera in parallel.
 
         // Lighting pass pipeline.
 
@@ -90,7 +147,24 @@ namespace cubos::engine
         core::gl::ShaderBindingPoint mInvPBp;
         core::gl::Sampler mSampler;
         core::gl::Texture2D mPaletteTex;
-        core::gl::ConstantBuffer mLightsBuffer;
+
+        // Light clustering.
+
+        core::gl::ShaderBindingPoint mLightDataBp;
+        core::gl::ShaderBindingPoint mClusterRangesBp;
+        core::gl::ShaderBindingPoint mClusterIndicesBp;
+        core::gl::ShaderBindingPoint mClusterParamsBp;
+        core::gl::ShaderBindingPoint mClusterOffsetBp;
+        core::gl::ShaderBindingPoint mViewBp;
+        core::gl::Texture2D mLightDataTex;
+        core::gl::Texture2D mClusterRangesTex;
+        core::gl::Texture2D mClusterIndicesTex;
+        std::size_t mLightDataTexRows = 0;                ///< Number of rows of the light data texture.
+        std::size_t mClusterRangesTexRows = 0;            ///< Number of rows of the cluster ranges texture.
+        std::size_t mClusterIndicesTexRows = 0;           ///< Number of rows of the cluster indices texture.
+        std::vector<LightClusters::Light> mClusterLights; ///< Local lights of the frame.
+        std::vector<float> mLightTexels;                  ///< Texels of the light data texture.
+        std::vector<float> mClusterTexels;                ///< Texels of the cluster textures.
 
         // Screen quad used for the lighting pass.
 
@@ -99,23 +173,33 @@ namespace cubos::engine
         // SSAO (Screen-Scrape Ambient Occlusion)
 
         bool mSsaoEnabled = false;
-        std::vector<glm::vec3> mSsaoKernel;
+        unsigned int mSsaoDownscale = 2;            ///< How many times smaller the SSAO texture is than the GBuffer.
+        glm::uvec2 mSsaoSize{0};                    ///< Size of the SSAO texture.
+        core::gl::ConstantBuffer mSsaoKernelBuffer; ///< Kernel samples, uploaded once.
 
         core::gl::Framebuffer mSsaoFb;
         core::gl::Texture2D mSsaoTex;
         core::gl::Texture2D mSsaoNoiseTex;
         core::gl::Sampler mSsaoNoiseSampler;
+        core::gl::Framebuffer mSsaoUpsampleFb;
+        core::gl::Texture2D mSsaoUpsampleTex;
 
         core::gl::ShaderPipeline mSsaoPipeline;
         core::gl::ShaderBindingPoint mSsaoPositionBp;
         core::gl::ShaderBindingPoint mSsaoNormalBp;
         core::gl::ShaderBindingPoint mSsaoNoiseBp;
-        core::gl::ShaderBindingPoint mSsaoSamplesBp;
+        core::gl::ShaderBindingPoint mSsaoKernelBp;
         core::gl::ShaderBindingPoint mSsaoViewBp;
         core::gl::ShaderBindingPoint mSsaoProjectionBp;
         core::gl::ShaderBindingPoint mSsaoScreenSizeBp;
-
-        core::gl::ShaderPipeline mSsaoBlurPipeline;
-        core::gl::ShaderBindingPoint mSsaoBlurTexBp;
+        core::gl::ShaderBindingPoint mSsaoUVScaleBp;
+        core::gl::ShaderBindingPoint mSsaoUVOffsetBp;
+
+        core::gl::ShaderPipeline mSsaoUpsamplePipeline;
+        core::gl::ShaderBindingPoint mSsaoUpsampleInputBp;
+        core::gl::ShaderBindingPoint mSsaoUpsamplePositionBp;
+        core::gl::ShaderBindingPoint mSsaoUpsampleViewBp;
+        core::gl::ShaderBindingPoint mSsaoUpsampleUVScaleBp;
+        core::gl::ShaderBindingPoint mSsaoUpsampleUVOffsetBp;
     };
 } // namespace cubos::engine
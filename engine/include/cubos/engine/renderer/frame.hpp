@@ -33,6 +33,10 @@ namespace cubos::engine
         };
 
         /// @brief Submits a draw command.
+        ///
+        /// The bounding box of the grid is transformed to world space here, so that it is only
+        /// done once, no matter how many cameras the frame is drawn for.
+        ///
         /// @param grid Handle of the grid to draw.
         /// @param modelMat Model matrix of the grid, used for applying transformations.
         void draw(RendererGrid grid, glm::mat4 modelMat);
@@ -68,6 +72,12 @@ namespace cubos::engine
         /// @return Draw commands.
         const std::vector<DrawCmd>& drawCmds() const;
 
+        /// @brief Checks which draw commands may be visible through a camera, by testing the
+        /// bounding boxes of their grids against its frustum.
+        /// @param viewProj View projection matrix of the camera.
+        /// @param[out] visible Set, for each draw command, to 1 if it may be visible, or 0 otherwise.
+        void cull(const glm::mat4& viewProj, std::vector<uint8_t>& visible) const;
+
         /// @brief Gets the ambient light of the scene.
         /// @return Dmbient light.
         const glm::vec3& ambient() const;
@@ -90,9 +100,22 @@ namespace cubos::engine
         const std::vector<std::pair<glm::mat4, PointLight>>& pointLights() const;
 
     private:
+        /// @brief World space bounding boxes of the draw commands, with each coordinate in its
+        /// own array, so that @ref cull can test them in batches.
+        struct Bounds
+        {
+            std::vector<float> centerX;
+            std::vector<float> centerY;
+            std::vector<float> centerZ;
+            std::vector<float> extentX;
+            std::vector<float> extentY;
+            std::vector<float> extentZ;
+        };
+
         glm::vec3 mAmbientColor;
         glm::vec3 mSkyGradient[2];
         std::vector<DrawCmd> mDrawCmds;
+        Bounds mBounds;
         std::vector<std::pair<glm::mat4, SpotLight>> mSpotLights;
         std::vector<std::pair<glm::mat4, DirectionalLight>> mDirectionalLights;
         std::vector<std::pair<glm::mat4, PointLight>> mPointLights;
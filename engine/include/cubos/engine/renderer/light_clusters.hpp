@@ -0,0 +1,89 @@
+/// @file
+/// @brief Class @ref cubos::engine::LightClusters.
+/// @ingroup renderer-plugin
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace cubos::engine
+{
+    /// @brief Bins local lights into a grid of view space clusters, so that the lighting of each
+    /// pixel only needs to consider the lights which may reach its cluster.
+    ///
+    /// The view frustum is split into @ref TilesX by @ref TilesY screen tiles, and into
+    /// @ref Slices depth slices. Slices are spaced exponentially between the near and far planes,
+    /// so that clusters keep roughly the same proportions at every depth.
+    ///
+    /// Each light is only tested against the clusters covered by the screen space bounds of its
+    /// sphere of influence. Spot lights are further tested against the bounding sphere of each
+    /// cluster with their cone.
+    ///
+    /// @ingroup renderer-plugin
+    class LightClusters final
+    {
+    public:
+        static constexpr int TilesX = 16;                      ///< Number of tiles along the screen width.
+        static constexpr int TilesY = 9;                       ///< Number of tiles along the screen height.
+        static constexpr int Slices = 24;                      ///< Number of depth slices.
+        static constexpr int Count = TilesX * TilesY * Slices; ///< Total number of clusters.
+
+        /// @brief Local light to be binned, in world space.
+        struct Light
+        {
+            glm::vec3 position;  ///< Position of the light.
+            float range;         ///< Distance after which the light has no effect.
+            glm::vec3 direction; ///< Direction the spot light points to. Ignored for point lights.
+            float spotCutoff;    ///< Cosine of the spot light's angle, or -1 for point lights.
+        };
+
+        /// @brief Bins lights into the clusters of a camera.
+        /// @param view View matrix of the camera.
+        /// @param projection Symmetric perspective projection matrix of the camera.
+        /// @param zNear Near plane of the projection.
+        /// @param zFar Far plane of the projection.
+        /// @param lights Lights to bin.
+        void build(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                   const std::vector<Light>& lights);
+
+        /// @brief Gets the cluster which contains a point, in the same way as the lighting shader.
+        /// @param uv Screen coordinates of the point, from 0 to 1.
+        /// @param depth View space depth of the point.
+        /// @return Cluster index.
+        std::size_t cluster(glm::vec2 uv, float depth) const;
+
+        /// @brief Gets the parameters used to find the slice of a depth: the near plane, and the
+        /// number of slices divided by the logarithm of the far plane over the near plane.
+        /// @return Slice parameters.
+        glm::vec2 sliceParams() const;
+
+        /// @brief Gets the offset in @ref indices() and the number of lights of each cluster.
+        ///
+        /// Cluster `(x, y, z)` has index `x + y * TilesX + z * TilesX * TilesY`.
+        ///
+        /// @return Light ranges of the clusters.
+        const std::vector<glm::uvec2>& ranges() const;
+
+        /// @brief Gets the indices of the lights of every cluster, one cluster after another.
+        /// @return Light indices.
+        const std::vector<uint32_t>& indices() const;
+
+    private:
+        /// @brief View space bounding box of a cluster, with depth pointing forward.
+        struct Bounds
+        {
+            glm::vec3 min; ///< Minimum corner.
+            glm::vec3 max; ///< Maximum corner.
+        };
+
+        float mZNear = 0.1F;                          ///< Near plane of the last build.
+        float mSliceScale = 1.0F;                     ///< Slices divided by log(zFar / zNear).
+        std::vector<Bounds> mBounds;                  ///< Bounds of each cluster.
+        std::vector<std::vector<uint32_t>> mLightsOf; ///< Lights of each cluster, before compaction.
+        std::vector<glm::uvec2> mRanges;              ///< Light range of each cluster.
+        std::vector<uint32_t> mIndices;               ///< Light indices of every cluster.
+    };
+} // namespace cubos::engine
@@ -0,0 +1,102 @@
+/// @file
+/// @brief Resource @ref cubos::engine::MeshJobs.
+/// @ingroup renderer-plugin
+
+#pragma once
+
+#include <future>
+#include <memory>
+
+#include <cubos/core/thread_pool.hpp>
+
+#include <cubos/engine/renderer/vertex.hpp>
+#include <cubos/engine/voxels/grid.hpp>
+#include <cubos/engine/voxels/palette.hpp>
+
+namespace cubos::engine
+{
+    /// @brief Handle to a mesh being generated by @ref MeshJobs. Invalid if no job was submitted.
+    /// @ingroup renderer-plugin
+    using MeshJob = std::shared_future<VoxelMesh>;
+
+    /// @brief Resource which triangulates voxel grids on worker threads.
+    ///
+    /// Grids are copied when submitted, so they can be freely modified afterwards. Finished meshes
+    /// must still be uploaded to the GPU from the render thread, through
+    /// @ref BaseRenderer::upload(const VoxelMesh&).
+    ///
+    /// Jobs run on their own thread pool, instead of the engine's @ref core::ThreadPool, as waiting
+    /// on that pool would also wait for every pending mesh job.
+    ///
+    /// @ingroup renderer-plugin
+    class MeshJobs final
+    {
+    public:
+        ~MeshJobs() = default;
+
+        /// @brief Constructs with one thread less than the number of hardware threads, so that
+        /// the render thread isn't starved.
+        MeshJobs();
+
+        /// @brief Constructs.
+        /// @param threadCount Number of worker threads.
+        MeshJobs(std::size_t threadCount);
+
+        /// @brief Move constructs.
+        MeshJobs(MeshJobs&&) noexcept = default;
+
+        /// @brief Submits a grid to be triangulated.
+        /// @param grid Grid to triangulate.
+        /// @return Handle to the mesh.
+        MeshJob submit(const VoxelGrid& grid);
+
+        /// @brief Submits a grid to be triangulated, taking ownership of it.
+        /// @param grid Grid to triangulate.
+        /// @return Handle to the mesh.
+        MeshJob submit(VoxelGrid&& grid);
+
+        /// @brief Submits a region of a grid to be triangulated.
+        ///
+        /// Only the region and the voxels around it are copied. Vertex positions are in grid
+        /// coordinates.
+        ///
+        /// @see triangulate(const VoxelGrid&, const glm::uvec3&, const glm::uvec3&, std::vector<VoxelVertex>&,
+        /// std::vector<uint32_t>&)
+        /// @param grid Grid to triangulate.
+        /// @param origin Coordinates of the first voxel of the region.
+        /// @param size Size of the region.
+        /// @return Handle to the mesh.
+        MeshJob submit(const VoxelGrid& grid, const glm::uvec3& origin, const glm::uvec3& size);
+
+        /// @brief Submits a region of a grid to be triangulated, taking ownership of the grid.
+        ///
+        /// Vertex positions are in grid coordinates.
+        ///
+        /// @param grid Grid to triangulate.
+        /// @param origin Coordinates of the first voxel of the region.
+        /// @param size Size of the region.
+        /// @return Handle to the mesh.
+        MeshJob submit(VoxelGrid&& grid, const glm::uvec3& origin, const glm::uvec3& size);
+
+        /// @brief Submits a lower level of detail of a grid to be triangulated.
+        ///
+        /// The grid is downsampled @p level times, through @ref VoxelGrid::downsample, on the
+        /// worker thread. Vertex positions are scaled back to the coordinates of the original grid,
+        /// so that the mesh can be drawn with the same transform.
+        ///
+        /// @param grid Grid to triangulate.
+        /// @param palette Palette of the grid's materials.
+        /// @param level Level of detail, where 0 is the original grid.
+        /// @param minSimilarity Minimum similarity between two materials for them to be merged.
+        /// @return Handle to the mesh.
+        MeshJob submit(const VoxelGrid& grid, const VoxelPalette& palette, unsigned int level, float minSimilarity);
+
+        /// @brief Checks if a job has finished, without blocking.
+        /// @param job Job to check.
+        /// @return Whether the job is valid and its mesh is ready.
+        static bool isReady(const MeshJob& job);
+
+    private:
+        std::unique_ptr<core::ThreadPool> mPool; ///< Threads which run the jobs.
+    };
+} // namespace cubos::engine
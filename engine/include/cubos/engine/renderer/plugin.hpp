@@ -10,6 +10,7 @@
 #pragma once
 
 #include <cubos/engine/assets/plugin.hpp>
+#include <cubos/engine/renderer/mesh_jobs.hpp>
 #include <cubos/engine/renderer/renderer.hpp>
 #include <cubos/engine/voxels/grid.hpp>
 #include <cubos/engine/voxels/palette.hpp>
@@ -22,9 +23,27 @@ namespace cubos::engine
     /// @see Take a look at the @ref examples-engine-renderer example for a demonstration of this
     /// plugin.
     ///
-    /// Renders all entities with the @ref RenderableGrid component, using as cameras entities with
-    /// the @ref Camera component selected by the @ref ActiveCameras resource. Lights are rendered
-    /// using entities with @ref SpotLight, @ref DirectionalLight or @ref PointLight components.
+    /// Renders all entities with the @ref RenderableGrid component and the chunks of the
+    /// @ref VoxelWorld resource, using as cameras entities with the @ref Camera component selected
+    /// by the @ref ActiveCameras resource. Lights are rendered using entities with @ref SpotLight,
+    /// @ref DirectionalLight or @ref PointLight components.
+    ///
+    /// Each chunk of the @ref VoxelWorld is uploaded as its own grid, and only the chunks marked as
+    /// dirty are uploaded again. Chunks are triangulated along with the voxels around them, so the
+    /// faces hidden by neighbouring chunks aren't generated. The world is compacted before
+    /// uploading.
+    ///
+    /// Grids are triangulated asynchronously by the @ref MeshJobs resource, and only uploaded once
+    /// their meshes are ready. Until then, the previous mesh of the grid, if any, keeps being drawn.
+    /// Each region of a @ref RenderableGrid gets its own mesh, and when the grid asset is modified,
+    /// only the regions whose version changed are triangulated again.
+    ///
+    /// Grids far away from the cameras are drawn with a lower level of detail, where each level is
+    /// downsampled by 2x in each dimension with @ref VoxelGrid::downsample, using the palette set
+    /// on the renderer. The level is picked so that each voxel takes about as many pixels on the
+    /// screen as the threshold setting. A level is only triangulated once it is first picked, and
+    /// again when it is picked after the grid was modified. Until its mesh is ready, the grid is
+    /// drawn at full detail.
     ///
     /// @note Entities with the above entities will be ignored if they do not possess
     /// @ref LocalToWorld components.
@@ -34,13 +53,18 @@ namespace cubos::engine
     ///
     /// ## Settings
     /// - `cubos.renderer.ssao.enabled` - whether SSAO is enabled.
+    /// - `renderer.ssao.downscale` - how many times smaller, 1, 2 or 4, the resolution SSAO
+    ///   is computed at is (default: `2`).
     /// - `cubos.renderer.bloom.enabled` - whether bloom is enabled.
+    /// - `cubos.renderer.lod.levels` - number of lower levels of detail of each grid, 0 to disable.
+    /// - `cubos.renderer.lod.threshold` - pixels per voxel below which a lower level of detail is used.
     ///
     /// ## Resources
     /// - @ref Renderer - handle to the renderer.
     /// - @ref RendererFrame - holds the current frame information.
     /// - @ref RendererEnvironment - holds the environment information (ambient light, sky gradient).
     /// - @ref ActiveCameras - holds the entities which represents the active cameras.
+    /// - @ref MeshJobs - triangulates grids on worker threads.
     ///
     /// ## Components
     /// - @ref RenderableGrid - a grid to be rendered.
@@ -53,7 +77,8 @@ namespace cubos::engine
     /// - `cubos.renderer.init` - the renderer is initialized, after `cubos.window.init`.
     ///
     /// ## Tags
-    /// - `cubos.renderer.frame` - frame information is collected, after `cubos.transform.update`.
+    /// - `cubos.renderer.frame` - frame information is collected, after `cubos.transform.update` and
+    ///   `cubos.voxels.compact`.
     /// - `cubos.renderer.draw` - frame is rendered to the window, after `cubos.renderer.frame` and
     ///   before `cubos.window.render`.
     ///
@@ -61,15 +86,32 @@ namespace cubos::engine
     /// - @ref window-plugin
     /// - @ref transform-plugin
     /// - @ref assets-plugin
+    /// - @ref voxels-plugin
+
+    /// @brief Mesh of a region of the grid of a @ref RenderableGrid.
+    /// @ingroup renderer-plugin
+    struct RenderableGridRegion
+    {
+        RendererGrid handle = nullptr;           ///< Handle to the uploaded mesh, or null if there's nothing to draw.
+        MeshJob mesh;                            ///< Mesh being generated for the region, if any.
+        std::shared_future<RendererGrid> upload; ///< Handle being uploaded by the @ref RenderThread, if any.
+        uint64_t version = 0;                    ///< Version of the grid region which was last submitted.
+    };
 
     /// @brief Component which makes a voxel grid be rendered by the renderer plugin.
     /// @note Should be used with @ref LocalToWorld.
     /// @ingroup renderer-plugin
     struct [[cubos::component("cubos/renderable_grid", VecStorage)]] RenderableGrid
     {
-        Asset<VoxelGrid> asset;                          ///< Handle to the grid asset to be rendered.
-        glm::vec3 offset = {0.0F, 0.0F, 0.0F};           ///< Translation applied to the voxel grid before any other.
-        [[cubos::ignore]] RendererGrid handle = nullptr; ///< Handle to the uploaded grid - set automatically.
+        Asset<VoxelGrid> asset;                ///< Handle to the grid asset to be rendered.
+        glm::vec3 offset = {0.0F, 0.0F, 0.0F}; ///< Translation applied to the voxel grid before any other.
+        [[cubos::ignore]] std::vector<RenderableGridRegion> regions; ///< Meshes of each region - set automatically.
+
+        /// @brief Meshes of each lower level of detail, starting at level 1 - set automatically.
+        [[cubos::ignore]] std::vector<RenderableGridRegion> levels;
+
+        [[cubos::ignore]] glm::uvec3 size = {0, 0, 0}; ///< Size of the grid - set automatically.
+        [[cubos::ignore]] uint64_t version = 0;        ///< Latest region version of the grid - set automatically.
     };
 
     /// @brief Resource which identifies the camera entities to be used by the renderer.
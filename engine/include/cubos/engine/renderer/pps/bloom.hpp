@@ -4,8 +4,6 @@
 
 #pragma once
 
-#include <vector>
-
 #include <glm/glm.hpp>
 
 #include <cubos/core/gl/render_device.hpp>
@@ -19,6 +17,9 @@ namespace cubos::engine
     /// Implementation based on the following
     /// [tutorial](https://catlikecoding.com/unity/tutorials/advanced-rendering/bloom).
     ///
+    /// The extraction texture and the mip chain are transient targets, so they're shared with
+    /// the other passes, and the pass is culled while its intensity is zero.
+    ///
     /// @ingroup renderer-plugin
     class PostProcessingBloom : public PostProcessingPass
     {
@@ -62,14 +63,13 @@ namespace cubos::engine
         /// @param intensity Intensity of the bloom effect.
         void setIntensity(float intensity);
 
-        /// @brief Generates the textures used by the pass.
-        void generateTextures();
-
         // Interface methods implementation.
 
         void resize(glm::uvec2 size) override;
+        PostProcessingPassDesc describe() const override;
+        bool enabled() const override;
         void execute(std::map<PostProcessingInput, core::gl::Texture2D>& inputs, core::gl::Texture2D prev,
-                     core::gl::Framebuffer out) const override;
+                     core::gl::Framebuffer out, std::span<const PostProcessingTarget> transients) const override;
 
     private:
         unsigned int mIterations; ///< Number of iterations for downscale/upscale operation
@@ -83,20 +83,16 @@ namespace cubos::engine
         core::gl::BlendState mBlendState;    ///< Blend state required for upscaling process.
 
         // Extraction pipeline
-        core::gl::Framebuffer mExtFb;                       ///< Framebuffer of the extraction step.
         core::gl::ShaderPipeline mExtPipeline;              ///< Shader pipeline of the extraction step.
         core::gl::ShaderBindingPoint mExtInputTexBp;        ///< Input texture binding point.
         core::gl::ShaderBindingPoint mExtThresholdFilterBp; ///< Threshold information binding point.
-        core::gl::Texture2D mExtTex;                        ///< Result texture from extraction step
 
         // Bloom pipeline
-        core::gl::ShaderPipeline mBloomPipeline;          ///< Shader pipeline of the bloom effect.
-        core::gl::ShaderBindingPoint mBloomInputTexBp;    ///< Input texture binding point.
-        core::gl::ShaderBindingPoint mBloomSrcTexBp;      ///< Source texture binding point.
-        core::gl::ShaderBindingPoint mBloomScalingBp;     ///< Texture scaling binding point.
-        core::gl::ShaderBindingPoint mBloomCurrPassBp;    ///< Current pass binding point.
-        core::gl::ShaderBindingPoint mBloomIntensityBp;   ///< Bloom intensity binding point.
-        std::vector<core::gl::Texture2D> mBloomTexBuffer; ///< Texture buffer of the bloom effect.
-        std::vector<core::gl::Framebuffer> mBloomFBs;     ///< Framebuffers of the bloom effect.
+        core::gl::ShaderPipeline mBloomPipeline;        ///< Shader pipeline of the bloom effect.
+        core::gl::ShaderBindingPoint mBloomInputTexBp;  ///< Input texture binding point.
+        core::gl::ShaderBindingPoint mBloomSrcTexBp;    ///< Source texture binding point.
+        core::gl::ShaderBindingPoint mBloomScalingBp;   ///< Texture scaling binding point.
+        core::gl::ShaderBindingPoint mBloomCurrPassBp;  ///< Current pass binding point.
+        core::gl::ShaderBindingPoint mBloomIntensityBp; ///< Bloom intensity binding point.
     };
 } // namespace cubos::engine
@@ -29,7 +29,7 @@ namespace cubos::engine
 
         void resize(glm::uvec2 size) override;
         void execute(std::map<PostProcessingInput, core::gl::Texture2D>& inputs, core::gl::Texture2D prev,
-                     core::gl::Framebuffer out) const override;
+                     core::gl::Framebuffer out, std::span<const PostProcessingTarget> transients) const override;
 
     private:
         glm::uvec2 mSize;                         ///< Size of the window.
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <map>
+#include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -24,12 +26,44 @@ namespace cubos::engine
         Normal,   ///< GBuffer texture with the world normal of the pixels.
     };
 
+    /// @brief Describes a transient target needed by a post processing pass while it executes.
+    /// @ingroup renderer-plugin
+    struct PostProcessingTargetDesc
+    {
+        glm::uvec2 size;                                                       ///< Size of the texture.
+        core::gl::TextureFormat format = core::gl::TextureFormat::RGBA32Float; ///< Format of the texture.
+    };
+
+    /// @brief Transient target lent to a post processing pass while it executes.
+    /// @ingroup renderer-plugin
+    struct PostProcessingTarget
+    {
+        core::gl::Texture2D texture;       ///< Texture of the target.
+        core::gl::Framebuffer framebuffer; ///< Framebuffer which renders to the texture.
+    };
+
+    /// @brief Describes the resources read and needed by a post processing pass.
+    /// @ingroup renderer-plugin
+    struct PostProcessingPassDesc
+    {
+        bool readsPrevious = true;                        ///< Whether the result of the previous pass is read.
+        std::vector<PostProcessingInput> inputs;          ///< Renderer outputs read by the pass.
+        std::vector<PostProcessingInput> outputs;         ///< Inputs written by the pass for later passes.
+        std::vector<PostProcessingTargetDesc> transients; ///< Targets needed by the pass while it executes.
+    };
+
     /// @brief Responsible for managing the post processing passes.
     ///
     /// This class is renderer agnostic. It can be used with any renderer implementation.
     /// Passes are executed in the order they are added, and take as input the output of the
     /// previous pass and the outputs of the renderer.
     ///
+    /// Each pass describes what it reads, which lets the manager cull the passes which are
+    /// disabled, miss one of their inputs, or whose results are never read by a later pass. Passes
+    /// don't own their intermediate textures: the manager lends them from a pool of transient
+    /// targets, which are reused by later passes as soon as a pass is done with them, and only
+    /// created when first needed after a resize.
+    ///
     /// @see PostProcessingPass
     /// @ingroup renderer-plugin
     class PostProcessingManager final
@@ -60,8 +94,8 @@ namespace cubos::engine
         /// @param id ID of the pass.
         void removePass(std::size_t id);
 
-        /// @brief Applies all post processing passes sequentially, and outputs the result to the
-        /// given framebuffer.
+        /// @brief Applies all post processing passes which aren't culled sequentially, and outputs
+        /// the result to the given framebuffer.
         ///
         /// The lighting input must have been provided before calling this function, since it acts as the input for the
         /// first pass.
@@ -73,14 +107,38 @@ namespace cubos::engine
         /// @return Number of passes.
         std::size_t passCount() const;
 
+        /// @brief Gets the number of transient targets in the pool.
+        /// @return Number of pooled targets.
+        std::size_t pooledTargetCount() const;
+
     private:
+        /// @brief Transient target in the pool.
+        struct PooledTarget
+        {
+            PostProcessingTargetDesc desc; ///< Description of the target.
+            PostProcessingTarget target;   ///< Texture and framebuffer of the target.
+            bool lent;                     ///< Whether the target is lent to a pass.
+            bool used;                     ///< Whether the target was lent during the current execution.
+            bool published;                ///< Whether the target was published as an input by a pass.
+        };
+
+        /// @brief Lends a target from the pool, creating it if no free target matches.
+        /// @param desc Description of the target.
+        /// @return Index of the target in the pool.
+        std::size_t acquire(const PostProcessingTargetDesc& desc);
+
         core::gl::RenderDevice& mRenderDevice;                      ///< Render device to use.
         glm::uvec2 mSize;                                           ///< Current size of the window.
         std::map<PostProcessingInput, core::gl::Texture2D> mInputs; ///< Inputs provided to the passes.
         std::map<std::size_t, PostProcessingPass*> mPasses;         ///< Passes present in the manager.
+        std::map<std::size_t, PostProcessingPassDesc> mDescs;       ///< Descriptions of the passes.
         std::size_t mNextId;                                        ///< Next ID to use for a pass.
-        core::gl::Texture2D mIntermediateTex[2];                    ///< Intermediate textures used for the passes.
-        core::gl::Framebuffer mIntermediateFb[2];                   ///< Intermediate framebuffers used for the passes.
+        std::vector<PooledTarget> mPool;                            ///< Pool of transient targets.
+        std::unique_ptr<PostProcessingPass> mCopy;                  ///< Copies the output when all passes are culled.
+        std::vector<std::size_t> mLive;                             ///< Passes which aren't culled, in order.
+        std::vector<std::size_t> mLent;                             ///< Targets lent to the executing pass.
+        std::vector<PostProcessingTarget> mTransients;              ///< Transient targets of the executing pass.
+        std::vector<PostProcessingInput> mPublished;                ///< Inputs published from pooled targets.
     };
 
     // Implementation.
@@ -89,7 +147,9 @@ namespace cubos::engine
     std::size_t PostProcessingManager::addPass()
     {
         std::size_t id = mNextId++;
-        mPasses[id] = new T(mRenderDevice, mSize);
+        auto* pass = new T(mRenderDevice, mSize);
+        mDescs[id] = pass->describe();
+        mPasses[id] = pass;
         return id;
     }
 } // namespace cubos::engine
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <map>
+#include <span>
 
 #include <glm/glm.hpp>
 
@@ -38,17 +39,34 @@ namespace cubos::engine
         /// @param size New size of the window.
         virtual void resize(glm::uvec2 size) = 0;
 
+        /// @brief Describes what the pass reads and the transient targets it needs.
+        ///
+        /// Called when the pass is added to the manager, and after each resize. By default, the
+        /// pass only reads the result of the previous pass.
+        ///
+        /// @return Description of the pass.
+        virtual PostProcessingPassDesc describe() const;
+
+        /// @brief Checks if the pass has any effect this frame. Disabled passes are culled.
+        /// @return Whether the pass is enabled.
+        virtual bool enabled() const;
+
         /// @brief Called each frame.
         ///
         /// The inputs argument is mutable to allow passes to their own inputs for future passes.
         /// This argument is used, for example, to pass the extra outputs of the deferred renderer
-        /// to the post processing passes which might need them.
+        /// to the post processing passes which might need them. Passes which write to it must list
+        /// the inputs they write in @ref PostProcessingPassDesc::outputs, so that they aren't culled.
+        /// Inputs which point to @p prev are kept alive until all passes have executed, and are then
+        /// removed.
         ///
         /// @param inputs Available extra input textures.
         /// @param prev Resulting texture of the previous pass.
         /// @param out Framebuffer where the pass will render to.
+        /// @param transients Targets lent to the pass, in the order of @ref describe(). They must
+        /// not be used after the pass returns, as they may be lent to other passes.
         virtual void execute(std::map<PostProcessingInput, core::gl::Texture2D>& inputs, core::gl::Texture2D prev,
-                             core::gl::Framebuffer out) const = 0;
+                             core::gl::Framebuffer out, std::span<const PostProcessingTarget> transients) const = 0;
 
     protected:
         core::gl::RenderDevice& mRenderDevice; ///< Render device to use.
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <span>
+
 #include <glm/glm.hpp>
 
 #include <cubos/core/gl/render_device.hpp>
@@ -60,6 +62,14 @@ namespace cubos::engine
             glm::ivec2 size;
         };
 
+        /// @brief Camera from which a frame is drawn, and the region of the screen it's drawn to.
+        struct CameraView
+        {
+            glm::mat4 view;    ///< Camera view transform.
+            Viewport viewport; ///< Camera viewport.
+            Camera camera;     ///< Camera to use.
+        };
+
         virtual ~BaseRenderer() = default;
 
         /// @brief Constructs.
@@ -71,20 +81,43 @@ namespace cubos::engine
         /// @brief Deleted copy constructor.
         BaseRenderer(const BaseRenderer&) = delete;
 
-        /// @brief Uploads a grid to the GPU and returns an handle which can be used to draw it.
+        /// @brief Triangulates a grid and uploads it to the GPU, returning an handle which can be
+        /// used to draw it.
+        ///
+        /// Triangulating large grids is slow, so prefer generating their meshes with @ref MeshJobs
+        /// and uploading them with @ref upload(const VoxelMesh&).
+        ///
         /// @param grid Grid to upload.
         /// @return Handle of the grid.
-        virtual RendererGrid upload(const VoxelGrid& grid) = 0;
+        RendererGrid upload(const VoxelGrid& grid);
+
+        /// @brief Uploads the mesh of a grid to the GPU and returns an handle which can be used to
+        /// draw it.
+        /// @param mesh Mesh to upload.
+        /// @return Handle of the grid.
+        virtual RendererGrid upload(const VoxelMesh& mesh) = 0;
 
         /// @brief Sets the current palette of the renderer.
+        ///
+        /// Uses the render device, so, when a @ref RenderThread is running, it must be called
+        /// through @ref RenderThread::call.
+        ///
         /// @param palette Palette to set.
-        virtual void setPalette(const VoxelPalette& palette) = 0;
+        void setPalette(const VoxelPalette& palette);
+
+        /// @brief Gets the current palette of the renderer.
+        /// @return Current palette.
+        const VoxelPalette& palette() const;
 
         /// @brief Resizes the renderer's framebuffers.
         /// @param size New size of the window.
         void resize(glm::uvec2 size);
 
         /// @brief Gets the current size of the renderer's framebuffers.
+        ///
+        /// The renderer plugin resizes the renderer from the @ref RenderThread, so, while it's
+        /// running, the window's framebuffer size should be read instead.
+        ///
         /// @return Current size.
         glm::uvec2 size() const;
 
@@ -99,7 +132,23 @@ namespace cubos::engine
                     const RendererFrame& frame, bool usePostProcessing = true,
                     const core::gl::Framebuffer& target = nullptr);
 
+        /// @brief Draws a frame from multiple cameras, each to its own viewport.
+        ///
+        /// Work which doesn't depend on the camera, such as uploading the lights and applying post
+        /// processing, is only done once, which is cheaper than rendering each camera separately.
+        ///
+        /// @param views Cameras to draw from. Their viewports must not overlap.
+        /// @param frame Frame to draw.
+        /// @param usePostProcessing Whether to use post processing.
+        /// @param target Target framebuffer to draw to.
+        void render(std::span<const CameraView> views, const RendererFrame& frame, bool usePostProcessing = true,
+                    const core::gl::Framebuffer& target = nullptr);
+
         /// @brief Gets a reference to the post processing manager.
+        ///
+        /// Adding or removing passes uses the render device, so, when a @ref RenderThread is
+        /// running, it must be done through @ref RenderThread::call.
+        ///
         /// @return Post processing manager.
         PostProcessingManager& pps();
 
@@ -113,19 +162,24 @@ namespace cubos::engine
         /// @param size New size of the framebuffer.
         virtual void onResize(glm::uvec2 size) = 0;
 
+        /// @brief Called when setPalette() is called.
+        ///
+        /// Renderer implementations should override this function to upload the palette to the GPU.
+        ///
+        /// @param palette New palette.
+        virtual void onSetPalette(const VoxelPalette& palette) = 0;
+
         /// @brief Called when render() is called, before applying post processing effects.
         ///
         /// Renderer implementations should implement this function to draw the frame.
         /// When post processing is enabled, the target framebuffer will be the internal texture
         /// which will be used for post processing.
         ///
-        /// @param view Camera view transform.
-        /// @param viewport Camera viewport.
-        /// @param camera Camera to use.
+        /// @param views Cameras to draw from, each to its own viewport.
         /// @param frame Frame to draw.
         /// @param target Target framebuffer.
-        virtual void onRender(const glm::mat4& view, const Viewport& viewport, const Camera& camera,
-                              const RendererFrame& frame, core::gl::Framebuffer target) = 0;
+        virtual void onRender(std::span<const CameraView> views, const RendererFrame& frame,
+                              core::gl::Framebuffer target) = 0;
 
     private:
         /// @brief Called when the internal texture used for post processing needs to be resized.
@@ -135,6 +189,7 @@ namespace cubos::engine
         core::gl::Framebuffer mFramebuffer; ///< Framebuffer where the frame is drawn.
         core::gl::Texture2D mTexture;       ///< Texture where the frame is drawn.
         glm::uvec2 mSize;
+        VoxelPalette mPalette; ///< Current palette.
     };
 
     /// @brief Namespace to store the abstract types implemented by the renderer implementations.
@@ -146,6 +201,9 @@ namespace cubos::engine
         public:
             virtual ~RendererGrid() = default;
 
+            glm::vec3 min{0.0F}; ///< Minimum corner of the bounding box of the mesh, in object space.
+            glm::vec3 max{0.0F}; ///< Maximum corner of the bounding box of the mesh, in object space.
+
         protected:
             RendererGrid() = default;
         };
@@ -1,9 +1,12 @@
 /// @file
-/// @brief Class @ref cubos::engine::VoxelVertex and function @ref cubos::engine::triangulate.
+/// @brief Classes @ref cubos::engine::VoxelVertex, @ref cubos::engine::PackedVoxelVertex and @ref
+/// cubos::engine::VoxelMesh and function @ref cubos::engine::triangulate.
 /// @ingroup renderer-plugin
 
 #pragma once
 
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include <cubos/core/data/old/deserializer.hpp>
@@ -22,12 +25,69 @@ namespace cubos::engine
         uint16_t material;   ///< Index of the material on the palette.
     };
 
+    /// @brief Voxel vertex packed into 8 bytes, which is how vertices are stored on the GPU.
+    ///
+    /// Normals of voxel faces always point along one of the six axis directions, so they're stored
+    /// as an index: twice the axis, plus one if the normal is negative.
+    ///
+    /// Meshes with coordinates above @ref MaxXY or @ref MaxZ can't be packed, and are uploaded
+    /// with unpacked vertices instead.
+    ///
+    /// @ingroup renderer-plugin
+    struct PackedVoxelVertex
+    {
+        /// @brief Maximum coordinate which can be stored on the X and Y axes.
+        static constexpr uint32_t MaxXY = (1U << 14) - 1;
+
+        /// @brief Maximum coordinate which can be stored on the Z axis.
+        static constexpr uint32_t MaxZ = (1U << 16) - 1;
+
+        uint32_t xyNormal;  ///< X and Y coordinates in 14 bits each, followed by the normal index in 3 bits.
+        uint32_t zMaterial; ///< Z coordinate in the lower 16 bits, material in the upper 16 bits.
+
+        /// @brief Packs a vertex.
+        /// @param vertex Vertex to pack. Its normal must be axis aligned, and its coordinates must
+        /// not be above @ref MaxXY and @ref MaxZ.
+        /// @return Packed vertex.
+        static PackedVoxelVertex pack(const VoxelVertex& vertex);
+
+        /// @brief Unpacks the vertex.
+        /// @return Unpacked vertex.
+        VoxelVertex unpack() const;
+    };
+
+    /// @brief Mesh of a voxel grid in CPU memory, ready to be uploaded to the GPU.
+    /// @ingroup renderer-plugin
+    struct VoxelMesh
+    {
+        std::vector<VoxelVertex> vertices; ///< Vertices of the mesh.
+        std::vector<uint32_t> indices;     ///< Indices of the mesh.
+    };
+
     /// @brief Triangulates a grid of voxels into an indexed mesh.
+    ///
+    /// Only visible faces are generated, and adjacent faces with the same material are greedily
+    /// merged into larger quads.
+    ///
     /// @param grid Grid to triangulate.
     /// @param vertices Vertices of the mesh.
     /// @param indices Indices of the mesh.
     /// @ingroup renderer-plugin
     void triangulate(const VoxelGrid& grid, std::vector<VoxelVertex>& vertices, std::vector<uint32_t>& indices);
+
+    /// @brief Triangulates a box-shaped region of a grid of voxels into an indexed mesh.
+    ///
+    /// Voxels right outside of the region aren't triangulated, but still hide the faces of the
+    /// voxels inside the region which touch them. Vertex positions are in grid coordinates.
+    ///
+    /// @param grid Grid to triangulate.
+    /// @param origin Coordinates of the first voxel of the region.
+    /// @param size Size of the region, which must fit inside the grid.
+    /// @param vertices Vertices of the mesh.
+    /// @param indices Indices of the mesh.
+    /// @ingroup renderer-plugin
+    void triangulate(const VoxelGrid& grid, const glm::uvec3& origin, const glm::uvec3& size,
+                     std::vector<VoxelVertex>& vertices, std::vector<uint32_t>& indices);
 } // namespace cubos::engine
 
 namespace cubos::core::data::old
@@ -0,0 +1,134 @@
+/// @file
+/// @brief Class @ref cubos::engine::CompressedVoxelGrid.
+/// @ingroup voxels-plugin
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <cubos/core/data/old/deserializer.hpp>
+#include <cubos/core/data/old/serializer.hpp>
+
+#include <cubos/engine/voxels/grid.hpp>
+
+namespace cubos::engine
+{
+    class CompressedVoxelGrid;
+} // namespace cubos::engine
+
+namespace cubos::core::data::old
+{
+    void serialize(Serializer& serializer, const engine::CompressedVoxelGrid& grid, const char* name);
+    void deserialize(Deserializer& deserializer, engine::CompressedVoxelGrid& grid);
+} // namespace cubos::core::data::old
+
+namespace cubos::engine
+{
+    /// @brief Represents a voxel object using a 3D grid, compressed to use less memory than a
+    /// @ref VoxelGrid.
+    ///
+    /// The grid is split into bricks of @ref BrickSize voxels in each dimension. Each brick has its
+    /// own palette of the materials used in it, and stores, for each voxel, an index into that
+    /// palette, using as few bits as possible (0, 1, 2, 4, 8 or 16). Since the indices have a
+    /// fixed size, @ref get and @ref set are O(1), with @ref set occasionally having to grow the
+    /// indices of a brick when a new material is added to it.
+    ///
+    /// When serialized, the indices of each brick are also run-length encoded.
+    ///
+    /// @see Each voxel stores a material index to be used with a @ref VoxelPalette.
+    /// @ingroup voxels-plugin
+    class CompressedVoxelGrid final
+    {
+    public:
+        /// @brief Size of a brick in each dimension, in voxels.
+        static constexpr int BrickSize = 8;
+
+        /// @brief Constructs an empty single-voxel grid.
+        CompressedVoxelGrid();
+
+        /// @brief Constructs an empty grid with the given size.
+        /// @param size Size of the grid.
+        CompressedVoxelGrid(const glm::uvec3& size);
+
+        /// @brief Constructs a compressed copy of a dense grid.
+        /// @param grid Dense grid.
+        explicit CompressedVoxelGrid(const VoxelGrid& grid);
+
+        /// @brief Converts the grid back to a dense grid.
+        /// @return Dense grid.
+        VoxelGrid decompress() const;
+
+        /// @brief Gets the size of the grid.
+        /// @return Size of the grid.
+        const glm::uvec3& size() const;
+
+        /// @brief Sets all voxels to 0.
+        void clear();
+
+        /// @brief Sets the material index of a voxel.
+        /// @param position Voxel coordinates.
+        /// @param mat Material index to set.
+        void set(const glm::ivec3& position, uint16_t mat);
+
+        /// @brief Gets the material index of a voxel.
+        /// @param position Voxel coordinates.
+        /// @return Material index of the voxel.
+        uint16_t get(const glm::ivec3& position) const;
+
+        /// @brief Removes materials which are no longer used from the brick palettes, shrinking
+        /// their indices where possible.
+        ///
+        /// @ref set never removes materials from the palettes, so this should be called after
+        /// editing the grid.
+        void compact();
+
+        /// @brief Gets the number of bytes used to store the voxels, excluding fixed overhead.
+        /// @return Number of bytes.
+        std::size_t memoryUsage() const;
+
+    private:
+        friend void core::data::old::serialize(core::data::old::Serializer& /*serializer*/,
+                                               const CompressedVoxelGrid& /*grid*/, const char* /*name*/);
+        friend void core::data::old::deserialize(core::data::old::Deserializer& /*deserializer*/,
+                                                 CompressedVoxelGrid& /*grid*/);
+
+        /// @brief Brick of voxels with its own palette.
+        struct Brick
+        {
+            std::vector<uint16_t> palette{0}; ///< Materials used in the brick.
+            uint8_t bits = 0;                 ///< Number of bits per index.
+            std::vector<uint64_t> words;      ///< Bit-packed palette indices of the voxels.
+
+            /// @brief Gets the palette index of a voxel.
+            /// @param index Voxel index within the brick.
+            /// @return Palette index.
+            uint16_t index(std::size_t index) const;
+
+            /// @brief Sets the palette index of a voxel. Must fit in the current number of bits.
+            /// @param index Voxel index within the brick.
+            /// @param paletteIndex Palette index.
+            void setIndex(std::size_t index, uint16_t paletteIndex);
+
+            /// @brief Changes the number of bits per index, keeping the indices.
+            /// @param newBits New number of bits.
+            void repack(uint8_t newBits);
+        };
+
+        /// @brief Gets the brick and voxel index within it of a voxel.
+        /// @param position Voxel coordinates.
+        /// @param[out] voxel Voxel index within the brick.
+        /// @return Brick index.
+        std::size_t locate(const glm::ivec3& position, std::size_t& voxel) const;
+
+        /// @brief Removes unused materials from the palette of a single brick.
+        /// @param brick Brick index.
+        void compact(std::size_t brick);
+
+        glm::uvec3 mSize;           ///< Size of the grid.
+        glm::uvec3 mBrickCount;     ///< Number of bricks in each dimension.
+        std::vector<Brick> mBricks; ///< Bricks of the grid.
+    };
+} // namespace cubos::engine
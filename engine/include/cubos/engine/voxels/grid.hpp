@@ -26,11 +26,20 @@ namespace cubos::core::data::old
 namespace cubos::engine
 {
     /// @brief Represents a voxel object using a 3D grid.
+    ///
+    /// To allow consumers such as the renderer to only process the parts of the grid which
+    /// changed, the grid is split into regions of @ref RegionSize voxels in each dimension, and
+    /// each region has a version which changes whenever the region or the voxels bordering it are
+    /// modified.
+    ///
     /// @see Each voxel stores a material index to be used with a @ref VoxelPalette.
     /// @ingroup voxels-plugin
     class VoxelGrid final
     {
     public:
+        /// @brief Size of a region in each dimension, in voxels.
+        static constexpr int RegionSize = 32;
+
         ~VoxelGrid() = default;
 
         /// @brief Constructs an empty single-voxel grid.
@@ -77,6 +86,24 @@ namespace cubos::engine
         /// @return Material index of the voxel.
         uint16_t get(const glm::ivec3& position) const;
 
+        /// @brief Gets the material indices of every voxel, for fast read-only access.
+        /// @note The index of a voxel at position `(x, y, z)` is `x + y * size.x + z * size.x * size.y`.
+        /// @return Material indices of the voxels.
+        const std::vector<uint16_t>& indices() const;
+
+        /// @brief Gets the number of regions in each dimension.
+        /// @return Number of regions.
+        glm::uvec3 regionCount() const;
+
+        /// @brief Gets the version of a region.
+        ///
+        /// Versions are unique across all grids: if a region has the same version as before, then
+        /// neither it nor the voxels bordering it changed.
+        ///
+        /// @param region Region coordinates.
+        /// @return Version of the region.
+        uint64_t regionVersion(const glm::uvec3& region) const;
+
         /// @brief Converts the material indices of this grid from one palette to another.
         ///
         /// For each material, it will search for another material in the second palette which is
@@ -88,12 +115,32 @@ namespace cubos::engine
         /// @return Whether the conversion was successful.
         bool convert(const VoxelPalette& src, const VoxelPalette& dst, float minSimilarity);
 
+        /// @brief Replaces the material index of every voxel through a lookup table, giving every
+        /// region a new version once.
+        /// @param mappings New material index for each of the 65536 possible material indices.
+        void remap(const std::vector<uint16_t>& mappings);
+
+        /// @brief Creates a grid with half the size, to be used as a lower level of detail.
+        ///
+        /// Each voxel of the new grid gets the majority material of the 2x2x2 voxels it covers,
+        /// where materials similar enough to each other vote together. To keep thin surfaces from
+        /// disappearing, a voxel only becomes empty if more than half of the voxels it covers are.
+        ///
+        /// @param palette Palette of the grid's materials.
+        /// @param minSimilarity Minimum similarity between two materials for them to vote together.
+        /// @return Downsampled grid, with each dimension rounded up.
+        VoxelGrid downsample(const VoxelPalette& palette, float minSimilarity) const;
+
     private:
         friend void core::data::old::serialize(core::data::old::Serializer& /*serializer*/, const VoxelGrid& /*grid*/,
                                                const char* /*name*/);
         friend void core::data::old::deserialize(core::data::old::Deserializer& /*deserializer*/, VoxelGrid& /*grid*/);
 
-        glm::uvec3 mSize;               ///< Size of the grid.
-        std::vector<uint16_t> mIndices; ///< Indices of the grid.
+        /// @brief Gives every region a new version.
+        void resetVersions();
+
+        glm::uvec3 mSize;                      ///< Size of the grid.
+        std::vector<uint16_t> mIndices;        ///< Indices of the grid.
+        std::vector<uint64_t> mRegionVersions; ///< Version of each region.
     };
 } // namespace cubos::engine
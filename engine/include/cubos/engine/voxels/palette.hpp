@@ -31,6 +31,10 @@ namespace cubos::engine
     /// of storing the whole material per each voxel, we just store a 16-bit
     /// integer.
     ///
+    /// To make @ref find and @ref add fast on large palettes, the materials are kept in a k-d tree
+    /// over their colors. Materials added or changed since the tree was last built are searched
+    /// linearly, until there are enough of them for the tree to be rebuilt.
+    ///
     /// @ingroup voxels-plugin
     class VoxelPalette final
     {
@@ -89,6 +93,33 @@ namespace cubos::engine
         friend void core::data::old::deserialize(core::data::old::Deserializer& /*deserializer*/,
                                                  VoxelPalette& /*palette*/);
 
+        /// @brief Node of the k-d tree used to search for similar materials.
+        struct Node
+        {
+            glm::vec4 color; ///< Color of the material when the tree was built.
+            uint16_t index;  ///< Index of the material (1-based).
+        };
+
+        /// @brief Rebuilds the k-d tree with every material in the palette.
+        void rebuild();
+
+        /// @brief Must be called after a material is set, so that it's no longer searched in the
+        /// k-d tree. Rebuilds the tree if too many materials are outside of it.
+        /// @param index Index of the material (1-based).
+        void changed(uint16_t index);
+
+        /// @brief Searches for a material more similar to the given one than the current best.
+        ///
+        /// When two materials are equally similar, the one with the lowest index is preferred.
+        ///
+        /// @param material Material to compare with.
+        /// @param[in,out] bestI Index of the best material found so far.
+        /// @param[in,out] bestS Similarity of the best material found so far.
+        void search(const VoxelMaterial& material, uint16_t& bestI, float& bestS) const;
+
         std::vector<VoxelMaterial> mMaterials; ///< Materials in the palette.
+        std::vector<Node> mTree;               ///< Implicit k-d tree over the materials it was built with.
+        std::vector<bool> mStale;              ///< Whether each material in the tree was set since it was built.
+        std::vector<uint16_t> mChanged;        ///< Materials in the tree which were set since it was built.
     };
 } // namespace cubos::engine
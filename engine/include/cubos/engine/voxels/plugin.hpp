@@ -15,10 +15,16 @@ namespace cubos::engine
     /// @ingroup engine
     /// @brief Adds grid and palette assets to @b CUBOS.
     ///
+    /// ## Resources
+    /// - @ref VoxelWorld - chunked voxel world.
+    ///
     /// ## Bridges
     /// - @ref BinaryBridge - registered with the `.grd` extension, loads @ref VoxelGrid assets.
     /// - @ref BinaryBridge - registered with the `.pal` extension, loads @ref VoxelPalette assets.
     ///
+    /// ## Tags
+    /// - `cubos.voxels.compact` - chunks of the @ref VoxelWorld which became uniform are compacted.
+    ///
     /// ## Dependencies
     /// - @ref assets-plugin
 
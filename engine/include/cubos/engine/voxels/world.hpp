@@ -0,0 +1,143 @@
+/// @file
+/// @brief Resource @ref cubos::engine::VoxelWorld.
+/// @ingroup voxels-plugin
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <cubos/engine/voxels/grid.hpp>
+
+namespace cubos::engine
+{
+    /// @brief Resource which represents an unbounded voxel world, split into fixed-size chunks.
+    ///
+    /// Only chunks with at least one non-empty voxel are stored, and chunks where every voxel has
+    /// the same material are stored as that single material. Chunks which are modified are marked
+    /// as dirty, so that systems which depend on them, such as the renderer, only have to
+    /// process the chunks which changed. Filling or emptying a voxel on the border of a chunk also
+    /// marks the neighbouring chunk it touches as dirty.
+    ///
+    /// Modified chunks which became uniform are only stored as a single material once the world
+    /// is compacted, which @ref paste and @ref convert do before returning, and the voxels plugin
+    /// does every frame.
+    ///
+    /// @see Each voxel stores a material index to be used with a @ref VoxelPalette.
+    /// @ingroup voxels-plugin
+    class VoxelWorld final
+    {
+    public:
+        /// @brief Size of a chunk in each dimension, in voxels.
+        static constexpr int ChunkSize = 32;
+
+        /// @brief Hash function to allow chunk positions to be used as keys.
+        struct ChunkHash
+        {
+            std::size_t operator()(const glm::ivec3& chunk) const;
+        };
+
+        /// @brief Set of chunk positions.
+        using ChunkSet = std::unordered_set<glm::ivec3, ChunkHash>;
+
+        ~VoxelWorld() = default;
+
+        /// @brief Constructs an empty world.
+        VoxelWorld() = default;
+
+        /// @brief Move constructs.
+        VoxelWorld(VoxelWorld&&) noexcept = default;
+
+        /// @brief Removes every chunk from the world, marking them as dirty.
+        void clear();
+
+        /// @brief Sets the material index of a voxel.
+        /// @param position Voxel coordinates.
+        /// @param mat Material index to set.
+        void set(const glm::ivec3& position, uint16_t mat);
+
+        /// @brief Gets the material index of a voxel.
+        /// @param position Voxel coordinates.
+        /// @return Material index of the voxel.
+        uint16_t get(const glm::ivec3& position) const;
+
+        /// @brief Copies every voxel of a grid into the world, including empty ones.
+        /// @param grid Grid to copy.
+        /// @param offset World coordinates of the grid's voxel at `(0, 0, 0)`.
+        void paste(const VoxelGrid& grid, const glm::ivec3& offset);
+
+        /// @brief Converts the material indices of this world from one palette to another.
+        /// @see VoxelGrid::convert
+        /// @param src Original palette.
+        /// @param dst New palette.
+        /// @param minSimilarity Minimum similarity between two materials to consider them the same.
+        /// @return Whether the conversion was successful.
+        bool convert(const VoxelPalette& src, const VoxelPalette& dst, float minSimilarity);
+
+        /// @brief Checks the chunks modified since the last compaction for chunks which became
+        /// uniform, storing them as a single material, or removing them if they became empty.
+        void compact();
+
+        /// @brief Gets the position of the chunk which contains a voxel.
+        /// @param position Voxel coordinates.
+        /// @return Chunk position.
+        static glm::ivec3 chunkOf(const glm::ivec3& position);
+
+        /// @brief Gets the positions of every stored chunk.
+        /// @return Chunk positions.
+        std::vector<glm::ivec3> chunks() const;
+
+        /// @brief Gets the number of stored chunks.
+        /// @return Number of stored chunks.
+        std::size_t chunkCount() const;
+
+        /// @brief Gets the number of stored chunks which aren't uniform.
+        /// @return Number of dense chunks.
+        std::size_t denseChunkCount() const;
+
+        /// @brief Gets the material of a chunk, if every voxel in it has the same material.
+        /// @param chunk Chunk position.
+        /// @return Material of the chunk, or nothing if the chunk isn't uniform. Chunks which
+        /// aren't stored are uniform with material 0.
+        std::optional<uint16_t> uniform(const glm::ivec3& chunk) const;
+
+        /// @brief Copies a chunk into a dense grid with @ref ChunkSize voxels in each dimension.
+        /// @param chunk Chunk position.
+        /// @return Chunk grid.
+        VoxelGrid chunk(const glm::ivec3& chunk) const;
+
+        /// @brief Copies a chunk, along with the layer of voxels around it from its neighbours,
+        /// into a dense grid with @ref ChunkSize + 2 voxels in each dimension.
+        ///
+        /// The chunk's voxel at `(0, 0, 0)` is at `(1, 1, 1)` in the returned grid. Used to
+        /// triangulate the chunk without the faces hidden by its neighbours.
+        ///
+        /// @param chunk Chunk position.
+        /// @return Chunk grid with its apron.
+        VoxelGrid chunkWithApron(const glm::ivec3& chunk) const;
+
+        /// @brief Gets the chunks which were modified since the last call to @ref clearDirty().
+        /// @return Dirty chunk positions, which may include chunks which were removed.
+        const ChunkSet& dirtyChunks() const;
+
+        /// @brief Marks every chunk as clean.
+        void clearDirty();
+
+    private:
+        /// @brief Chunk data.
+        struct Chunk
+        {
+            uint16_t uniform = 0;            ///< Material of every voxel, if @ref grid is null.
+            std::unique_ptr<VoxelGrid> grid; ///< Voxels of the chunk, or null if the chunk is uniform.
+        };
+
+        std::unordered_map<glm::ivec3, Chunk, ChunkHash> mChunks; ///< Stored chunks.
+        ChunkSet mDirty;                                          ///< Dirty chunks.
+        ChunkSet mModified;                                       ///< Chunks modified since the last compaction.
+    };
+} // namespace cubos::engine
@@ -10,6 +10,7 @@
 #include <cubos/core/io/window.hpp>
 
 #include <cubos/engine/cubos.hpp>
+#include <cubos/engine/window/render_thread.hpp>
 
 namespace cubos::engine
 {
@@ -24,19 +25,28 @@ namespace cubos::engine
     /// - `window.title` - the window's title (default: `CUBOS.`).
     /// - `window.width` - the window's width (default: `800`).
     /// - `window.height` - the window's height (default: `600`).
+    /// - `window.renderThread` - whether to submit rendering commands from a @ref RenderThread,
+    ///   instead of the main thread (default: `true`).
+    /// - `window.shaderCache` - directory where linked shader pipelines are cached between runs, or
+    ///   empty to disable the cache (default: empty).
     ///
     /// ## Events
     /// - @ref core::io::WindowEvent - event polled from the window.
     ///
     /// ## Resources
     /// - @ref core::io::Window - handle to the window.
+    /// - @ref RenderThread - thread which owns the window's render context, if enabled. Systems
+    ///   which use the render device, such as those which set the renderer's palette, must do so
+    ///   through @ref RenderThread::call. The thread is stopped by `cubos.window.render` once
+    ///   @ref ShouldQuit is set, before any resource which holds render device objects is
+    ///   destroyed, so systems which set it must run before that tag.
     ///
     /// ## Startup tags
     /// - `cubos.window.init` - window is opened, runs after `cubos.settings`.
     ///
     /// ## Tags
     /// - `cubos.window.poll` - the window is polled for events, sending @ref core::io::WindowEvent's.
-    /// - `cubos.window.render` - the window's back buffers are swapped.
+    /// - `cubos.window.render` - the window's back buffers are swapped, on the @ref RenderThread.
     ///
     /// ## Dependencies
     /// - @ref settings-plugin
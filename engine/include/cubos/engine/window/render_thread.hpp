@@ -0,0 +1,81 @@
+/// @file
+/// @brief Resource @ref cubos::engine::RenderThread.
+/// @ingroup window-plugin
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <cubos/core/io/window.hpp>
+
+namespace cubos::engine
+{
+    /// @brief Resource which owns the window's render context on a dedicated thread, and runs
+    /// rendering jobs on it, in the order they were posted.
+    ///
+    /// This lets the render device's commands of a frame be submitted while the next frame is
+    /// simulated. While the thread isn't running, jobs run directly on the calling thread.
+    ///
+    /// Each @ref call() waits for the previous frame to be rendered, so frames only overlap while
+    /// nothing needs to be called. The engine's plugins only call while starting up, and post
+    /// everything else, such as mesh uploads and resizes, whose results are picked up on later
+    /// frames.
+    ///
+    /// Jobs must only be posted from a single thread, usually the main one.
+    ///
+    /// @ingroup window-plugin
+    class RenderThread final
+    {
+    public:
+        ~RenderThread();
+
+        /// @brief Constructs without starting the thread.
+        RenderThread() = default;
+
+        /// @brief Starts the thread, moving the window's render context from the calling thread
+        /// to it.
+        /// @param window Window.
+        void start(core::io::Window window);
+
+        /// @brief Waits for every posted job, stops the thread and moves the window's render
+        /// context back to the calling thread. Does nothing if the thread isn't running.
+        void stop();
+
+        /// @brief Checks if the thread is running.
+        /// @return Whether the thread is running.
+        bool running() const;
+
+        /// @brief Posts a job to run on the thread, without waiting for it.
+        /// @param job Job.
+        void post(std::function<void()> job);
+
+        /// @brief Waits until every posted job has finished.
+        void wait();
+
+        /// @brief Waits until every posted job has finished, and then runs a job on the calling
+        /// thread, with the render context current on it.
+        ///
+        /// Used as a sync point for work which must see the results of previous jobs, such as
+        /// resource uploads, or which must run on the calling thread, such as window calls.
+        ///
+        /// @param job Job.
+        void call(const std::function<void()>& job);
+
+    private:
+        /// @brief Runs the posted jobs until the thread is stopped.
+        void run();
+
+        core::io::Window mWindow;                ///< Window whose context is owned by the thread.
+        std::thread mThread;                     ///< Thread, if running.
+        std::mutex mMutex;                       ///< Protects the fields below.
+        std::condition_variable mJobPosted;      ///< Notified when a job is posted, or on stop.
+        std::condition_variable mIdle;           ///< Notified when the last posted job finishes.
+        std::deque<std::function<void()>> mJobs; ///< Jobs waiting to run.
+        bool mBusy = false;                      ///< Whether a job is running.
+        bool mStopping = false;                  ///< Whether the thread should stop.
+    };
+} // namespace cubos::engine
@@ -7,6 +7,7 @@
 #include <cubos/engine/settings/settings.hpp>
 
 #include <cubos/engine/transform/plugin.hpp>
+#include <cubos/engine/window/render_thread.hpp>
 
 //ex 2
 #include <cubos/engine/assets/assets.hpp>
@@ -107,11 +108,11 @@ static void spawnCamerasSystem(Commands commands, Write<ActiveCameras> camera)
 
 
 
-static void loadPaletteSystem(Read<Assets> assets, Write<Renderer> renderer)
+static void loadPaletteSystem(Read<Assets> assets, Write<Renderer> renderer, Write<RenderThread> renderThread)
 {   
 
     auto palette = assets->read(PaletteAsset);
-    (*renderer)->setPalette(*palette);
+    renderThread->call([&] { (*renderer)->setPalette(*palette); });
 
 }
 
@@ -200,7 +200,7 @@ int main()
     cubos.startupSystem(config).tagged("cubos.settings");
     cubos.startupSystem(init).tagged("cubos.assets");
 
-    cubos.system(update).after("cubos.input.update");
+    cubos.system(update).after("cubos.input.update").before("cubos.window.render");
 
     cubos.run();
     return 0;
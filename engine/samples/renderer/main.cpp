@@ -3,6 +3,7 @@
 #include <cubos/engine/renderer/point_light.hpp>
 #include <cubos/engine/settings/settings.hpp>
 #include <cubos/engine/transform/plugin.hpp>
+#include <cubos/engine/window/render_thread.hpp>
 
 using cubos::core::ecs::Commands;
 using cubos::core::ecs::Entity;
@@ -18,14 +19,17 @@ static void settingsSystem(Write<Settings> settings)
 }
 
 /// [Setting the palette]
-static void setPaletteSystem(Write<Renderer> renderer)
+static void setPaletteSystem(Write<Renderer> renderer, Write<RenderThread> renderThread)
 {
-    // Create a simple palette with 3 materials (red, green and blue).
-    (*renderer)->setPalette(VoxelPalette{{
-        {{1, 0, 0, 1}},
-        {{0, 1, 0, 1}},
-        {{0, 0, 1, 1}},
-    }});
+    // Create a simple palette with 3 materials (red, green and blue). Setting it uses the render
+    // device, so it must be done through the render thread.
+    renderThread->call([&] {
+        (*renderer)->setPalette(VoxelPalette{{
+            {{1, 0, 0, 1}},
+            {{0, 1, 0, 1}},
+            {{0, 0, 1, 1}},
+        }});
+    });
 }
 /// [Setting the palette]
 
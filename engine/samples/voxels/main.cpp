@@ -3,6 +3,7 @@
 #include <cubos/engine/settings/settings.hpp>
 #include <cubos/engine/transform/plugin.hpp>
 #include <cubos/engine/voxels/plugin.hpp>
+#include <cubos/engine/window/render_thread.hpp>
 
 using cubos::core::ecs::Commands;
 using cubos::core::ecs::Read;
@@ -21,11 +22,12 @@ static void settingsSystem(Write<Settings> settings)
 }
 
 /// [Load and set palette]
-static void setPaletteSystem(Read<Assets> assets, Write<Renderer> renderer)
+static void setPaletteSystem(Read<Assets> assets, Write<Renderer> renderer, Write<RenderThread> renderThread)
 {
-    // Read the palette's data and pass it to the renderer.
+    // Read the palette's data and pass it to the renderer, through the render thread, as it uses
+    // the render device.
     auto palette = assets->read(PaletteAsset);
-    (*renderer)->setPalette(*palette);
+    renderThread->call([&] { (*renderer)->setPalette(*palette); });
 }
 /// [Load and set palette]
 
@@ -1,72 +1,314 @@
 #include "broad_phase.hpp"
 
+#include "../parallel.hpp"
+#include "../simd.hpp"
+
 using CollisionType = BroadPhaseCollisions::CollisionType;
 
-void updateBoxAABBs(Query<Read<LocalToWorld>, Read<BoxCollider>, Write<ColliderAABB>> query)
+/// @brief Number of colliders whose AABBs are computed by each thread pool task.
+static constexpr std::size_t AABBBlockSize = 1024;
+
+/// @brief Structure-of-arrays batch of colliders gathered from a query, so that their AABBs can
+/// be computed in SIMD blocks.
+/// @tparam N Number of shape-specific float channels.
+template <std::size_t N>
+struct ColliderBatch
 {
-    for (auto [entity, localToWorld, collider, aabb] : query)
+    std::vector<float> basis[9];      ///< Linear part of the world transform (`basis[col * 3 + row]`).
+    std::vector<float> origin[3];     ///< Translation of the world transform.
+    std::vector<float> shape[N];      ///< Shape-specific parameters.
+    std::vector<float> min[3];        ///< Computed AABB minimums.
+    std::vector<float> max[3];        ///< Computed AABB maximums.
+    std::vector<ColliderAABB*> aabbs; ///< AABBs where the results are written to.
+
+    /// @brief Adds a collider to the batch. Its shape channels must be pushed separately.
+    /// @param transform Collider to world transform.
+    /// @param aabb AABB to write the result to.
+    void push(const glm::mat4& transform, ColliderAABB& aabb)
     {
-        // Get the 4 points of the collider.
-        glm::vec3 corners[4];
-        collider->shape.corners4(corners);
+        for (glm::length_t col = 0; col < 3; ++col)
+        {
+            for (glm::length_t row = 0; row < 3; ++row)
+            {
+                basis[col * 3 + row].push_back(transform[col][row]);
+            }
+        }
 
-        // Pack the 3 points of the collider into a matrix.
-        auto points = glm::mat4{glm::vec4{corners[0], 1.0F}, glm::vec4{corners[1], 1.0F}, glm::vec4{corners[2], 1.0F},
-                                glm::vec4{corners[3], 1.0F}};
+        for (glm::length_t row = 0; row < 3; ++row)
+        {
+            origin[row].push_back(transform[3][row]);
+        }
 
-        // Transforms collider space to world space.
-        auto transform = localToWorld->mat * collider->transform;
+        aabbs.push_back(&aabb);
+    }
 
-        // Only want scale and rotation, extract translation and remove it.
-        auto translation = glm::vec3{transform[3]};
-        transform[3] = glm::vec4{0.0F, 0.0F, 0.0F, 1.0F};
+    /// @brief Pads every channel to a multiple of the SIMD width and allocates the outputs.
+    void pad()
+    {
+        auto size = cubos::engine::simd::padded(aabbs.size());
+        for (auto& channel : basis)
+        {
+            channel.resize(size, 0.0F);
+        }
+        for (auto& channel : origin)
+        {
+            channel.resize(size, 0.0F);
+        }
+        for (auto& channel : shape)
+        {
+            channel.resize(size, 0.0F);
+        }
+        for (std::size_t axis = 0; axis < 3; ++axis)
+        {
+            min[axis].resize(size);
+            max[axis].resize(size);
+        }
+    }
 
-        // Rotate and scale corners.
-        auto rotatedCorners = glm::mat4x3{transform * points};
+    /// @brief Writes the computed AABBs of the colliders in the given range back.
+    /// @param begin First collider.
+    /// @param end Last collider (exclusive).
+    void scatter(std::size_t begin, std::size_t end) const
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            aabbs[i]->min = {min[0][i], min[1][i], min[2][i]};
+            aabbs[i]->max = {max[0][i], max[1][i], max[2][i]};
+        }
+    }
+
+    /// @brief Runs @p kernel over the batch in parallel and writes the results back.
+    /// @param pool Thread pool.
+    /// @param kernel Kernel called as `kernel(i)` for each group of @ref simd::Width colliders.
+    template <typename K>
+    void run(cubos::core::ThreadPool& pool, const K& kernel)
+    {
+        this->pad();
+        cubos::engine::parallelFor(pool, aabbs.size(), AABBBlockSize, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i += cubos::engine::simd::Width)
+            {
+                kernel(i);
+            }
+            this->scatter(begin, end);
+        });
+    }
+};
 
-        // Get the max of the rotated corners.
-        auto max = glm::max(glm::abs(rotatedCorners[0]), glm::abs(rotatedCorners[1]));
-        max = glm::max(max, glm::abs(rotatedCorners[2]));
-        max = glm::max(max, glm::abs(rotatedCorners[3]));
+/// @brief Checks if a collider is sleeping and hasn't moved since it fell asleep, in which case
+/// its AABB is still the one cached by its sleeping markers.
+/// @param collisions Broad phase collisions.
+/// @param entity Collider entity.
+/// @param localToWorld Current world transform of the collider.
+/// @return Whether its AABB doesn't have to be recomputed.
+static bool isStill(const BroadPhaseCollisions& collisions, Entity entity, const glm::mat4& localToWorld)
+{
+    auto it = collisions.motions.find(entity);
+    return it != collisions.motions.end() && it->second.isSleeping && it->second.localToWorld == localToWorld;
+}
 
-        // Add the collider's margin.
-        max += glm::vec3{collider->margin};
+void updateBoxAABBs(Query<Read<LocalToWorld>, Read<BoxCollider>, Write<ColliderAABB>> query,
+                    Read<BroadPhaseCollisions> collisions, Write<cubos::core::ThreadPool> pool)
+{
+    // Shape channels: half size (x, y, z) and margin.
+    ColliderBatch<4> batch;
+    for (auto [entity, localToWorld, collider, aabb] : query)
+    {
+        if (isStill(*collisions, entity, localToWorld->mat))
+        {
+            continue;
+        }
 
-        // Set the AABB.
-        aabb->max = translation + max;
-        aabb->min = translation - max;
+        batch.push(localToWorld->mat * collider->transform, *aabb);
+        batch.shape[0].push_back(collider->shape.halfSize.x);
+        batch.shape[1].push_back(collider->shape.halfSize.y);
+        batch.shape[2].push_back(collider->shape.halfSize.z);
+        batch.shape[3].push_back(collider->margin);
     }
+
+    batch.run(*pool, [&batch](std::size_t i) {
+        using namespace cubos::engine::simd;
+
+        // The extent of a rotated and scaled box on each world axis is given by the absolute
+        // value of the transform's linear part times the box's half size.
+        auto margin = load(&batch.shape[3][i]);
+        for (std::size_t row = 0; row < 3; ++row)
+        {
+            auto extent = margin;
+            for (std::size_t col = 0; col < 3; ++col)
+            {
+                extent = mulAdd(abs(load(&batch.basis[col * 3 + row][i])), load(&batch.shape[col][i]), extent);
+            }
+
+            auto center = load(&batch.origin[row][i]);
+            store(&batch.min[row][i], sub(center, extent));
+            store(&batch.max[row][i], add(center, extent));
+        }
+    });
 }
 
 void updateCapsuleAABBs(Query<Read<LocalToWorld>, Read<CapsuleCollider>, Write<ColliderAABB>> query,
-                        Write<BroadPhaseCollisions> collisions)
+                        Read<BroadPhaseCollisions> collisions, Write<cubos::core::ThreadPool> pool)
 {
-    (void)query;
-    (void)collisions;
+    // Shape channels: half length and radius.
+    ColliderBatch<2> batch;
+    for (auto [entity, localToWorld, collider, aabb] : query)
+    {
+        if (isStill(*collisions, entity, localToWorld->mat))
+        {
+            continue;
+        }
+
+        batch.push(localToWorld->mat * collider->transform, *aabb);
+        batch.shape[0].push_back(collider->shape.length / 2.0F);
+        batch.shape[1].push_back(collider->shape.radius);
+    }
+
+    batch.run(*pool, [&batch](std::size_t i) {
+        using namespace cubos::engine::simd;
+
+        // A capsule is a sphere swept along its segment, so its extent is the extent of the
+        // segment plus the extent of the (possibly scaled) sphere, which on each world axis is
+        // the radius times the length of the corresponding row of the transform.
+        auto halfLength = load(&batch.shape[0][i]);
+        auto radius = load(&batch.shape[1][i]);
+        for (std::size_t row = 0; row < 3; ++row)
+        {
+            auto b0 = load(&batch.basis[0 + row][i]);
+            auto b1 = load(&batch.basis[3 + row][i]);
+            auto b2 = load(&batch.basis[6 + row][i]);
+            auto rowLength = sqrt(mulAdd(b0, b0, mulAdd(b1, b1, mul(b2, b2))));
+            auto extent = mulAdd(abs(b1), halfLength, mul(radius, rowLength));
+
+            auto center = load(&batch.origin[row][i]);
+            store(&batch.min[row][i], sub(center, extent));
+            store(&batch.max[row][i], add(center, extent));
+        }
+    });
 }
 
 void updateSimplexAABBs(Query<Read<LocalToWorld>, Read<SimplexCollider>, Write<ColliderAABB>> query,
-                        Write<BroadPhaseCollisions> collisions)
+                        Read<BroadPhaseCollisions> collisions, Write<cubos::core::ThreadPool> pool)
 {
-    (void)query;
-    (void)collisions;
+    // Shape channels: up to four points (x, y, z each) and the margin.
+    ColliderBatch<13> batch;
+    for (auto [entity, localToWorld, collider, aabb] : query)
+    {
+        if (isStill(*collisions, entity, localToWorld->mat))
+        {
+            continue;
+        }
+
+        batch.push(localToWorld->mat, *aabb);
+
+        // Simplices with less than four points repeat their last point, and empty simplices are
+        // treated as a single point at the collider's offset.
+        const auto& points = collider->shape.points;
+        for (std::size_t p = 0; p < 4; ++p)
+        {
+            auto point = points.empty() ? glm::vec3{0.0F} : points[std::min(p, points.size() - 1)];
+            point += collider->offset;
+            batch.shape[p * 3 + 0].push_back(point.x);
+            batch.shape[p * 3 + 1].push_back(point.y);
+            batch.shape[p * 3 + 2].push_back(point.z);
+        }
+        batch.shape[12].push_back(collider->margin);
+    }
+
+    batch.run(*pool, [&batch](std::size_t i) {
+        using namespace cubos::engine::simd;
+
+        auto margin = load(&batch.shape[12][i]);
+        for (std::size_t row = 0; row < 3; ++row)
+        {
+            auto lo = splat(INFINITY);
+            auto hi = splat(-INFINITY);
+            for (std::size_t p = 0; p < 4; ++p)
+            {
+                auto world = load(&batch.origin[row][i]);
+                for (std::size_t col = 0; col < 3; ++col)
+                {
+                    world = mulAdd(load(&batch.basis[col * 3 + row][i]), load(&batch.shape[p * 3 + col][i]), world);
+                }
+                lo = min(lo, world);
+                hi = max(hi, world);
+            }
+
+            store(&batch.min[row][i], sub(lo, margin));
+            store(&batch.max[row][i], add(hi, margin));
+        }
+    });
 }
 
-void updateMarkers(Query<Read<ColliderAABB>> query, Write<BroadPhaseCollisions> collisions)
+void updateMarkers(Query<Read<ColliderAABB>, OptRead<CollisionLayers>, OptRead<LocalToWorld>> query,
+                   Write<BroadPhaseCollisions> collisions)
 {
+    // Find the colliders whose AABBs or layers stopped or started changing. Sleeping markers keep
+    // the layers they had when they fell asleep, so a change of layers must also wake them.
+    std::vector<Entity> fallingAsleep;
+    for (auto& [entity, motion] : collisions->motions)
+    {
+        auto [aabb, layers, localToWorld] = query[entity].value();
+        auto currentLayers = layers ? *layers : CollisionLayers{};
+        if (aabb->min == motion.min && aabb->max == motion.max && currentLayers == motion.layers)
+        {
+            motion.idleFrames += 1;
+        }
+        else
+        {
+            motion.min = aabb->min;
+            motion.max = aabb->max;
+            motion.layers = currentLayers;
+            motion.idleFrames = 0;
+        }
+
+        if (motion.isSleeping && motion.idleFrames == 0)
+        {
+            collisions->wake(entity);
+        }
+        else if (!motion.isSleeping && motion.idleFrames >= collisions->framesToSleep)
+        {
+            // The AABBs of sleeping colliders are only recomputed once they move.
+            motion.localToWorld = localToWorld ? localToWorld->mat : glm::mat4{1.0F};
+            fallingAsleep.push_back(entity);
+        }
+    }
+
     // TODO: This is parallelizable.
+    for (glm::length_t axis = 0; axis < 3; axis++)
+    {
+        // Refresh the positions and collision layers stored in the awake markers, so that neither
+        // sorting nor the sweep have to look them up again.
+        for (auto& marker : collisions->markersPerAxis[axis])
+        {
+            auto [aabb, layers, localToWorld] = query[marker.entity].value();
+            marker.position = marker.isMin ? aabb->min[axis] : aabb->max[axis];
+            marker.layers = layers ? *layers : CollisionLayers{};
+        }
+    }
+
+    // Sleeping markers keep the positions and layers they had when their colliders fell asleep,
+    // so they only need to be sorted again when new colliders join them.
+    collisions->fellAsleep.clear();
+    for (auto entity : fallingAsleep)
+    {
+        collisions->sleep(entity);
+        collisions->fellAsleep.insert(entity);
+    }
+
+    auto byPosition = [](const BroadPhaseCollisions::SweepMarker& a, const BroadPhaseCollisions::SweepMarker& b) {
+        return a.position < b.position;
+    };
+
     for (glm::length_t axis = 0; axis < 3; axis++)
     {
         // TODO: Should use insert sort to leverage spatial coherence.
-        std::sort(
-            collisions->markersPerAxis[axis].begin(), collisions->markersPerAxis[axis].end(),
-            [axis, &query](const BroadPhaseCollisions::SweepMarker& a, const BroadPhaseCollisions::SweepMarker& b) {
-                auto [aAABB] = query[a.entity].value();
-                auto [bAABB] = query[b.entity].value();
-                auto aPos = a.isMin ? aAABB->min : aAABB->max;
-                auto bPos = b.isMin ? bAABB->min : bAABB->max;
-                return aPos[axis] < bPos[axis];
-            });
+        std::sort(collisions->markersPerAxis[axis].begin(), collisions->markersPerAxis[axis].end(), byPosition);
+
+        if (!fallingAsleep.empty())
+        {
+            std::sort(collisions->sleepingMarkersPerAxis[axis].begin(), collisions->sleepingMarkersPerAxis[axis].end(),
+                      byPosition);
+        }
     }
 }
 
@@ -76,23 +318,51 @@ void sweep(Write<BroadPhaseCollisions> collisions)
     for (glm::length_t axis = 0; axis < 3; axis++)
     {
         CUBOS_ASSERT(collisions->activePerAxis[axis].empty(), "Last sweep entered an entity but never exited");
+        CUBOS_ASSERT(collisions->sleepingActivePerAxis[axis].empty(), "Last sweep entered an entity but never exited");
 
         collisions->sweepOverlapMaps[axis].clear();
 
-        for (auto& marker : collisions->markersPerAxis[axis])
+        // Merge the awake and sleeping markers, which are both sorted, on the fly.
+        const auto& awake = collisions->markersPerAxis[axis];
+        const auto& sleeping = collisions->sleepingMarkersPerAxis[axis];
+        std::size_t awakeIndex = 0;
+        std::size_t sleepingIndex = 0;
+        while (awakeIndex < awake.size() || sleepingIndex < sleeping.size())
         {
+            bool isAwake =
+                sleepingIndex == sleeping.size() ||
+                (awakeIndex < awake.size() && awake[awakeIndex].position <= sleeping[sleepingIndex].position);
+            const auto& marker = isAwake ? awake[awakeIndex++] : sleeping[sleepingIndex++];
+            auto& active = isAwake ? collisions->activePerAxis[axis] : collisions->sleepingActivePerAxis[axis];
+
             if (marker.isMin)
             {
-                for (const auto& other : collisions->activePerAxis[axis])
+                // Filter out pairs which can't collide as early as possible, so that they never
+                // reach candidate generation. Pairs of sleeping colliders can't have changed since
+                // both fell asleep, so they're only tested in the frame one of them fell asleep.
+                for (const auto& [other, otherLayers] : collisions->activePerAxis[axis])
+                {
+                    if (marker.layers.canCollide(otherLayers))
+                    {
+                        collisions->sweepOverlapMaps[axis][marker.entity].push_back(other);
+                    }
+                }
+
+                bool justFellAsleep = !isAwake && collisions->fellAsleep.contains(marker.entity);
+                for (const auto& [other, otherLayers] : collisions->sleepingActivePerAxis[axis])
                 {
-                    collisions->sweepOverlapMaps[axis][marker.entity].push_back(other);
+                    if ((isAwake || justFellAsleep || collisions->fellAsleep.contains(other)) &&
+                        marker.layers.canCollide(otherLayers))
+                    {
+                        collisions->sweepOverlapMaps[axis][marker.entity].push_back(other);
+                    }
                 }
 
-                collisions->activePerAxis[axis].insert(marker.entity);
+                active.emplace(marker.entity, marker.layers);
             }
             else
             {
-                collisions->activePerAxis[axis].erase(marker.entity);
+                active.erase(marker.entity);
             }
         }
     }
@@ -192,4 +462,90 @@ void findPairs(Query<OptRead<BoxCollider>, OptRead<CapsuleCollider>, OptRead<Pla
             }
         }
     }
-}
\ No newline at end of file
+}
+
+void updatePairs(Write<BroadPhaseCollisions> collisions, EventWriter<CollisionStarted> started,
+                 EventWriter<CollisionEnded> ended)
+{
+    auto frame = ++collisions->frame;
+
+    for (std::size_t type = 0; type < static_cast<std::size_t>(CollisionType::Count); type++)
+    {
+        for (const auto& candidate : collisions->candidatesPerType[type])
+        {
+            auto [it, inserted] = collisions->pairs.try_emplace(
+                candidate, BroadPhaseCollisions::PairData{static_cast<CollisionType>(type), frame, frame});
+            if (inserted)
+            {
+                started.push({candidate.first, candidate.second, it->second.type});
+            }
+            else
+            {
+                it->second.lastFrame = frame;
+            }
+        }
+    }
+
+    // Pairs of sleeping colliders are no longer found by the sweep, but they're still touching.
+    for (auto it = collisions->pairs.begin(); it != collisions->pairs.end();)
+    {
+        if (it->second.lastFrame != frame &&
+            !(collisions->isSleeping(it->first.first) && collisions->isSleeping(it->first.second)))
+        {
+            ended.push({it->first.first, it->first.second, it->second.type});
+            it = collisions->pairs.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void updateCollisionQueries(Query<Read<LocalToWorld>, Read<ColliderAABB>, OptRead<BoxCollider>,
+                                  OptRead<CapsuleCollider>, OptRead<PlaneCollider>>
+                                query,
+                            Read<BroadPhaseCollisions> collisions, Write<CollisionQueries> queries)
+{
+    queries->clear();
+
+    // Min markers on the X axis are sorted by the minimum X of each AABB, which is the order the
+    // queries rely on to stop early. The awake and sleeping markers are merged to keep that order.
+    const auto& awake = collisions->markersPerAxis[0];
+    const auto& sleeping = collisions->sleepingMarkersPerAxis[0];
+    std::size_t awakeIndex = 0;
+    std::size_t sleepingIndex = 0;
+    while (awakeIndex < awake.size() || sleepingIndex < sleeping.size())
+    {
+        bool isAwake = sleepingIndex == sleeping.size() ||
+                       (awakeIndex < awake.size() && awake[awakeIndex].position <= sleeping[sleepingIndex].position);
+        const auto& marker = isAwake ? awake[awakeIndex++] : sleeping[sleepingIndex++];
+        if (!marker.isMin)
+        {
+            continue;
+        }
+
+        auto components = query[marker.entity];
+        if (!components)
+        {
+            continue;
+        }
+
+        auto [localToWorld, aabb, box, capsule, plane] = *components;
+        if (box)
+        {
+            queries->addBox(marker.entity, *aabb, localToWorld->mat * box->transform, box->shape.halfSize);
+        }
+        else if (capsule)
+        {
+            queries->addCapsule(marker.entity, *aabb, localToWorld->mat * capsule->transform, capsule->shape.radius,
+                                capsule->shape.length);
+        }
+        else if (plane)
+        {
+            auto point = glm::vec3{localToWorld->mat * glm::vec4{plane->offset, 1.0F}};
+            auto normal = glm::transpose(glm::inverse(glm::mat3{localToWorld->mat})) * plane->shape.normal;
+            queries->addPlane(marker.entity, point, glm::normalize(normal));
+        }
+    }
+}
@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <cubos/core/ecs/event_writer.hpp>
 #include <cubos/core/ecs/query.hpp>
+#include <cubos/core/thread_pool.hpp>
 
 #include <cubos/engine/collisions/aabb.hpp>
 #include <cubos/engine/collisions/broad_phase_collisions.hpp>
@@ -11,9 +13,13 @@
 #include <cubos/engine/collisions/colliders/capsule.hpp>
 #include <cubos/engine/collisions/colliders/plane.hpp>
 #include <cubos/engine/collisions/colliders/simplex.hpp>
+#include <cubos/engine/collisions/collision_events.hpp>
+#include <cubos/engine/collisions/collision_layers.hpp>
+#include <cubos/engine/collisions/collision_queries.hpp>
 #include <cubos/engine/transform/plugin.hpp>
 
 using cubos::core::ecs::Commands;
+using cubos::core::ecs::EventWriter;
 using cubos::core::ecs::OptRead;
 using cubos::core::ecs::Query;
 using cubos::core::ecs::Read;
@@ -23,6 +29,10 @@ using cubos::engine::BoxCollider;
 using cubos::engine::BroadPhaseCollisions;
 using cubos::engine::CapsuleCollider;
 using cubos::engine::ColliderAABB;
+using cubos::engine::CollisionEnded;
+using cubos::engine::CollisionLayers;
+using cubos::engine::CollisionQueries;
+using cubos::engine::CollisionStarted;
 using cubos::engine::LocalToWorld;
 using cubos::engine::PlaneCollider;
 using cubos::engine::SimplexCollider;
@@ -45,20 +55,32 @@ void trackNewEntities(Query<Read<C>, OptRead<ColliderAABB>> query, Write<BroadPh
 }
 
 /// @brief Updates the AABBs of all box colliders.
-void updateBoxAABBs(Query<Read<LocalToWorld>, Read<BoxCollider>, Write<ColliderAABB>> query);
+///
+/// The extents are computed as `|R| * halfSize` in SIMD blocks, where `R` is the linear part of
+/// the collider's world transform. Sleeping colliders which haven't moved are skipped.
+void updateBoxAABBs(Query<Read<LocalToWorld>, Read<BoxCollider>, Write<ColliderAABB>> query,
+                    Read<BroadPhaseCollisions> collisions, Write<cubos::core::ThreadPool> pool);
 
 /// @brief Updates the AABBs of all capsule colliders.
+///
+/// Capsules are assumed to be aligned with the local Y axis. Sleeping colliders which haven't
+/// moved are skipped.
 void updateCapsuleAABBs(Query<Read<LocalToWorld>, Read<CapsuleCollider>, Write<ColliderAABB>> query,
-                        Write<BroadPhaseCollisions> collisions);
+                        Read<BroadPhaseCollisions> collisions, Write<cubos::core::ThreadPool> pool);
 
-/// @brief Updates the AABBs of all simplex colliders.
+/// @brief Updates the AABBs of all simplex colliders. Sleeping colliders which haven't moved are
+/// skipped.
 void updateSimplexAABBs(Query<Read<LocalToWorld>, Read<SimplexCollider>, Write<ColliderAABB>> query,
-                        Write<BroadPhaseCollisions> collisions);
+                        Read<BroadPhaseCollisions> collisions, Write<cubos::core::ThreadPool> pool);
 
 /// @brief Updates the sweep markers of all colliders.
-void updateMarkers(Query<Read<ColliderAABB>> query, Write<BroadPhaseCollisions> collisions);
+void updateMarkers(Query<Read<ColliderAABB>, OptRead<CollisionLayers>, OptRead<LocalToWorld>> query,
+                   Write<BroadPhaseCollisions> collisions);
 
 /// @brief Performs a sweep of all colliders.
+///
+/// Pairs whose @ref CollisionLayers don't allow them to collide, such as pairs of static
+/// colliders, are skipped here and never become candidates.
 void sweep(Write<BroadPhaseCollisions> collisions);
 
 /// @brief Finds all pairs of colliders which may be colliding.
@@ -69,4 +91,17 @@ void sweep(Write<BroadPhaseCollisions> collisions);
 void findPairs(Query<OptRead<BoxCollider>, OptRead<CapsuleCollider>, OptRead<PlaneCollider>, OptRead<SimplexCollider>,
                      Read<ColliderAABB>>
                    query,
-               Write<BroadPhaseCollisions> collisions);
\ No newline at end of file
+               Write<BroadPhaseCollisions> collisions);
+
+/// @brief Updates the persistent pair cache with the candidates found this frame, sending
+/// @ref CollisionStarted for new pairs and @ref CollisionEnded for pairs which are no longer
+/// candidates.
+void updatePairs(Write<BroadPhaseCollisions> collisions, EventWriter<CollisionStarted> started,
+                 EventWriter<CollisionEnded> ended);
+
+/// @brief Updates the collider snapshot used by @ref CollisionQueries, in the order of the X axis
+/// sweep markers.
+void updateCollisionQueries(Query<Read<LocalToWorld>, Read<ColliderAABB>, OptRead<BoxCollider>,
+                                  OptRead<CapsuleCollider>, OptRead<PlaneCollider>>
+                                query,
+                            Read<BroadPhaseCollisions> collisions, Write<CollisionQueries> queries);
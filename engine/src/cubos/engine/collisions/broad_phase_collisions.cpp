@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <cubos/core/log.hpp>
 
 #include <cubos/engine/collisions/broad_phase_collisions.hpp>
@@ -7,38 +9,101 @@ using cubos::engine::BroadPhaseCollisions;
 using Candidate = BroadPhaseCollisions::Candidate;
 using CandidateHash = BroadPhaseCollisions::CandidateHash;
 using CollisionType = BroadPhaseCollisions::CollisionType;
+using PairData = BroadPhaseCollisions::PairData;
 using SweepMarker = BroadPhaseCollisions::SweepMarker;
 
+Candidate BroadPhaseCollisions::canonical(Entity a, Entity b)
+{
+    if (a.index < b.index || (a.index == b.index && a.generation <= b.generation))
+    {
+        return {a, b};
+    }
+
+    return {b, a};
+}
+
+/// @brief Moves the markers of an entity from one list of markers to another.
+/// @param from Markers to move from.
+/// @param to Markers to move to.
+/// @param entity Entity.
+static void moveMarkers(std::vector<SweepMarker>& from, std::vector<SweepMarker>& to, Entity entity)
+{
+    auto it = std::stable_partition(from.begin(), from.end(),
+                                    [entity](const SweepMarker& m) { return m.entity != entity; });
+    to.insert(to.end(), it, from.end());
+    from.erase(it, from.end());
+}
+
 void BroadPhaseCollisions::addEntity(Entity entity)
 {
     for (auto& markers : markersPerAxis)
     {
-        markers.push_back({entity, true});
-        markers.push_back({entity, false});
+        markers.push_back({entity, true, INFINITY, {}});
+        markers.push_back({entity, false, INFINITY, {}});
     }
+
+    motions.emplace(entity, Motion{});
 }
 
 void BroadPhaseCollisions::removeEntity(Entity entity)
 {
-    for (auto& markers : markersPerAxis)
+    auto isEntity = [entity](const SweepMarker& m) { return m.entity == entity; };
+    for (glm::length_t axis = 0; axis < 3; axis++)
     {
-        markers.erase(std::remove_if(markers.begin(), markers.end(),
-                                     [entity](const SweepMarker& m) { return m.entity == entity; }),
-                      markers.end());
+        auto& markers = markersPerAxis[axis];
+        markers.erase(std::remove_if(markers.begin(), markers.end(), isEntity), markers.end());
+
+        auto& sleepingMarkers = sleepingMarkersPerAxis[axis];
+        sleepingMarkers.erase(std::remove_if(sleepingMarkers.begin(), sleepingMarkers.end(), isEntity),
+                              sleepingMarkers.end());
     }
+
+    motions.erase(entity);
+    fellAsleep.erase(entity);
 }
 
 void BroadPhaseCollisions::clearEntities()
 {
-    for (auto& markers : markersPerAxis)
+    for (glm::length_t axis = 0; axis < 3; axis++)
     {
-        markers.clear();
+        markersPerAxis[axis].clear();
+        sleepingMarkersPerAxis[axis].clear();
     }
+
+    motions.clear();
+    fellAsleep.clear();
+}
+
+void BroadPhaseCollisions::sleep(Entity entity)
+{
+    for (glm::length_t axis = 0; axis < 3; axis++)
+    {
+        moveMarkers(markersPerAxis[axis], sleepingMarkersPerAxis[axis], entity);
+    }
+
+    motions.at(entity).isSleeping = true;
+}
+
+void BroadPhaseCollisions::wake(Entity entity)
+{
+    // Removing the markers keeps the remaining sleeping markers sorted.
+    for (glm::length_t axis = 0; axis < 3; axis++)
+    {
+        moveMarkers(sleepingMarkersPerAxis[axis], markersPerAxis[axis], entity);
+    }
+
+    motions.at(entity).isSleeping = false;
+}
+
+bool BroadPhaseCollisions::isSleeping(Entity entity) const
+{
+    auto it = motions.find(entity);
+    return it != motions.end() && it->second.isSleeping;
 }
 
 void BroadPhaseCollisions::addCandidate(CollisionType type, Candidate candidate)
 {
-    candidatesPerType[static_cast<std::size_t>(type)].insert(candidate);
+    candidatesPerType[static_cast<std::size_t>(type)].insert(canonical(candidate.first, candidate.second));
 }
 
 const std::unordered_set<Candidate, CandidateHash>& BroadPhaseCollisions::candidates(CollisionType type) const
@@ -53,3 +118,15 @@ void BroadPhaseCollisions::clearCandidates()
         candidates.clear();
     }
 }
+
+PairData* BroadPhaseCollisions::pair(Entity a, Entity b)
+{
+    auto it = pairs.find(canonical(a, b));
+    return it == pairs.end() ? nullptr : &it->second;
+}
+
+const PairData* BroadPhaseCollisions::pair(Entity a, Entity b) const
+{
+    auto it = pairs.find(canonical(a, b));
+    return it == pairs.end() ? nullptr : &it->second;
+}
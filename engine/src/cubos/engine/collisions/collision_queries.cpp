@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <cmath>
+
+#include <cubos/engine/collisions/collision_queries.hpp>
+
+#include "../parallel.hpp"
+#include "../simd.hpp"
+
+using cubos::core::ecs::Entity;
+using cubos::engine::ColliderAABB;
+using cubos::engine::CollisionQueries;
+using cubos::engine::Ray;
+using cubos::engine::RaycastHit;
+
+/// @brief Number of ray packets cast by each thread pool task.
+static constexpr std::size_t PacketBlockSize = 64;
+
+/// @brief Largest magnitude of the inverse of a ray direction component.
+///
+/// Kept finite, so that rays parallel to an axis whose origin lies on a slab plane of an AABB get
+/// `0 * MaxInverseDirection = 0` instead of a NaN, which would make them miss.
+static constexpr float MaxInverseDirection = 1e30F;
+
+/// @brief Gets the furthest X coordinate a ray can reach.
+/// @param ray Ray.
+/// @param maxDistance Maximum distance along the ray.
+/// @return Furthest X coordinate.
+static float reachX(const Ray& ray, float maxDistance)
+{
+    if (ray.direction.x <= 0.0F)
+    {
+        return ray.origin.x;
+    }
+
+    return ray.origin.x + ray.direction.x * maxDistance;
+}
+
+/// @brief Checks if a ray intersects an AABB, inflated by the given radius, before the given distance.
+/// @param ray Ray.
+/// @param aabb AABB.
+/// @param radius Radius to inflate the AABB by.
+/// @param maxDistance Maximum distance along the ray.
+/// @return Whether there's an intersection.
+static bool rayAABB(const Ray& ray, const ColliderAABB& aabb, float radius, float maxDistance)
+{
+    float tNear = 0.0F;
+    float tFar = maxDistance;
+    for (glm::length_t i = 0; i < 3; ++i)
+    {
+        float lo = aabb.min[i] - radius;
+        float hi = aabb.max[i] + radius;
+        if (ray.direction[i] == 0.0F)
+        {
+            if (ray.origin[i] < lo || ray.origin[i] > hi)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float t1 = (lo - ray.origin[i]) / ray.direction[i];
+        float t2 = (hi - ray.origin[i]) / ray.direction[i];
+        tNear = std::max(tNear, std::min(t1, t2));
+        tFar = std::min(tFar, std::max(t1, t2));
+        if (tNear > tFar)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Finds the first non-negative intersection of a ray with a sphere.
+/// @param origin Origin of the ray.
+/// @param direction Direction of the ray, not necessarily normalized.
+/// @param center Center of the sphere.
+/// @param radius Radius of the sphere.
+/// @param[out] t Intersection parameter.
+/// @return Whether there's an intersection. Rays which start inside the sphere don't intersect it.
+static bool raySphere(glm::vec3 origin, glm::vec3 direction, glm::vec3 center, float radius, float& t)
+{
+    auto oc = origin - center;
+    float a = glm::dot(direction, direction);
+    float b = glm::dot(oc, direction);
+    float c = glm::dot(oc, oc) - radius * radius;
+    float discriminant = b * b - a * c;
+    if (a == 0.0F || discriminant < 0.0F)
+    {
+        return false;
+    }
+
+    t = (-b - std::sqrt(discriminant)) / a;
+    return t >= 0.0F;
+}
+
+/// @brief Checks if a world aligned box and an oriented box are separated along an axis.
+/// @param axis Axis, not necessarily normalized.
+/// @param offset Offset from the center of the world aligned box to the center of the oriented box.
+/// @param halfSize Half size of the world aligned box.
+/// @param halfAxes Half axes of the oriented box.
+/// @return Whether the boxes are separated.
+static bool separated(glm::vec3 axis, glm::vec3 offset, glm::vec3 halfSize, const glm::vec3 halfAxes[3])
+{
+    float radius = glm::dot(halfSize, glm::abs(axis));
+    for (glm::length_t i = 0; i < 3; ++i)
+    {
+        radius += std::abs(glm::dot(halfAxes[i], axis));
+    }
+
+    return std::abs(glm::dot(offset, axis)) > radius;
+}
+
+void CollisionQueries::clear()
+{
+    mColliders.clear();
+    mPlanes.clear();
+}
+
+void CollisionQueries::addBox(Entity entity, const ColliderAABB& aabb, const glm::mat4& transform,
+                              const glm::vec3& halfSize)
+{
+    mColliders.push_back({entity, Shape::Box, aabb, transform, glm::inverse(transform), halfSize});
+}
+
+void CollisionQueries::addCapsule(Entity entity, const ColliderAABB& aabb, const glm::mat4& transform, float radius,
+                                  float length)
+{
+    mColliders.push_back({entity, Shape::Capsule, aabb, transform, glm::inverse(transform),
+                          glm::vec3{radius, length / 2.0F, 0.0F}});
+}
+
+void CollisionQueries::addPlane(Entity entity, const glm::vec3& point, const glm::vec3& normal)
+{
+    auto transform = glm::mat4{1.0F};
+    transform[3] = glm::vec4{point, 1.0F};
+    mPlanes.push_back({entity, Shape::Plane, ColliderAABB{}, transform, glm::mat4{1.0F}, normal});
+}
+
+std::optional<RaycastHit> CollisionQueries::raycast(const Ray& ray) const
+{
+    return this->castAll(ray, 0.0F);
+}
+
+std::vector<std::optional<RaycastHit>> CollisionQueries::raycastBatch(core::ThreadPool& pool,
+                                                                      std::span<const Ray> rays) const
+{
+    std::vector<std::optional<RaycastHit>> hits(rays.size());
+    std::span<std::optional<RaycastHit>> hitsSpan{hits};
+
+    auto packets = simd::padded(rays.size()) / simd::Width;
+    parallelFor(pool, packets, PacketBlockSize, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t packet = begin; packet < end; ++packet)
+        {
+            auto first = packet * simd::Width;
+            auto count = std::min(simd::Width, rays.size() - first);
+            this->castPacket(rays.subspan(first, count), hitsSpan.subspan(first, count));
+        }
+    });
+
+    return hits;
+}
+
+std::vector<Entity> CollisionQueries::overlapBox(const glm::vec3& center, const glm::vec3& halfSize) const
+{
+    std::vector<Entity> entities;
+
+    for (const auto& plane : mPlanes)
+    {
+        const auto& normal = plane.extents;
+        auto distance = glm::dot(center - glm::vec3{plane.localToWorld[3]}, normal);
+        if (std::abs(distance) <= glm::dot(halfSize, glm::abs(normal)))
+        {
+            entities.push_back(plane.entity);
+        }
+    }
+
+    ColliderAABB box{center - halfSize, center + halfSize};
+    for (const auto& collider : mColliders)
+    {
+        if (collider.aabb.min.x > box.max.x)
+        {
+            break;
+        }
+
+        if (!collider.aabb.overlaps(box))
+        {
+            continue;
+        }
+
+        if (collider.shape == Shape::Box)
+        {
+            // Separating axis test, where the world axes were already covered by the AABB test.
+            glm::vec3 halfAxes[3];
+            for (glm::length_t i = 0; i < 3; ++i)
+            {
+                halfAxes[i] = glm::vec3{collider.localToWorld[i]} * collider.extents[i];
+            }
+
+            auto offset = glm::vec3{collider.localToWorld[3]} - center;
+            bool isSeparated = separated(glm::cross(halfAxes[1], halfAxes[2]), offset, halfSize, halfAxes) ||
+                               separated(glm::cross(halfAxes[2], halfAxes[0]), offset, halfSize, halfAxes) ||
+                               separated(glm::cross(halfAxes[0], halfAxes[1]), offset, halfSize, halfAxes);
+            for (glm::length_t i = 0; i < 3 && !isSeparated; ++i)
+            {
+                for (glm::length_t j = 0; j < 3 && !isSeparated; ++j)
+                {
+                    auto worldAxis = glm::vec3{0.0F};
+                    worldAxis[i] = 1.0F;
+                    isSeparated = separated(glm::cross(worldAxis, halfAxes[j]), offset, halfSize, halfAxes);
+                }
+            }
+
+            if (isSeparated)
+            {
+                continue;
+            }
+        }
+
+        entities.push_back(collider.entity);
+    }
+
+    return entities;
+}
+
+std::optional<RaycastHit> CollisionQueries::sweepSphere(const Ray& ray, float radius) const
+{
+    return this->castAll(ray, radius);
+}
+
+bool CollisionQueries::cast(const Collider& collider, const Ray& ray, float radius, float maxDistance,
+                            RaycastHit& hit)
+{
+    if (collider.shape == Shape::Plane)
+    {
+        // Planes are two-sided: the sphere is stopped by whichever side it's coming from.
+        const auto& normal = collider.extents;
+        float distance = glm::dot(ray.origin - glm::vec3{collider.localToWorld[3]}, normal);
+        float speed = glm::dot(ray.direction, normal);
+        float side = distance >= 0.0F ? 1.0F : -1.0F;
+        if (distance * side < radius || speed * side >= 0.0F)
+        {
+            return false;
+        }
+
+        float t = (distance - side * radius) / -speed;
+        if (t > maxDistance)
+        {
+            return false;
+        }
+
+        hit = {collider.entity, t, ray.origin + ray.direction * t, normal * side};
+        return true;
+    }
+
+    // Box and capsule casts are done in the collider's local space, where the ray parameter is
+    // still the world distance, as the transform is affine.
+    auto origin = glm::vec3{collider.worldToLocal * glm::vec4{ray.origin, 1.0F}};
+    auto direction = glm::vec3{collider.worldToLocal * glm::vec4{ray.direction, 0.0F}};
+
+    float tHit = INFINITY;
+    glm::vec3 localNormal{0.0F};
+
+    if (collider.shape == Shape::Box)
+    {
+        float tNear = -INFINITY;
+        float tFar = INFINITY;
+        glm::length_t axis = -1;
+        for (glm::length_t i = 0; i < 3; ++i)
+        {
+            // The sphere radius is converted to local units along each axis.
+            float half = collider.extents[i] + radius / glm::length(glm::vec3{collider.localToWorld[i]});
+            if (direction[i] == 0.0F)
+            {
+                if (std::abs(origin[i]) > half)
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            float t1 = (-half - origin[i]) / direction[i];
+            float t2 = (half - origin[i]) / direction[i];
+            if (t1 > t2)
+            {
+                std::swap(t1, t2);
+            }
+
+            if (t1 > tNear)
+            {
+                tNear = t1;
+                axis = i;
+            }
+            tFar = std::min(tFar, t2);
+        }
+
+        if (axis < 0 || tNear > tFar || tNear < 0.0F)
+        {
+            return false;
+        }
+
+        tHit = tNear;
+        localNormal[axis] = direction[axis] > 0.0F ? -1.0F : 1.0F;
+    }
+    else
+    {
+        // Capsules are a cylinder along the Y axis capped by two hemispheres. The sphere radius is
+        // converted to local units assuming the capsule is uniformly scaled.
+        float capsuleRadius = collider.extents.x + radius / glm::length(glm::vec3{collider.localToWorld[0]});
+        float halfLength = collider.extents.y;
+
+        float a = direction.x * direction.x + direction.z * direction.z;
+        if (a > 0.0F)
+        {
+            float b = origin.x * direction.x + origin.z * direction.z;
+            float c = origin.x * origin.x + origin.z * origin.z - capsuleRadius * capsuleRadius;
+            float discriminant = b * b - a * c;
+            if (discriminant >= 0.0F)
+            {
+                float t = (-b - std::sqrt(discriminant)) / a;
+                auto point = origin + direction * t;
+                if (t >= 0.0F && std::abs(point.y) <= halfLength)
+                {
+                    tHit = t;
+                    localNormal = {point.x, 0.0F, point.z};
+                }
+            }
+        }
+
+        for (float side : {-1.0F, 1.0F})
+        {
+            auto center = glm::vec3{0.0F, side * halfLength, 0.0F};
+            float t;
+            if (raySphere(origin, direction, center, capsuleRadius, t) && t < tHit)
+            {
+                auto point = origin + direction * t;
+                if (point.y * side >= halfLength)
+                {
+                    tHit = t;
+                    localNormal = point - center;
+                }
+            }
+        }
+
+        if (tHit == INFINITY)
+        {
+            return false;
+        }
+    }
+
+    if (tHit > maxDistance)
+    {
+        return false;
+    }
+
+    auto normal = glm::transpose(glm::mat3{collider.worldToLocal}) * localNormal;
+    hit = {collider.entity, tHit, ray.origin + ray.direction * tHit, glm::normalize(normal)};
+    return true;
+}
+
+std::optional<RaycastHit> CollisionQueries::castAll(const Ray& ray, float radius) const
+{
+    std::optional<RaycastHit> closest;
+    RaycastHit hit;
+    float maxDistance = ray.maxDistance;
+
+    for (const auto& plane : mPlanes)
+    {
+        if (cast(plane, ray, radius, maxDistance, hit))
+        {
+            closest = hit;
+            maxDistance = hit.distance;
+        }
+    }
+
+    // Colliders are sorted by the minimum X of their AABBs, so once we find one which starts past
+    // the furthest point the cast can reach, all the remaining ones can be skipped.
+    float reach = reachX(ray, maxDistance) + radius;
+    for (const auto& collider : mColliders)
+    {
+        if (collider.aabb.min.x > reach)
+        {
+            break;
+        }
+
+        if (rayAABB(ray, collider.aabb, radius, maxDistance) && cast(collider, ray, radius, maxDistance, hit))
+        {
+            closest = hit;
+            maxDistance = hit.distance;
+            reach = reachX(ray, maxDistance) + radius;
+        }
+    }
+
+    return closest;
+}
+
+void CollisionQueries::castPacket(std::span<const Ray> rays, std::span<std::optional<RaycastHit>> hits) const
+{
+    using namespace simd;
+
+    // Rays are stored in structure-of-arrays form, so that each collider's AABB is tested against
+    // the whole packet at once. Unused lanes have a negative maximum distance and never hit.
+    float origin[3][Width] = {};
+    float invDirection[3][Width] = {};
+    float maxDistance[Width] = {-1.0F, -1.0F, -1.0F, -1.0F};
+    float reach[Width] = {-INFINITY, -INFINITY, -INFINITY, -INFINITY};
+    RaycastHit hit;
+
+    for (std::size_t lane = 0; lane < rays.size(); ++lane)
+    {
+        for (glm::length_t i = 0; i < 3; ++i)
+        {
+            auto axis = static_cast<std::size_t>(i);
+            origin[axis][lane] = rays[lane].origin[i];
+            auto direction = rays[lane].direction[i];
+            invDirection[axis][lane] = direction == 0.0F ? MaxInverseDirection
+                                                         : std::clamp(1.0F / direction, -MaxInverseDirection,
+                                                                      MaxInverseDirection);
+        }
+
+        maxDistance[lane] = rays[lane].maxDistance;
+        for (const auto& plane : mPlanes)
+        {
+            if (cast(plane, rays[lane], 0.0F, maxDistance[lane], hit))
+            {
+                hits[lane] = hit;
+                maxDistance[lane] = hit.distance;
+            }
+        }
+
+        reach[lane] = reachX(rays[lane], maxDistance[lane]);
+    }
+
+    Float4 origins[3] = {load(origin[0]), load(origin[1]), load(origin[2])};
+    Float4 invDirections[3] = {load(invDirection[0]), load(invDirection[1]), load(invDirection[2])};
+    Float4 tMax = load(maxDistance);
+    float packetReach = *std::max_element(reach, reach + Width);
+
+    for (const auto& collider : mColliders)
+    {
+        if (collider.aabb.min.x > packetReach)
+        {
+            break;
+        }
+
+        auto tNear = splat(0.0F);
+        auto tFar = tMax;
+        for (glm::length_t i = 0; i < 3; ++i)
+        {
+            auto axis = static_cast<std::size_t>(i);
+            auto t1 = mul(sub(splat(collider.aabb.min[i]), origins[axis]), invDirections[axis]);
+            auto t2 = mul(sub(splat(collider.aabb.max[i]), origins[axis]), invDirections[axis]);
+            tNear = max(tNear, min(t1, t2));
+            tFar = min(tFar, max(t1, t2));
+        }
+
+        int mask = lessEqual(tNear, tFar);
+        if (mask == 0)
+        {
+            continue;
+        }
+
+        bool changed = false;
+        for (std::size_t lane = 0; lane < rays.size(); ++lane)
+        {
+            if ((mask & (1 << lane)) != 0 && cast(collider, rays[lane], 0.0F, maxDistance[lane], hit))
+            {
+                hits[lane] = hit;
+                maxDistance[lane] = hit.distance;
+                reach[lane] = reachX(rays[lane], hit.distance);
+                changed = true;
+            }
+        }
+
+        if (changed)
+        {
+            tMax = load(maxDistance);
+            packetReach = *std::max_element(reach, reach + Width);
+        }
+    }
+}
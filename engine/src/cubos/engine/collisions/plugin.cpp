@@ -9,8 +9,13 @@ void cubos::engine::collisionsPlugin(Cubos& cubos)
     cubos.addPlugin(transformPlugin);
 
     cubos.addResource<BroadPhaseCollisions>();
+    cubos.addResource<CollisionQueries>();
+
+    cubos.addEvent<CollisionStarted>();
+    cubos.addEvent<CollisionEnded>();
 
     cubos.addComponent<ColliderAABB>();
+    cubos.addComponent<CollisionLayers>();
     cubos.addComponent<BoxCollider>();
     cubos.addComponent<SimplexCollider>();
     cubos.addComponent<CapsuleCollider>();
@@ -29,7 +34,13 @@ void cubos::engine::collisionsPlugin(Cubos& cubos)
 
     cubos.system(updateMarkers).tagged("cubos.collisions.broad.markers").after("cubos.collisions.aabb");
     cubos.system(sweep).tagged("cubos.collisions.broad.sweep").after("cubos.collisions.broad.markers");
+    cubos.system(updateCollisionQueries)
+        .tagged("cubos.collisions.queries")
+        .after("cubos.collisions.broad.markers")
+        .before("cubos.collisions");
     cubos.system(findPairs).tagged("cubos.collisions.broad").after("cubos.collisions.broad.sweep");
+    cubos.system(updatePairs).tagged("cubos.collisions.broad.pairs").after("cubos.collisions.broad");
 
     cubos.tag("cubos.collisions.broad").before("cubos.collisions");
+    cubos.tag("cubos.collisions.broad.pairs").before("cubos.collisions");
 }
@@ -1,7 +1,10 @@
+#include <algorithm>
+#include <thread>
 #include <utility>
 
 #include <cubos/core/ecs/commands.hpp>
 #include <cubos/core/log.hpp>
+#include <cubos/core/thread_pool.hpp>
 
 #include <cubos/engine/cubos.hpp>
 
@@ -125,6 +128,7 @@ Cubos::Cubos(int argc, char** argv)
     this->addResource<DeltaTime>(0.0F);
     this->addResource<ShouldQuit>(true);
     this->addResource<Arguments>(arguments);
+    this->addResource<core::ThreadPool>(std::max(std::thread::hardware_concurrency(), 1U));
 }
 
 void Cubos::run()
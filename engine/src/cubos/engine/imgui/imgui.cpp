@@ -1,5 +1,7 @@
 #include <array>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui.h>
@@ -399,28 +401,64 @@ static void setupRenderState(ImGuiData* bd, gl::Framebuffer target)
     rd.setFramebuffer(std::move(target));
 }
 
+/// @brief Copy of the draw data of an ended ImGui frame.
+struct cubos::engine::ImguiFrame
+{
+    ~ImguiFrame()
+    {
+        for (auto* cmdList : cmdLists)
+        {
+            IM_DELETE(cmdList);
+        }
+    }
+
+    ImGuiData* bd;
+    ImVec2 displayPos;
+    ImVec2 displaySize;
+    std::vector<ImDrawList*> cmdLists;
+};
+
 void cubos::engine::imguiEndFrame(const gl::Framebuffer& target)
 {
-    auto* bd = (ImGuiData*)ImGui::GetIO().BackendPlatformUserData;
-    auto& rd = bd->window->renderDevice();
+    imguiRenderFrame(*imguiRecordFrame(), target);
+}
+
+std::shared_ptr<cubos::engine::ImguiFrame> cubos::engine::imguiRecordFrame()
+{
     ImGui::Render();
     auto* drawData = ImGui::GetDrawData();
 
+    // The draw lists are reused by ImGui on the next frame, so they must be copied.
+    auto frame = std::make_shared<ImguiFrame>();
+    frame->bd = (ImGuiData*)ImGui::GetIO().BackendPlatformUserData;
+    frame->displayPos = drawData->DisplayPos;
+    frame->displaySize = drawData->DisplaySize;
+    for (int n = 0; n < drawData->CmdListsCount; ++n)
+    {
+        frame->cmdLists.push_back(drawData->CmdLists[n]->CloneOutput());
+    }
+    return frame;
+}
+
+void cubos::engine::imguiRenderFrame(const ImguiFrame& frame, const gl::Framebuffer& target)
+{
+    auto* bd = frame.bd;
+    auto& rd = bd->window->renderDevice();
+
     // Upload projection matrix to constant buffer.
     glm::mat4& proj = *(glm::mat4*)bd->cb->map();
-    proj = glm::ortho(drawData->DisplayPos.x, drawData->DisplayPos.x + drawData->DisplaySize.x,
-                      drawData->DisplayPos.y + drawData->DisplaySize.y, drawData->DisplayPos.y);
+    proj = glm::ortho(frame.displayPos.x, frame.displayPos.x + frame.displaySize.x,
+                      frame.displayPos.y + frame.displaySize.y, frame.displayPos.y);
     bd->cb->unmap();
 
     // Set render state.
     setupRenderState(bd, target);
-    rd.setViewport(0, 0, static_cast<int>(drawData->DisplaySize.x), static_cast<int>(drawData->DisplaySize.y));
+    rd.setViewport(0, 0, static_cast<int>(frame.displaySize.x), static_cast<int>(frame.displaySize.y));
 
     // Render command lists.
-    ImVec2 clipOff = drawData->DisplayPos;
-    for (int n = 0; n < drawData->CmdListsCount; ++n)
+    ImVec2 clipOff = frame.displayPos;
+    for (const auto* cmdList : frame.cmdLists)
     {
-        const auto* cmdList = drawData->CmdLists[n];
 
         // Create and grow vertex buffer if needed.
         if (!bd->vb || bd->vbSize < static_cast<std::size_t>(cmdList->VtxBuffer.Size))
@@ -505,7 +543,7 @@ void cubos::engine::imguiEndFrame(const gl::Framebuffer& target)
                 }
 
                 // Apply the scissor/clipping rectangle (with Y flipped)
-                rd.setScissor(clipMin.x, static_cast<int>(drawData->DisplaySize.y) - clipMax.y, clipMax.x - clipMin.x,
+                rd.setScissor(clipMin.x, static_cast<int>(frame.displaySize.y) - clipMax.y, clipMax.x - clipMin.x,
                               clipMax.y - clipMin.y);
 
                 // Bind the texture and draw.
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include <cubos/core/gl/render_device.hpp>
 #include <cubos/core/io/window.hpp>
 
@@ -32,6 +34,24 @@ namespace cubos::engine
     /// @ingroup imgui-plugin
     void imguiEndFrame(const core::gl::Framebuffer& target = nullptr);
 
+    /// @brief Copy of the draw data of an ended ImGui frame, which, unlike ImGui's own, stays
+    /// valid after the next frame begins.
+    /// @ingroup imgui-plugin
+    struct ImguiFrame;
+
+    /// @brief Ends the current ImGui frame, and records its draw data, so that it can be rendered
+    /// later with @ref imguiRenderFrame(), even after the next frame begins.
+    /// @return Recorded frame.
+    /// @ingroup imgui-plugin
+    std::shared_ptr<ImguiFrame> imguiRecordFrame();
+
+    /// @brief Renders a frame recorded by @ref imguiRecordFrame() to the @p target framebuffer, or
+    /// the default framebuffer if @p target is null.
+    /// @param frame Recorded frame.
+    /// @param target Framebuffer to render to.
+    /// @ingroup imgui-plugin
+    void imguiRenderFrame(const ImguiFrame& frame, const core::gl::Framebuffer& target = nullptr);
+
     /// @brief Passes a window event to ImGui.
     /// @param event Event to pass.
     /// @return True if the event was handled by ImGui, false otherwise.
@@ -1,18 +1,20 @@
 #include <cubos/engine/imgui/plugin.hpp>
 #include <cubos/engine/window/plugin.hpp>
+#include <cubos/engine/window/render_thread.hpp>
 
 #include "imgui.hpp"
 
 using cubos::core::ecs::EventReader;
 using cubos::core::ecs::Read;
+using cubos::core::ecs::Write;
 using cubos::core::io::Window;
 using cubos::core::io::WindowEvent;
 
 using namespace cubos::engine;
 
-static void init(Read<Window> window)
+static void init(Read<Window> window, Write<RenderThread> renderThread)
 {
-    imguiInitialize(*window);
+    renderThread->call([&] { imguiInitialize(*window); });
 }
 
 static void begin(EventReader<WindowEvent> events)
@@ -30,9 +32,11 @@ static void begin(EventReader<WindowEvent> events)
     imguiBeginFrame();
 }
 
-static void end()
+static void end(Write<RenderThread> renderThread)
 {
-    imguiEndFrame();
+    // ImGui's draw data is only valid until the next frame begins, so a copy of it is rendered
+    // instead, which lets the next frame begin without waiting for this one to be rendered.
+    renderThread->post([frame = imguiRecordFrame()] { imguiRenderFrame(*frame); });
 }
 
 void cubos::engine::imguiPlugin(Cubos& cubos)
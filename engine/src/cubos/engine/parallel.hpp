@@ -0,0 +1,80 @@
+/// @file
+/// @brief Helper for splitting data-parallel work over the engine's @ref cubos::core::ThreadPool.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include <cubos/core/thread_pool.hpp>
+
+namespace cubos::engine
+{
+    /// @brief Splits the range `[0, count)` into blocks of at most @p blockSize elements and
+    /// calls @p func for each block on the thread pool, blocking until all of them finish.
+    ///
+    /// If the range fits in a single block, @p func is called directly on the calling thread.
+    /// Otherwise, the calling thread also runs blocks, and only waits for the blocks of this call,
+    /// not for other tasks in the pool. Thus, it's safe to call from within a task of the pool,
+    /// and always finishes, even if every thread of the pool is busy.
+    ///
+    /// @tparam F Function type, called as `func(begin, end)`.
+    /// @param pool Thread pool to use.
+    /// @param count Number of elements.
+    /// @param blockSize Maximum number of elements per block.
+    /// @param func Function to call for each block.
+    template <typename F>
+    void parallelFor(core::ThreadPool& pool, std::size_t count, std::size_t blockSize, const F& func)
+    {
+        if (count <= blockSize)
+        {
+            func(std::size_t{0}, count);
+            return;
+        }
+
+        // Shared with the posted tasks, which may only start after this call returns.
+        struct Latch
+        {
+            std::atomic<std::size_t> next{0}; ///< Next block to be claimed.
+            std::size_t done{0};              ///< Number of blocks which finished.
+            std::mutex mutex;                 ///< Protects done.
+            std::condition_variable finished; ///< Notified when every block has finished.
+        };
+
+        auto latch = std::make_shared<Latch>();
+        std::size_t blocks = (count + blockSize - 1) / blockSize;
+
+        // Claims and runs blocks until there are none left. Func is only accessed after claiming a
+        // block, which this call waits for, so it can be captured by reference.
+        auto work = [latch, &func, count, blockSize, blocks]() {
+            std::size_t ran = 0;
+            for (auto block = latch->next++; block < blocks; block = latch->next++, ++ran)
+            {
+                func(block * blockSize, std::min(count, (block + 1) * blockSize));
+            }
+
+            if (ran > 0)
+            {
+                std::unique_lock<std::mutex> lock(latch->mutex);
+                latch->done += ran;
+                if (latch->done == blocks)
+                {
+                    latch->finished.notify_all();
+                }
+            }
+        };
+
+        for (std::size_t i = 1; i < blocks; ++i)
+        {
+            pool.addTask(work);
+        }
+        work();
+
+        std::unique_lock<std::mutex> lock(latch->mutex);
+        latch->finished.wait(lock, [&]() { return latch->done == blocks; });
+    }
+} // namespace cubos::engine
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 #include <random>
+#include <string>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/compatibility.hpp>
@@ -13,6 +17,8 @@
 #include <cubos/engine/renderer/frame.hpp>
 #include <cubos/engine/renderer/vertex.hpp>
 
+#include "../parallel.hpp"
+
 using namespace cubos::core::gl;
 using cubos::engine::DeferredRenderer;
 
@@ -22,80 +28,136 @@ struct DeferredGrid : public cubos::engine::impl::RendererGrid
     VertexArray va;
     IndexBuffer ib;
     std::size_t indexCount;
+    uint32_t id; ///< Identifier of the grid, used to group draws of the same grid together.
+    bool packed; ///< Whether the vertices are stored as @ref cubos::engine::PackedVoxelVertex.
 };
 
-/// Holds the model view matrix sent to the GPU.
-struct MVP
+/// Holds the view and projection matrices sent to the GPU.
+struct VP
 {
-    glm::mat4 m;
     glm::mat4 v;
     glm::mat4 p;
 };
 
-// Holds the data of a spot light, ready to be sent to the lighting pass pipeline.
-struct SpotLightData
+/// Maximum number of instances drawn by a single instanced draw. Their model matrices must fit in
+/// the minimum uniform block size guaranteed by OpenGL, 16 KB.
+static constexpr std::size_t MaxInstanceCount = 256;
+
+/// Number of threads which prepare the work of each camera in parallel. Matches the maximum number
+/// of cameras drawn by the renderer plugin.
+static constexpr std::size_t ViewThreadCount = 4;
+
+/// Initial size of the upload ring, which holds the per-frame constant buffer data. Grows if a
+/// frame needs more.
+static constexpr std::size_t UploadRingSize = 1024 * 1024;
+
+/// Width of the textures which store the lights and the light clusters. Must match the lighting
+/// pass pixel shader.
+static constexpr std::size_t LightTexWidth = 1024;
+
+/// Number of texels used by each light in the light data texture.
+static constexpr std::size_t LightTexelCount = 4;
+
+/// @brief Uploads texels to a texture with @ref LightTexWidth columns and as many rows as needed,
+/// recreating the texture if it doesn't have enough rows.
+/// @param renderDevice Render device.
+/// @param texture Texture to upload to.
+/// @param rowCapacity Number of rows of the texture.
+/// @param format Format of the texture.
+/// @param channels Number of channels of the format.
+/// @param texels Texels to upload. Padded with zeros to fill the last row.
+static void uploadRows(RenderDevice& renderDevice, Texture2D& texture, std::size_t& rowCapacity, TextureFormat format,
+                       std::size_t channels, std::vector<float>& texels)
 {
-    glm::vec4 position;
-    glm::mat4 rotation;
-    glm::vec4 color;
-    float intensity;
-    float range;
-    float spotCutoff;
-    float innerSpotCutoff;
-};
+    auto rows = std::max<std::size_t>((texels.size() / channels + LightTexWidth - 1) / LightTexWidth, 1);
+    if (texture == nullptr || rows > rowCapacity)
+    {
+        rowCapacity = std::max(rows, rowCapacity * 2);
+        Texture2DDesc desc;
+        desc.width = LightTexWidth;
+        desc.height = rowCapacity;
+        desc.format = format;
+        desc.usage = Usage::Dynamic;
+        texture = renderDevice.createTexture2D(desc);
+    }
 
-// Holds the data of a directional light, ready to be sent to the lighting pass pipeline.
-struct DirectionalLightData
-{
-    glm::mat4 rotation;
-    glm::vec4 color;
-    float intensity;
-    float padding[3]; // Necessary to align the struct to a 16 byte boundary.
-};
+    texels.resize(rows * LightTexWidth * channels, 0.0F);
+    texture->update(0, 0, LightTexWidth, rows, texels.data());
+}
 
-// Holds the data of a point light, ready to be sent to the lighting pass pipeline.
-struct PointLightData
+/// @brief Computes the key by which draw commands are sorted.
+///
+/// The highest 8 bits identify the pipeline, the next 24 bits the grid, and the lowest 32 bits the
+/// view depth of the grid, so that state changes are minimised and each grid is drawn front to back.
+/// @param drawCmd Draw command.
+/// @param view View matrix.
+/// @return Sort key.
+static uint64_t drawKey(const cubos::engine::RendererFrame::DrawCmd& drawCmd, const glm::mat4& view)
 {
-    glm::vec4 position;
-    glm::vec4 color;
-    float intensity;
-    float range;
-    float padding[2]; // Necessary to align the struct to a 16 byte boundary.
-};
+    const auto& grid = static_cast<const DeferredGrid&>(*drawCmd.grid);
 
-/// Holds all of the light data sent to the lighting pass pipeline.
+    // Grids whose vertices couldn't be packed are drawn with the unpacked geometry pipeline.
+    uint64_t pipeline = grid.packed ? 0 : 1;
+
+    // Non-negative floats keep their order when their bits are compared as integers.
+    auto center = drawCmd.modelMat * glm::vec4((grid.min + grid.max) / 2.0F, 1.0F);
+    float depth = -(view * center).z;
+    if (!(depth > 0.0F))
+    {
+        depth = 0.0F;
+    }
+
+    return pipeline << 56 | static_cast<uint64_t>(grid.id & 0xFFFFFF) << 32 | std::bit_cast<uint32_t>(depth);
+}
+
+/// Holds the light data which isn't stored in the light textures.
 struct LightsData
 {
     glm::vec4 ambientLight;
-    SpotLightData spotLights[CUBOS_DEFERRED_RENDERER_MAX_SPOT_LIGHT_COUNT];
-    DirectionalLightData directionalLights[CUBOS_DEFERRED_RENDERER_MAX_DIRECTIONAL_LIGHT_COUNT];
-    PointLightData pointLights[CUBOS_DEFERRED_RENDERER_MAX_POINT_LIGHT_COUNT];
-    uint32_t numSpotLights;
+    uint32_t numLocalLights;
     uint32_t numDirectionalLights;
-    uint32_t numPointLights;
+    float padding[2]; // Necessary to align the struct to a 16 byte boundary.
 };
 
-/// The vertex shader of the geometry pass pipeline.
+/// The vertex shader of the geometry pass pipeline, without its version directive. Vertices are
+/// read as stored by PackedVoxelVertex if PACKED_VERTICES is defined, and as VoxelVertex otherwise.
 static const char* geometryPassVs = R"glsl(
-#version 330 core
-
+#ifdef PACKED_VERTICES
+in uvec2 data;
+#else
 in uvec3 position;
 in vec3 normal;
 in uint material;
+#endif
 
 out vec3 fragPosition;
 out vec3 fragNormal;
 flat out uint fragMaterial;
 
-uniform MVP
+layout(std140) uniform VP
 {
-    mat4 M;
     mat4 V;
     mat4 P;
 };
 
+// Model matrices of the instances being drawn. Must match MaxInstanceCount.
+layout(std140) uniform Instances
+{
+    mat4 models[256];
+};
+
 void main()
 {
+#ifdef PACKED_VERTICES
+    // Unpack the vertex, as stored by PackedVoxelVertex.
+    uvec3 position = uvec3(data.x & 0x3FFFu, (data.x >> 14u) & 0x3FFFu, data.y & 0xFFFFu);
+    uint normalIndex = (data.x >> 28u) & 7u;
+    vec3 normal = vec3(0.0);
+    normal[int(normalIndex / 2u)] = (normalIndex % 2u) == 0u ? 1.0 : -1.0;
+    uint material = data.y >> 16u;
+#endif
+
+    mat4 M = models[gl_InstanceID];
     vec4 worldPosition = M * vec4(position, 1.0);
     vec4 viewPosition = V * worldPosition;
     fragPosition = vec3(worldPosition);
@@ -168,41 +230,36 @@ uniform vec2 uvOffset;
 uniform mat4 invV;
 uniform mat4 invP;
 
-struct SpotLight
-{
-    vec4 position;
-    mat4 rotation;
-    vec4 color;
-    float intensity;
-    float range;
-    float spotCutoff;
-    float innerSpotCutoff;
-};
+// Must match LightTexWidth, and the number of clusters of LightClusters.
+#define LIGHT_TEX_WIDTH 1024u
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES 24
 
-struct DirectionalLight
-{
-    mat4 rotation;
-    vec4 color;
-    float intensity;
-};
+// Each light takes 4 texels. Local lights store their position and range, color and intensity,
+// spot direction and cutoff, and inner spot cutoff and whether they are spot lights.
+// Directional lights store their direction, and color and intensity.
+uniform sampler2D lightData;
 
-struct PointLight
-{
-    vec4 position;
-    vec4 color;
-    float intensity;
-    float range;
-};
+// Offset and number of light indices of each cluster.
+uniform sampler2D clusterRanges;
+
+// Indices of the local lights of every cluster, one cluster after another.
+uniform sampler2D clusterIndices;
+
+// Near plane, and number of slices divided by log(zFar / zNear).
+uniform vec2 clusterParams;
+uniform mat4 view;
+
+// Index of the first cluster of the camera being drawn, as the clusters of every camera are stored
+// one after another.
+uniform uint clusterOffset;
 
 layout(std140) uniform Lights
 {
     vec4 ambientLight;
-    SpotLight spotLights[128];
-    DirectionalLight directionalLights[128];
-    PointLight pointLights[128];
-    uint numSpotLights;
+    uint numLocalLights;
     uint numDirectionalLights;
-    uint numPointLights;
 };
 
 layout(location = 0) out vec4 color;
@@ -211,36 +268,51 @@ float remap(float value, float min1, float max1, float min2, float max2) {
     return max2 + (value - min1) * (max2 - min2) / (max1 - min1);
 }
 
-vec3 spotLightCalc(vec3 fragPos, vec3 fragNormal, SpotLight light) {
-    vec3 toLight = vec3(light.position) - fragPos;
-    float r = length(toLight) / light.range;
+ivec2 texelCoord(uint index) {
+    return ivec2(int(index % LIGHT_TEX_WIDTH), int(index / LIGHT_TEX_WIDTH));
+}
+
+vec4 lightTexel(uint light, uint texel) {
+    return texelFetch(lightData, texelCoord(light * 4u + texel), 0);
+}
+
+vec3 localLightCalc(vec3 fragPos, vec3 fragNormal, uint light) {
+    vec4 positionRange = lightTexel(light, 0u);
+    vec4 colorIntensity = lightTexel(light, 1u);
+    vec4 directionCutoff = lightTexel(light, 2u);
+    vec4 innerCutoffSpot = lightTexel(light, 3u);
+    vec3 toLight = positionRange.xyz - fragPos;
+    float r = length(toLight) / positionRange.w;
     if (r < 1) {
         vec3 toLightNormalized = normalize(toLight);
-        float a = dot(toLightNormalized, -vec3(light.rotation * vec4(0,0,1,1)));
-        if (a > light.spotCutoff) {
-            float angleValue = clamp(remap(a, light.innerSpotCutoff, light.spotCutoff, 1, 0), 0, 1);
-            float attenuation = clamp(1.0 / (1.0 + 25.0 * r * r) * clamp((1 - r) * 5.0, 0, 1), 0 , 1);
-            float diffuse = max(dot(fragNormal, toLightNormalized), 0);
-            return angleValue * attenuation * diffuse * light.intensity * vec3(light.color);
+        float angleValue = 1.0;
+        if (innerCutoffSpot.y > 0.5) {
+            float a = dot(toLightNormalized, -directionCutoff.xyz);
+            if (a <= directionCutoff.w) {
+                return vec3(0);
+            }
+            angleValue = clamp(remap(a, innerCutoffSpot.x, directionCutoff.w, 1, 0), 0, 1);
         }
+        float attenuation = clamp(1.0 / (1.0 + 25.0 * r * r) * clamp((1 - r) * 5.0, 0, 1), 0, 1);
+        float diffuse = max(dot(fragNormal, toLightNormalized), 0);
+        return angleValue * attenuation * diffuse * colorIntensity.w * colorIntensity.rgb;
     }
     return vec3(0);
 }
 
-vec3 directionalLightCalc(vec3 fragNormal, DirectionalLight light)
+vec3 directionalLightCalc(vec3 fragNormal, uint light)
 {
-    return max(dot(fragNormal, -vec3(light.rotation * vec4(0,0,1,1))), 0) * light.intensity * vec3(light.color);
+    vec4 direction = lightTexel(light, 0u);
+    vec4 colorIntensity = lightTexel(light, 1u);
+    return max(dot(fragNormal, -direction.xyz), 0) * colorIntensity.w * colorIntensity.rgb;
 }
 
-vec3 pointLightCalc(vec3 fragPos, vec3 fragNormal, PointLight light) {
-    vec3 toLight = vec3(light.position) - fragPos;
-    float r = length(toLight) / light.range;
-    if (r < 1) {
-        float attenuation = clamp(1.0 / (1.0 + 25.0 * r * r) * clamp((1 - r) * 5.0, 0, 1), 0, 1);
-        float diffuse = max(dot(fragNormal, vec3(normalize(toLight))), 0);
-        return attenuation * diffuse * light.intensity * vec3(light.color);
-    }
-    return vec3(0);
+uint clusterIndex(vec2 screenUv, vec3 fragPos) {
+    ivec2 tile = clamp(ivec2(screenUv * vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y)), ivec2(0),
+                       ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+    float depth = max(-(view * vec4(fragPos, 1.0)).z, clusterParams.x);
+    int slice = clamp(int(floor(log(depth / clusterParams.x) * clusterParams.y)), 0, CLUSTER_SLICES - 1);
+    return clusterOffset + uint(tile.x + tile.y * CLUSTER_TILES_X + slice * CLUSTER_TILES_X * CLUSTER_TILES_Y);
 }
 
 vec4 fetchAlbedo(uint material)
@@ -270,14 +342,13 @@ void main()
         vec3 lighting = ambientLight.rgb;
         vec3 fragPos = texture(position, fragUv).xyz;
         vec3 fragNormal = texture(normal, fragUv).xyz;
-        for (uint i = 0u; i < numSpotLights; i++) {
-            lighting += spotLightCalc(fragPos, fragNormal, spotLights[i]);
+        vec2 range = texelFetch(clusterRanges, texelCoord(clusterIndex((fragUv - uvOffset) / uvScale, fragPos)), 0).rg;
+        for (uint i = 0u; i < uint(range.y); i++) {
+            uint light = uint(texelFetch(clusterIndices, texelCoord(uint(range.x) + i), 0).r);
+            lighting += localLightCalc(fragPos, fragNormal, light);
         }
         for (uint i = 0u; i < numDirectionalLights; i++) {
-            lighting += directionalLightCalc(fragNormal, directionalLights[i]);
-        }
-        for (uint i = 0u; i < numPointLights; i++) {
-            lighting += pointLightCalc(fragPos, fragNormal, pointLights[i]);
+            lighting += directionalLightCalc(fragNormal, numLocalLights + i);
         }
         color = vec4(albedo * lighting, 1.0);
         color.r = min(color.r, 1.0);
@@ -299,10 +370,13 @@ in vec2 uv;
 
 out vec2 fragUv;
 
+uniform vec2 uvScale;
+uniform vec2 uvOffset;
+
 void main(void)
 {
     gl_Position = position;
-    fragUv = uv;
+    fragUv = uv * uvScale + uvOffset;
 }
 )glsl";
 
@@ -319,11 +393,17 @@ in vec2 fragUv;
 uniform sampler2D position;
 uniform sampler2D normal;
 uniform sampler2D noise;
-uniform vec3 samples[KERNEL_SIZE];
 uniform mat4 view;
 uniform mat4 projection;
 uniform vec2 screenSize;
+uniform vec2 uvScale;
+uniform vec2 uvOffset;
 
+// Samples of the hemisphere around each pixel. Padded to vec4, as in std140.
+layout(std140) uniform Kernel
+{
+    vec4 samples[KERNEL_SIZE];
+};
 
 layout (location = 0) out float color;
 
@@ -352,13 +432,14 @@ void main(void)
     float occlusion = 0.0;
     for(int i = 0; i < KERNEL_SIZE; i++)
     {
-        vec3 samplePos = TBN * samples[i];
+        vec3 samplePos = TBN * samples[i].xyz;
         samplePos = fragPos + samplePos * RADIUS;
 
         vec4 offset = vec4(samplePos, 1.0);
         offset = projection * offset;
         offset.xyz /= offset.w;
         offset.xyz = offset.xyz * 0.5 + 0.5;
+        offset.xy = offset.xy * uvScale + uvOffset;
 
         float sampleDepth = getFragPos(offset.xy).z;
         float rangeCheck = smoothstep(0.0, 1.0, RADIUS / abs(fragPos.z - sampleDepth));
@@ -370,33 +451,52 @@ void main(void)
 }
 )glsl";
 
-// The pixel shader of the SSAO blur pass pipeline.
-static const char* ssaoBlurPs = R"glsl(
+// The pixel shader of the SSAO upsample pass pipeline. Blurs the 4x4 texels of the lower
+// resolution SSAO texture around each pixel, weighting each by how close its depth is to the
+// pixel's, so that occlusion doesn't bleed across edges.
+static const char* ssaoUpsamplePs = R"glsl(
 #version 330 core
 
+#define DEPTH_SHARPNESS 16.0
+
 in vec2 fragUv;
 
 uniform sampler2D ssaoInput;
+uniform sampler2D position;
+uniform mat4 view;
 
 layout (location = 0) out float color;
 
+float viewDepth(vec2 uv) {
+    return -(view * vec4(texture(position, uv).xyz, 1.0)).z;
+}
+
 void main() {
-    vec2 texelSize = 1.0 / vec2(textureSize(ssaoInput, 0));
+    vec2 inputSize = vec2(textureSize(ssaoInput, 0));
+    ivec2 first = ivec2(floor(fragUv * inputSize - 0.5)) - 1;
+    float depth = max(viewDepth(fragUv), 0.001);
     float result = 0.0;
-    for (int x = -2; x < 2; ++x)
+    float totalWeight = 0.0;
+    for (int x = 0; x < 4; ++x)
     {
-        for (int y = -2; y < 2; ++y)
+        for (int y = 0; y < 4; ++y)
         {
-            vec2 offset = vec2(float(x), float(y)) * texelSize;
-            result += texture(ssaoInput, fragUv + offset).r;
+            ivec2 texel = clamp(first + ivec2(x, y), ivec2(0), ivec2(inputSize) - 1);
+            float sampleDepth = viewDepth((vec2(texel) + 0.5) / inputSize);
+            float weight = 0.0001 + exp(-abs(sampleDepth - depth) / depth * DEPTH_SHARPNESS);
+            result += texelFetch(ssaoInput, texel, 0).r * weight;
+            totalWeight += weight;
         }
     }
-    color = result / (4.0 * 4.0);
+    color = result / totalWeight;
 }
 )glsl";
 
 DeferredRenderer::DeferredRenderer(RenderDevice& renderDevice, glm::uvec2 size, Settings& settings)
     : BaseRenderer(renderDevice, size)
+    , mReleasedGrids(std::make_shared<ReleasedGrids>())
+    , mUploads(renderDevice, UploadRingSize)
+    , mViewPool(ViewThreadCount)
 {
     // Create the states.
     RasterStateDesc rasterStateDesc;
@@ -413,14 +513,19 @@ DeferredRenderer::DeferredRenderer(RenderDevice& renderDevice, glm::uvec2 size,
     depthStencilStateDesc.depth.writeEnabled = true;
     mGeometryDepthStencilState = mRenderDevice.createDepthStencilState(depthStencilStateDesc);
 
-    // Create the geometry pipeline.
-    auto geometryVS = mRenderDevice.createShaderStage(Stage::Vertex, geometryPassVs);
+    // Create the geometry pipelines, for packed and unpacked vertices.
+    auto geometryVS = mRenderDevice.createShaderStage(
+        Stage::Vertex, (std::string("#version 330 core\n#define PACKED_VERTICES\n") + geometryPassVs).c_str());
     auto geometryPS = mRenderDevice.createShaderStage(Stage::Pixel, geometryPassPs);
     mGeometryPipeline = mRenderDevice.createShaderPipeline(geometryVS, geometryPS);
-    mVpBp = mGeometryPipeline->getBindingPoint("MVP");
+    mVpBp = mGeometryPipeline->getBindingPoint("VP");
+    mInstancesBp = mGeometryPipeline->getBindingPoint("Instances");
 
-    // Create the MVP constant buffer.
-    mVpBuffer = renderDevice.createConstantBuffer(sizeof(MVP), nullptr, Usage::Dynamic);
+    auto unpackedGeometryVS = mRenderDevice.createShaderStage(
+        Stage::Vertex, (std::string("#version 330 core\n") + geometryPassVs).c_str());
+    mUnpackedGeometryPipeline = mRenderDevice.createShaderPipeline(unpackedGeometryVS, geometryPS);
+    mUnpackedVpBp = mUnpackedGeometryPipeline->getBindingPoint("VP");
+    mUnpackedInstancesBp = mUnpackedGeometryPipeline->getBindingPoint("Instances");
 
     // Create the lighting pipeline.
     auto lightingVS = mRenderDevice.createShaderStage(Stage::Vertex, lightingPassVs);
@@ -431,6 +536,12 @@ DeferredRenderer::DeferredRenderer(RenderDevice& renderDevice, glm::uvec2 size,
     mMaterialBp = mLightingPipeline->getBindingPoint("material");
     mPaletteBp = mLightingPipeline->getBindingPoint("palette");
     mLightsBp = mLightingPipeline->getBindingPoint("Lights");
+    mLightDataBp = mLightingPipeline->getBindingPoint("lightData");
+    mClusterRangesBp = mLightingPipeline->getBindingPoint("clusterRanges");
+    mClusterIndicesBp = mLightingPipeline->getBindingPoint("clusterIndices");
+    mClusterParamsBp = mLightingPipeline->getBindingPoint("clusterParams");
+    mClusterOffsetBp = mLightingPipeline->getBindingPoint("clusterOffset");
+    mViewBp = mLightingPipeline->getBindingPoint("view");
     mSsaoEnabledBp = mLightingPipeline->getBindingPoint("ssaoEnabled");
     mSsaoTexBp = mLightingPipeline->getBindingPoint("ssaoTex");
     mUVScaleBp = mLightingPipeline->getBindingPoint("uvScale");
@@ -450,11 +561,18 @@ DeferredRenderer::DeferredRenderer(RenderDevice& renderDevice, glm::uvec2 size,
     mSsaoViewBp = mSsaoPipeline->getBindingPoint("view");
     mSsaoProjectionBp = mSsaoPipeline->getBindingPoint("projection");
     mSsaoScreenSizeBp = mSsaoPipeline->getBindingPoint("screenSize");
-
-    // Create the SSAO blur pipeline.
-    auto ssaoBlurPS = mRenderDevice.createShaderStage(Stage::Pixel, ssaoBlurPs);
-    mSsaoBlurPipeline = mRenderDevice.createShaderPipeline(ssaoVS, ssaoBlurPS);
-    mSsaoBlurTexBp = mSsaoBlurPipeline->getBindingPoint("ssaoInput");
+    mSsaoUVScaleBp = mSsaoPipeline->getBindingPoint("uvScale");
+    mSsaoUVOffsetBp = mSsaoPipeline->getBindingPoint("uvOffset");
+    mSsaoKernelBp = mSsaoPipeline->getBindingPoint("Kernel");
+
+    // Create the SSAO upsample pipeline.
+    auto ssaoUpsamplePS = mRenderDevice.createShaderStage(Stage::Pixel, ssaoUpsamplePs);
+    mSsaoUpsamplePipeline = mRenderDevice.createShaderPipeline(ssaoVS, ssaoUpsamplePS);
+    mSsaoUpsampleInputBp = mSsaoUpsamplePipeline->getBindingPoint("ssaoInput");
+    mSsaoUpsamplePositionBp = mSsaoUpsamplePipeline->getBindingPoint("position");
+    mSsaoUpsampleViewBp = mSsaoUpsamplePipeline->getBindingPoint("view");
+    mSsaoUpsampleUVScaleBp = mSsaoUpsamplePipeline->getBindingPoint("uvScale");
+    mSsaoUpsampleUVOffsetBp = mSsaoUpsamplePipeline->getBindingPoint("uvOffset");
 
     // Create the sampler used to access the palette and the GBuffer textures in the lighting pipeline.
     SamplerDesc samplerDesc;
@@ -476,9 +594,6 @@ DeferredRenderer::DeferredRenderer(RenderDevice& renderDevice, glm::uvec2 size,
     texDesc.usage = Usage::Default;
     mPaletteTex = mRenderDevice.createTexture2D(texDesc);
 
-    // Create the lights constant buffer.
-    mLightsBuffer = mRenderDevice.createConstantBuffer(sizeof(LightsData), nullptr, Usage::Dynamic);
-
     // Generate a screen quad for the lighting pass.
     generateScreenQuad(mRenderDevice, mLightingPipeline, mScreenQuadVa);
 
@@ -486,8 +601,10 @@ DeferredRenderer::DeferredRenderer(RenderDevice& renderDevice, glm::uvec2 size,
     mSize = glm::uvec2(0, 0);
     DeferredRenderer::onResize(size);
 
-    // Check whether SSAO is enabled.
+    // Check whether SSAO is enabled, and at which resolution it's computed.
     mSsaoEnabled = settings.getBool("renderer.ssao.enabled", false);
+    auto downscale = settings.getInteger("renderer.ssao.downscale", 2);
+    mSsaoDownscale = downscale >= 4 ? 4U : (downscale >= 2 ? 2U : 1U);
     if (mSsaoEnabled)
     {
         createSSAOTextures();
@@ -500,54 +617,123 @@ DeferredRenderer::DeferredRenderer(RenderDevice& renderDevice, glm::uvec2 size,
 
 DeferredRenderer::~DeferredRenderer()
 {
+    std::lock_guard<std::mutex> lock(mReleasedGrids->mutex);
+    mReleasedGrids->grids.clear();
+
     /// FIXME: This should not be on production code.
     core::gl::Debug::terminate();
 }
 
-cubos::engine::RendererGrid DeferredRenderer::upload(const VoxelGrid& grid)
+cubos::engine::RendererGrid DeferredRenderer::upload(const VoxelMesh& mesh)
 {
-    auto deferredGrid = std::make_shared<DeferredGrid>();
+    // Instead of being destroyed, dropped grids are handed back to the renderer, which destroys
+    // them when it next renders.
+    auto release = [released = mReleasedGrids](DeferredGrid* grid) {
+        std::lock_guard<std::mutex> lock(released->mutex);
+        released->grids.emplace_back(grid);
+    };
+    auto deferredGrid = std::shared_ptr<DeferredGrid>(new DeferredGrid{}, release);
+
+    // Identifiers of destroyed grids are reused, so that live grids keep distinct identifiers
+    // within the 24 bits they take in the draw sort key.
+    if (mFreeGridIds.empty())
+    {
+        deferredGrid->id = mNextGridId++;
+    }
+    else
+    {
+        deferredGrid->id = mFreeGridIds.back();
+        mFreeGridIds.pop_back();
+    }
+
+    // Find the bounding box of the mesh.
+    glm::uvec3 min{UINT32_MAX};
+    glm::uvec3 max{0};
+    for (const auto& vertex : mesh.vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
 
-    // First, triangulate the grid.
-    // This may be improved in the future by doing it in a separate thread and only blocking on it when the grid needs
-    // to be drawn.
-    std::vector<VoxelVertex> vertices;
-    std::vector<uint32_t> indices;
-    triangulate(grid, vertices, indices);
+    if (!mesh.vertices.empty())
+    {
+        deferredGrid->min = glm::vec3(min);
+        deferredGrid->max = glm::vec3(max);
+    }
 
-    // Create the vertex array, vertex buffer and index buffer.
+    // Create the vertex array, vertex buffer and index buffer. Vertices are packed, so that they
+    // take 8 bytes each instead of 28, unless the mesh is too large for their positions to fit.
+    deferredGrid->packed =
+        max.x <= PackedVoxelVertex::MaxXY && max.y <= PackedVoxelVertex::MaxXY && max.z <= PackedVoxelVertex::MaxZ;
     VertexArrayDesc vaDesc;
-    vaDesc.elementCount = 3;
-    vaDesc.elements[0].name = "position";
-    vaDesc.elements[0].type = Type::UInt;
-    vaDesc.elements[0].size = 3;
-    vaDesc.elements[0].buffer.index = 0;
-    vaDesc.elements[0].buffer.offset = offsetof(VoxelVertex, position);
-    vaDesc.elements[0].buffer.stride = sizeof(VoxelVertex);
-    vaDesc.elements[1].name = "normal";
-    vaDesc.elements[1].type = Type::Float;
-    vaDesc.elements[1].size = 3;
-    vaDesc.elements[1].buffer.index = 0;
-    vaDesc.elements[1].buffer.offset = offsetof(VoxelVertex, normal);
-    vaDesc.elements[1].buffer.stride = sizeof(VoxelVertex);
-    vaDesc.elements[2].name = "material";
-    vaDesc.elements[2].type = Type::UShort;
-    vaDesc.elements[2].size = 1;
-    vaDesc.elements[2].buffer.index = 0;
-    vaDesc.elements[2].buffer.offset = offsetof(VoxelVertex, material);
-    vaDesc.elements[2].buffer.stride = sizeof(VoxelVertex);
-    vaDesc.buffers[0] =
-        mRenderDevice.createVertexBuffer(vertices.size() * sizeof(VoxelVertex), vertices.data(), Usage::Static);
-    vaDesc.shaderPipeline = mGeometryPipeline;
+    if (deferredGrid->packed)
+    {
+        std::vector<PackedVoxelVertex> vertices(mesh.vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            vertices[i] = PackedVoxelVertex::pack(mesh.vertices[i]);
+        }
+
+        vaDesc.elementCount = 1;
+        vaDesc.elements[0].name = "data";
+        vaDesc.elements[0].type = Type::UInt;
+        vaDesc.elements[0].size = 2;
+        vaDesc.elements[0].buffer.index = 0;
+        vaDesc.elements[0].buffer.offset = 0;
+        vaDesc.elements[0].buffer.stride = sizeof(PackedVoxelVertex);
+        vaDesc.buffers[0] = mRenderDevice.createVertexBuffer(vertices.size() * sizeof(PackedVoxelVertex),
+                                                             vertices.data(), Usage::Static);
+        vaDesc.shaderPipeline = mGeometryPipeline;
+    }
+    else
+    {
+        vaDesc.elementCount = 3;
+        vaDesc.elements[0].name = "position";
+        vaDesc.elements[0].type = Type::UInt;
+        vaDesc.elements[0].size = 3;
+        vaDesc.elements[0].buffer.index = 0;
+        vaDesc.elements[0].buffer.offset = offsetof(VoxelVertex, position);
+        vaDesc.elements[0].buffer.stride = sizeof(VoxelVertex);
+        vaDesc.elements[1].name = "normal";
+        vaDesc.elements[1].type = Type::Float;
+        vaDesc.elements[1].size = 3;
+        vaDesc.elements[1].buffer.index = 0;
+        vaDesc.elements[1].buffer.offset = offsetof(VoxelVertex, normal);
+        vaDesc.elements[1].buffer.stride = sizeof(VoxelVertex);
+        vaDesc.elements[2].name = "material";
+        vaDesc.elements[2].type = Type::UShort;
+        vaDesc.elements[2].size = 1;
+        vaDesc.elements[2].buffer.index = 0;
+        vaDesc.elements[2].buffer.offset = offsetof(VoxelVertex, material);
+        vaDesc.elements[2].buffer.stride = sizeof(VoxelVertex);
+        vaDesc.buffers[0] = mRenderDevice.createVertexBuffer(mesh.vertices.size() * sizeof(VoxelVertex),
+                                                             mesh.vertices.data(), Usage::Static);
+        vaDesc.shaderPipeline = mUnpackedGeometryPipeline;
+    }
     deferredGrid->va = mRenderDevice.createVertexArray(vaDesc);
-    deferredGrid->ib = mRenderDevice.createIndexBuffer(indices.size() * sizeof(uint32_t), indices.data(),
-                                                       IndexFormat::UInt, Usage::Static);
-    deferredGrid->indexCount = indices.size();
+
+    // Most meshes have few enough vertices to be indexed with 16 bit indices.
+    if (mesh.vertices.size() <= 65536)
+    {
+        std::vector<uint16_t> indices(mesh.indices.size());
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            indices[i] = static_cast<uint16_t>(mesh.indices[i]);
+        }
+        deferredGrid->ib = mRenderDevice.createIndexBuffer(indices.size() * sizeof(uint16_t), indices.data(),
+                                                           IndexFormat::UShort, Usage::Static);
+    }
+    else
+    {
+        deferredGrid->ib = mRenderDevice.createIndexBuffer(mesh.indices.size() * sizeof(uint32_t),
+                                                           mesh.indices.data(), IndexFormat::UInt, Usage::Static);
+    }
+    deferredGrid->indexCount = mesh.indices.size();
 
     return deferredGrid;
 }
 
-void DeferredRenderer::setPalette(const VoxelPalette& palette)
+void DeferredRenderer::onSetPalette(const VoxelPalette& palette)
 {
     // Get the colors from the palette.
     // Magenta is used for non-existent materials in order to easily identify errors.
@@ -606,98 +792,205 @@ void DeferredRenderer::onResize(glm::uvec2 size)
     }
 }
 
-void DeferredRenderer::onRender(const glm::mat4& view, const Viewport& viewport, const Camera& camera,
-                                const RendererFrame& frame, Framebuffer target)
+void DeferredRenderer::onRender(std::span<const CameraView> views, const RendererFrame& frame, Framebuffer target)
 {
     // Steps:
-    // 1. Prepare the MVP matrix.
-    // 2. Fill the light buffer with the light data.
-    // 3. Set the renderer state.
+    // 0. Destroy the grids released since the last render.
+    // 1. Fill the light data texture, which is shared by every camera.
+    // 2. Prepare the work of each camera, in parallel:
+    //   1. Compute the VP matrices.
+    //   2. Bin the local lights into the clusters of the camera.
+    //   3. Sort the draw commands which may be visible.
+    //   4. Group the sorted draw commands into instanced batches.
+    // 3. Upload the data of every camera at once:
+    //   1. Fill the cluster textures.
+    //   2. Write the VP matrices and the model matrices of every batch to the upload ring.
     // 4. Geometry pass:
     //   1. Set the geometry pass state.
     //   2. Clear the GBuffer.
-    //   3. For each draw command:
-    //     1. Update the MVP constant buffer with the model matrix.
-    //     2. Draw the geometry.
-    // 5. Lighting pass:
+    //   3. Draw each batch, to the viewport of its camera.
+    // 5. SSAO pass, at a lower resolution, then blurred and upsampled, for the viewport of each camera.
+    // 6. Lighting pass:
     //   1. Set the lighting pass state.
-    //   2. Draw the screen quad.
-
-    // 1. Prepare the MVP matrix.
-    MVP mvp;
-    mvp.v = view;
-    mvp.p = glm::perspective(glm::radians(camera.fovY), float(viewport.size.x) / float(viewport.size.y), camera.zNear,
-                             camera.zFar);
-
-    // 2. Fill the light buffer with the light data.
-    // First map the buffer.
-    LightsData& lightData = *static_cast<LightsData*>(mLightsBuffer->map());
-    lightData.numSpotLights = 0;
-    lightData.numDirectionalLights = 0;
-    lightData.numPointLights = 0;
-
-    // Set the ambient light.
-    lightData.ambientLight = glm::vec4(frame.ambient(), 1.0F);
+    //   2. Draw the screen quad, for the viewport of each camera.
 
-    // Spotlights.
-    for (const auto& [transform, light] : frame.spotLights())
+    // 0. Destroy the grids released since the last render, and free their identifiers.
     {
-        if (lightData.numSpotLights >= CUBOS_DEFERRED_RENDERER_MAX_SPOT_LIGHT_COUNT)
+        std::lock_guard<std::mutex> lock(mReleasedGrids->mutex);
+        for (const auto& grid : mReleasedGrids->grids)
         {
-            CUBOS_WARN("Number of spot lights to be drawn "
-                       "this frame exceeds the maximum allowed ({}).",
-                       CUBOS_DEFERRED_RENDERER_MAX_SPOT_LIGHT_COUNT);
-            break;
+            mFreeGridIds.push_back(static_cast<const DeferredGrid&>(*grid).id);
         }
+        mReleasedGrids->grids.clear();
+    }
 
-        lightData.spotLights[lightData.numSpotLights].position = transform * glm::vec4(0.0F, 0.0F, 0.0F, 1.0F);
-        lightData.spotLights[lightData.numSpotLights].rotation = glm::toMat4(glm::quat_cast(transform));
-        lightData.spotLights[lightData.numSpotLights].color = glm::vec4(light.color, 1.0F);
-        lightData.spotLights[lightData.numSpotLights].intensity = light.intensity;
-        lightData.spotLights[lightData.numSpotLights].range = light.range;
-        lightData.spotLights[lightData.numSpotLights].spotCutoff = glm::cos(light.spotAngle);
-        lightData.numSpotLights += 1;
+    // 1. Fill the light data texture. Spot and point lights are stored first, as local lights,
+    // followed by the directional lights.
+    auto lightCount = frame.spotLights().size() + frame.pointLights().size() + frame.directionalLights().size();
+    mLightTexels.clear();
+    mLightTexels.reserve(lightCount * LightTexelCount * 4);
+    mClusterLights.clear();
+    auto pushTexel = [&](glm::vec3 xyz, float w) {
+        mLightTexels.insert(mLightTexels.end(), {xyz.x, xyz.y, xyz.z, w});
+    };
+
+    // 1.1. Spot lights.
+    for (const auto& [transform, light] : frame.spotLights())
+    {
+        auto position = glm::vec3(transform * glm::vec4(0.0F, 0.0F, 0.0F, 1.0F));
+        auto direction = glm::vec3(glm::toMat4(glm::quat_cast(transform)) * glm::vec4(0.0F, 0.0F, 1.0F, 0.0F));
+        auto spotCutoff = glm::cos(light.spotAngle);
+        pushTexel(position, light.range);
+        pushTexel(light.color, light.intensity);
+        pushTexel(direction, spotCutoff);
+        pushTexel({0.0F, 1.0F, 0.0F}, 0.0F);
+        mClusterLights.push_back({position, light.range, direction, spotCutoff});
+    }
+
+    // 1.2. Point lights.
+    for (const auto& [transform, light] : frame.pointLights())
+    {
+        auto position = glm::vec3(transform * glm::vec4(0.0F, 0.0F, 0.0F, 1.0F));
+        pushTexel(position, light.range);
+        pushTexel(light.color, light.intensity);
+        pushTexel({0.0F, 0.0F, 0.0F}, -1.0F);
+        pushTexel({0.0F, 0.0F, 0.0F}, 0.0F);
+        mClusterLights.push_back({position, light.range, {0.0F, 0.0F, 0.0F}, -1.0F});
     }
 
-    // Directional lights.
+    // 1.3. Directional lights.
     for (const auto& [transform, light] : frame.directionalLights())
     {
-        if (lightData.numDirectionalLights >= CUBOS_DEFERRED_RENDERER_MAX_DIRECTIONAL_LIGHT_COUNT)
+        auto direction = glm::vec3(glm::toMat4(glm::quat_cast(transform)) * glm::vec4(0.0F, 0.0F, 1.0F, 0.0F));
+        pushTexel(direction, 0.0F);
+        pushTexel(light.color, light.intensity);
+        pushTexel({0.0F, 0.0F, 0.0F}, 0.0F);
+        pushTexel({0.0F, 0.0F, 0.0F}, 0.0F);
+    }
+
+    uploadRows(mRenderDevice, mLightDataTex, mLightDataTexRows, TextureFormat::RGBA32Float, 4, mLightTexels);
+
+    // 1.4. Upload the remaining light data.
+    LightsData lightData{};
+    lightData.ambientLight = glm::vec4(frame.ambient(), 1.0F);
+    lightData.numLocalLights = static_cast<uint32_t>(mClusterLights.size());
+    lightData.numDirectionalLights = static_cast<uint32_t>(frame.directionalLights().size());
+    auto lightsRange = mUploads.upload(&lightData, sizeof(LightsData));
+
+    // 2. Prepare the work of each camera, in parallel, as it only reads the frame. This only waits
+    //    for the cameras of this frame, not for other tasks of the pool.
+    auto alignment = mUploads.alignment();
+    mViewPasses.resize(views.size());
+    parallelFor(mViewPool, views.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; ++v)
         {
-            CUBOS_WARN("Number of directional lights to be drawn "
-                       "this frame exceeds the maximum allowed ({}).",
-                       CUBOS_DEFERRED_RENDERER_MAX_DIRECTIONAL_LIGHT_COUNT);
-            break;
+            const auto& view = views[v];
+            auto& pass = mViewPasses[v];
+
+            // 2.1. Compute the VP matrices.
+            pass.v = view.view;
+            pass.p = glm::perspective(glm::radians(view.camera.fovY),
+                                      float(view.viewport.size.x) / float(view.viewport.size.y), view.camera.zNear,
+                                      view.camera.zFar);
+
+            // 2.2. Bin the local lights into the clusters of the camera.
+            pass.clusters.build(pass.v, pass.p, view.camera.zNear, view.camera.zFar, mClusterLights);
+
+            // 2.3. Sort the draw commands which may be visible.
+            frame.cull(pass.p * pass.v, pass.visible);
+            pass.drawOrder.clear();
+            for (std::size_t i = 0; i < frame.drawCmds().size(); ++i)
+            {
+                if (pass.visible[i] != 0)
+                {
+                    pass.drawOrder.emplace_back(drawKey(frame.drawCmds()[i], pass.v), i);
+                }
+            }
+            std::sort(pass.drawOrder.begin(), pass.drawOrder.end());
+
+            // 2.4. Group the sorted draw commands into instanced batches. As draws are sorted by
+            // grid, each batch is a run of draws of the same grid, split when it reaches the
+            // instance limit.
+            pass.batches.clear();
+            pass.instanceBytes = 0;
+            for (std::size_t i = 0; i < pass.drawOrder.size(); ++i)
+            {
+                const auto& grid = frame.drawCmds()[pass.drawOrder[i].second].grid;
+                if (pass.batches.empty() || pass.batches.back().count == MaxInstanceCount ||
+                    frame.drawCmds()[pass.drawOrder[pass.batches.back().first].second].grid != grid)
+                {
+                    auto offset = (pass.instanceBytes + alignment - 1) / alignment * alignment;
+                    pass.batches.push_back({i, 0, offset});
+                    pass.instanceBytes = offset;
+                }
+
+                pass.batches.back().count += 1;
+                pass.instanceBytes += sizeof(glm::mat4);
+            }
         }
+    });
 
-        lightData.directionalLights[lightData.numDirectionalLights].rotation = glm::toMat4(glm::quat_cast(transform));
-        lightData.directionalLights[lightData.numDirectionalLights].color = glm::vec4(light.color, 1.0F);
-        lightData.directionalLights[lightData.numDirectionalLights].intensity = light.intensity;
-        lightData.numDirectionalLights += 1;
+    // 3. Upload the data of every camera at once.
+    // 3.1. Fill the cluster textures. The clusters of each camera follow those of the previous one.
+    mClusterTexels.clear();
+    std::size_t indexBase = 0;
+    for (const auto& pass : mViewPasses)
+    {
+        for (const auto& range : pass.clusters.ranges())
+        {
+            mClusterTexels.push_back(static_cast<float>(indexBase + range.x));
+            mClusterTexels.push_back(static_cast<float>(range.y));
+        }
+        indexBase += pass.clusters.indices().size();
     }
+    uploadRows(mRenderDevice, mClusterRangesTex, mClusterRangesTexRows, TextureFormat::RG32Float, 2, mClusterTexels);
 
-    // Point lights.
-    for (const auto& [transform, light] : frame.pointLights())
+    mClusterTexels.clear();
+    for (const auto& pass : mViewPasses)
     {
-        if (lightData.numPointLights >= CUBOS_DEFERRED_RENDERER_MAX_POINT_LIGHT_COUNT)
+        for (auto index : pass.clusters.indices())
         {
-            CUBOS_WARN("Number of point lights to be drawn "
-                       "this frame exceeds the maximum allowed ({}).",
-                       CUBOS_DEFERRED_RENDERER_MAX_POINT_LIGHT_COUNT);
-            break;
+            mClusterTexels.push_back(static_cast<float>(index));
+        }
+    }
+    uploadRows(mRenderDevice, mClusterIndicesTex, mClusterIndicesTexRows, TextureFormat::R32Float, 1, mClusterTexels);
+
+    // 3.2. Write the VP matrices of every camera, followed by the model matrices of every batch,
+    // to the upload ring, with a single map. Each batch binds a whole uniform block, so enough
+    // space is left after the last batch for it.
+    auto vpStride = (sizeof(VP) + alignment - 1) / alignment * alignment;
+    auto frameBytes = vpStride * mViewPasses.size();
+    auto allocationBytes = frameBytes;
+    for (auto& pass : mViewPasses)
+    {
+        pass.instanceOffset = (frameBytes + alignment - 1) / alignment * alignment;
+        frameBytes = pass.instanceOffset + pass.instanceBytes;
+        allocationBytes = std::max(allocationBytes, frameBytes);
+        if (!pass.batches.empty())
+        {
+            auto blockEnd = pass.instanceOffset + pass.batches.back().offset + MaxInstanceCount * sizeof(glm::mat4);
+            allocationBytes = std::max(allocationBytes, blockEnd);
         }
-        lightData.pointLights[lightData.numPointLights].position = transform * glm::vec4(0.0F, 0.0F, 0.0F, 1.0F);
-        lightData.pointLights[lightData.numPointLights].color = glm::vec4(light.color, 1.0F);
-        lightData.pointLights[lightData.numPointLights].intensity = light.intensity;
-        lightData.pointLights[lightData.numPointLights].range = light.range;
-        lightData.numPointLights += 1;
     }
 
-    // Unmap the buffer.
-    mLightsBuffer->unmap();
-
-    // 3. Set the renderer state.
-    mRenderDevice.setViewport(viewport.position.x, viewport.position.y, viewport.size.x, viewport.size.y);
+    auto perFrame = mUploads.allocate(allocationBytes);
+    auto* data = static_cast<char*>(core::gl::UploadRing::map(perFrame));
+    for (std::size_t v = 0; v < mViewPasses.size(); ++v)
+    {
+        const auto& pass = mViewPasses[v];
+        VP vp{pass.v, pass.p};
+        memcpy(data + v * vpStride, &vp, sizeof(VP));
+        for (const auto& batch : pass.batches)
+        {
+            for (std::size_t i = 0; i < batch.count; ++i)
+            {
+                const auto& drawCmd = frame.drawCmds()[pass.drawOrder[batch.first + i].second];
+                auto offset = pass.instanceOffset + batch.offset + i * sizeof(glm::mat4);
+                memcpy(data + offset, &drawCmd.modelMat, sizeof(glm::mat4));
+            }
+        }
+    }
+    core::gl::UploadRing::unmap(perFrame);
 
     // 4. Geometry pass.
     // 4.1. Set the geometry pass state.
@@ -705,63 +998,99 @@ void DeferredRenderer::onRender(const glm::mat4& view, const Viewport& viewport,
     mRenderDevice.setRasterState(mGeometryRasterState);
     mRenderDevice.setBlendState(mGeometryBlendState);
     mRenderDevice.setDepthStencilState(mGeometryDepthStencilState);
-    mRenderDevice.setShaderPipeline(mGeometryPipeline);
-    mVpBp->bind(mVpBuffer);
 
-    // 4.2. Clear the GBuffer.
+    // 4.2. Clear the GBuffer, once for every camera, as their viewports don't overlap.
     mRenderDevice.clearTargetColor(0, 0.0F, 0.0F, 0.0F, 1.0F);
     mRenderDevice.clearTargetColor(1, 0.0F, 0.0F, 0.0F, 1.0F);
     mRenderDevice.clearTargetColor(2, 0.0F, 0.0F, 0.0F, 0.0F);
     mRenderDevice.clearDepth(1.0F);
 
-    // 4.3. For each draw command:
-    for (const auto& drawCmd : frame.drawCmds())
+    // 4.3. Draw each batch with a single instanced draw, to the viewport of its camera. Batches are
+    // sorted by pipeline, so the unpacked geometry pipeline, if needed, is only set once per camera.
+    for (std::size_t v = 0; v < mViewPasses.size(); ++v)
     {
-        // 4.3.1. Update the MVP constant buffer with the model matrix.
-        mvp.m = drawCmd.modelMat;
-        memcpy(mVpBuffer->map(), &mvp, sizeof(MVP));
-        mVpBuffer->unmap();
-
-        // 4.3.2. Draw the geometry.
-        auto grid = std::static_pointer_cast<DeferredGrid>(drawCmd.grid);
-        mRenderDevice.setVertexArray(grid->va);
-        mRenderDevice.setIndexBuffer(grid->ib);
-        mRenderDevice.drawTrianglesIndexed(0, grid->indexCount);
+        const auto& viewport = views[v].viewport;
+        const auto& pass = mViewPasses[v];
+        mRenderDevice.setViewport(viewport.position.x, viewport.position.y, viewport.size.x, viewport.size.y);
+        bool packed = true;
+        mRenderDevice.setShaderPipeline(mGeometryPipeline);
+        mVpBp->bind(perFrame.buffer, perFrame.offset + v * vpStride, sizeof(VP));
+        for (const auto& batch : pass.batches)
+        {
+            const auto& grid =
+                static_cast<const DeferredGrid&>(*frame.drawCmds()[pass.drawOrder[batch.first].second].grid);
+            if (grid.packed != packed)
+            {
+                packed = grid.packed;
+                mRenderDevice.setShaderPipeline(packed ? mGeometryPipeline : mUnpackedGeometryPipeline);
+                (packed ? mVpBp : mUnpackedVpBp)->bind(perFrame.buffer, perFrame.offset + v * vpStride, sizeof(VP));
+            }
+
+            (packed ? mInstancesBp : mUnpackedInstancesBp)
+                ->bind(perFrame.buffer, perFrame.offset + pass.instanceOffset + batch.offset,
+                       MaxInstanceCount * sizeof(glm::mat4));
+            mRenderDevice.setVertexArray(grid.va);
+            mRenderDevice.setIndexBuffer(grid.ib);
+            mRenderDevice.drawTrianglesIndexedInstanced(0, grid.indexCount, batch.count);
+        }
     }
 
+    // The screen passes only cover the viewport of each camera, so they must map their screen
+    // coordinates to the region of the GBuffer the camera was drawn to.
+    auto uvScale = [&](const Viewport& viewport) { return glm::vec2(viewport.size) / glm::vec2(mSize); };
+    auto uvOffset = [&](const Viewport& viewport) { return glm::vec2(viewport.position) / glm::vec2(mSize); };
+
     // 5. SSAO pass.
     if (mSsaoEnabled)
     {
-        // 5.1. Set the SSAO pass state.
+        // 5.1. Set the SSAO pass state. The kernel never changes, so it's only bound.
         mRenderDevice.setFramebuffer(mSsaoFb);
         mRenderDevice.setRasterState(nullptr);
         mRenderDevice.setBlendState(nullptr);
         mRenderDevice.setDepthStencilState(nullptr);
         mRenderDevice.setShaderPipeline(mSsaoPipeline);
+        mRenderDevice.setVertexArray(mScreenQuadVa);
         mSsaoPositionBp->bind(mPositionTex);
         mSsaoPositionBp->bind(mSampler);
         mSsaoNormalBp->bind(mNormalTex);
         mSsaoNormalBp->bind(mSampler);
         mSsaoNoiseBp->bind(mSsaoNoiseTex);
         mSsaoNoiseBp->bind(mSsaoNoiseSampler);
-        mSsaoViewBp->setConstant(mvp.v);
-        mSsaoProjectionBp->setConstant(mvp.p);
-        mSsaoScreenSizeBp->setConstant(glm::vec2(mSize));
+        mSsaoKernelBp->bind(mSsaoKernelBuffer);
+        mSsaoScreenSizeBp->setConstant(glm::vec2(mSsaoSize));
 
-        // Samples
-        for (int i = 0; i < 64; i++)
+        // 5.2. Draw the screen quad, for the viewport of each camera, scaled down to the
+        // resolution of the SSAO texture.
+        for (std::size_t v = 0; v < mViewPasses.size(); ++v)
         {
-            mSsaoSamplesBp = mSsaoPipeline->getBindingPoint(std::string("samples[" + std::to_string(i) + "]").c_str());
-            mSsaoSamplesBp->setConstant(mSsaoKernel[static_cast<std::size_t>(i)]);
+            const auto& viewport = views[v].viewport;
+            auto scale = static_cast<int>(mSsaoDownscale);
+            mRenderDevice.setViewport(viewport.position.x / scale, viewport.position.y / scale,
+                                      (viewport.size.x + scale - 1) / scale, (viewport.size.y + scale - 1) / scale);
+            mSsaoViewBp->setConstant(mViewPasses[v].v);
+            mSsaoProjectionBp->setConstant(mViewPasses[v].p);
+            mSsaoUVScaleBp->setConstant(uvScale(viewport));
+            mSsaoUVOffsetBp->setConstant(uvOffset(viewport));
+            mRenderDevice.drawTriangles(0, 6);
         }
 
-        mRenderDevice.setVertexArray(mScreenQuadVa);
-        mRenderDevice.drawTriangles(0, 6);
-
-        // 5.2. Set the SSAO blur pass state.
-        mRenderDevice.setShaderPipeline(mSsaoBlurPipeline);
-        mSsaoBlurTexBp->bind(mSsaoTex);
-        mRenderDevice.drawTriangles(0, 6);
+        // 5.3. Blur and upsample the SSAO texture to full resolution, for the viewport of each
+        // camera.
+        mRenderDevice.setFramebuffer(mSsaoUpsampleFb);
+        mRenderDevice.setShaderPipeline(mSsaoUpsamplePipeline);
+        mSsaoUpsampleInputBp->bind(mSsaoTex);
+        mSsaoUpsampleInputBp->bind(mSampler);
+        mSsaoUpsamplePositionBp->bind(mPositionTex);
+        mSsaoUpsamplePositionBp->bind(mSampler);
+        for (std::size_t v = 0; v < mViewPasses.size(); ++v)
+        {
+            const auto& viewport = views[v].viewport;
+            mRenderDevice.setViewport(viewport.position.x, viewport.position.y, viewport.size.x, viewport.size.y);
+            mSsaoUpsampleViewBp->setConstant(mViewPasses[v].v);
+            mSsaoUpsampleUVScaleBp->setConstant(uvScale(viewport));
+            mSsaoUpsampleUVOffsetBp->setConstant(uvOffset(viewport));
+            mRenderDevice.drawTriangles(0, 6);
+        }
     }
 
     // 6. Lighting pass.
@@ -779,28 +1108,49 @@ void DeferredRenderer::onRender(const glm::mat4& view, const Viewport& viewport,
     mMaterialBp->bind(mSampler);
     mPaletteBp->bind(mPaletteTex);
     mPaletteBp->bind(mSampler);
-    mLightsBp->bind(mLightsBuffer);
+    mLightsBp->bind(lightsRange.buffer, lightsRange.offset, lightsRange.size);
+    mLightDataBp->bind(mLightDataTex);
+    mLightDataBp->bind(mSampler);
+    mClusterRangesBp->bind(mClusterRangesTex);
+    mClusterRangesBp->bind(mSampler);
+    mClusterIndicesBp->bind(mClusterIndicesTex);
+    mClusterIndicesBp->bind(mSampler);
     mSsaoEnabledBp->setConstant(static_cast<int>(mSsaoEnabled));
-    if (mSsaoEnabledBp != nullptr)
+    if (mSsaoEnabled)
     {
-        mSsaoTexBp->bind(mSsaoTex);
+        mSsaoTexBp->bind(mSsaoUpsampleTex);
         mSsaoTexBp->bind(mSampler);
     }
-    mUVScaleBp->setConstant(
-        glm::vec2((float)viewport.size.x / (float)mSize.x, (float)viewport.size.y / (float)mSize.y));
-    mUVOffsetBp->setConstant(
-        glm::vec2((float)viewport.position.x / (float)mSize.x, (float)viewport.position.y / (float)mSize.y));
     mSkyGradientBottomBp->setConstant(frame.skyGradient(0));
     mSkyGradientTopBp->setConstant(frame.skyGradient(1));
-    mInvVBp->setConstant(glm::inverse(mvp.v));
-    mInvPBp->setConstant(glm::inverse(mvp.p));
-
-    // 6.3. Draw the screen quad.
     mRenderDevice.setVertexArray(mScreenQuadVa);
-    mRenderDevice.drawTriangles(0, 6);
+
+    // 6.2. Draw the screen quad, for the viewport of each camera.
+    for (std::size_t v = 0; v < mViewPasses.size(); ++v)
+    {
+        const auto& viewport = views[v].viewport;
+        const auto& pass = mViewPasses[v];
+        mRenderDevice.setViewport(viewport.position.x, viewport.position.y, viewport.size.x, viewport.size.y);
+        mClusterOffsetBp->setConstant(static_cast<unsigned int>(v * LightClusters::Count));
+        mClusterParamsBp->setConstant(pass.clusters.sliceParams());
+        mViewBp->setConstant(pass.v);
+        mUVScaleBp->setConstant(uvScale(viewport));
+        mUVOffsetBp->setConstant(uvOffset(viewport));
+        mInvVBp->setConstant(glm::inverse(pass.v));
+        mInvPBp->setConstant(glm::inverse(pass.p));
+        mRenderDevice.drawTriangles(0, 6);
+    }
 
     /// FIXME: This should not be on production code.
-    core::gl::Debug::flush(mvp.p * mvp.v, 1 / 60.0F);
+    for (std::size_t v = 0; v < mViewPasses.size(); ++v)
+    {
+        const auto& viewport = views[v].viewport;
+        mRenderDevice.setViewport(viewport.position.x, viewport.position.y, viewport.size.x, viewport.size.y);
+        core::gl::Debug::flush(mViewPasses[v].p * mViewPasses[v].v, 1 / 60.0F);
+    }
+
+    // The ranges uploaded for this frame can be reused once its commands finish.
+    mUploads.fence();
 
     // Provide custom inputs to the PPS manager.
     this->pps().provideInput(PostProcessingInput::Position, mPositionTex);
@@ -809,15 +1159,22 @@ void DeferredRenderer::onRender(const glm::mat4& view, const Viewport& viewport,
 
 void DeferredRenderer::createSSAOTextures()
 {
+    // The occlusion is computed at a lower resolution, and then upsampled to full resolution.
+    mSsaoSize = (mSize + mSsaoDownscale - 1U) / mSsaoDownscale;
     Texture2DDesc texDesc;
-    texDesc.width = mSize.x;
-    texDesc.height = mSize.y;
+    texDesc.width = mSsaoSize.x;
+    texDesc.height = mSsaoSize.y;
     texDesc.usage = Usage::Dynamic;
 
     // Create output texture
     texDesc.format = TextureFormat::R32Float;
     mSsaoTex = mRenderDevice.createTexture2D(texDesc);
 
+    // Create the upsampled texture
+    texDesc.width = mSize.x;
+    texDesc.height = mSize.y;
+    mSsaoUpsampleTex = mRenderDevice.createTexture2D(texDesc);
+
     // Generate noise texture
     std::uniform_real_distribution<float> randomFloats(0.0F, 1.0F); // random floats between [0.0, 1.0]
     std::default_random_engine generator;
@@ -836,20 +1193,22 @@ void DeferredRenderer::createSSAOTextures()
     texDesc.data[0] = ssaoNoise.data();
     mSsaoNoiseTex = mRenderDevice.createTexture2D(texDesc);
 
-    // Create the framebuffer
+    // Create the framebuffers
     FramebufferDesc fbDesc;
     fbDesc.targetCount = 1;
     fbDesc.targets[0].setTexture2DTarget(mSsaoTex);
     mSsaoFb = mRenderDevice.createFramebuffer(fbDesc);
+    fbDesc.targets[0].setTexture2DTarget(mSsaoUpsampleTex);
+    mSsaoUpsampleFb = mRenderDevice.createFramebuffer(fbDesc);
 }
 
 void DeferredRenderer::generateSSAONoise()
 {
-    // Generate kernel samples
+    // Generate kernel samples, padded to vec4 as in std140, and upload them once.
     std::uniform_real_distribution<float> randomFloats(0.0F, 1.0F); // random floats between [0.0, 1.0]
     std::default_random_engine generator;
 
-    mSsaoKernel.resize(64);
+    std::vector<glm::vec4> kernel(64);
     for (unsigned int i = 0; i < 64; i++)
     {
         glm::vec3 sample(randomFloats(generator) * 2.0F - 1.0F, // [-1.0, 1.0]
@@ -863,6 +1222,9 @@ void DeferredRenderer::generateSSAONoise()
         scale = glm::lerp(0.1F, 1.0F, scale * scale);
         sample *= scale;
 
-        mSsaoKernel[i] = sample;
+        kernel[i] = glm::vec4(sample, 0.0F);
     }
+
+    mSsaoKernelBuffer =
+        mRenderDevice.createConstantBuffer(kernel.size() * sizeof(glm::vec4), kernel.data(), Usage::Static);
 }
@@ -4,6 +4,23 @@ using namespace cubos::engine;
 
 void RendererFrame::draw(RendererGrid grid, glm::mat4 modelMat)
 {
+    // Transform the bounding box to world space, growing it so that it stays axis aligned.
+    auto center = (grid->min + grid->max) / 2.0F;
+    auto extent = (grid->max - grid->min) / 2.0F;
+    auto worldCenter = glm::vec3(modelMat * glm::vec4(center, 1.0F));
+    glm::vec3 worldExtent;
+    for (glm::length_t i = 0; i < 3; ++i)
+    {
+        worldExtent[i] = glm::abs(modelMat[0][i]) * extent.x + glm::abs(modelMat[1][i]) * extent.y +
+                         glm::abs(modelMat[2][i]) * extent.z;
+    }
+
+    mBounds.centerX.push_back(worldCenter.x);
+    mBounds.centerY.push_back(worldCenter.y);
+    mBounds.centerZ.push_back(worldCenter.z);
+    mBounds.extentX.push_back(worldExtent.x);
+    mBounds.extentY.push_back(worldExtent.y);
+    mBounds.extentZ.push_back(worldExtent.z);
     mDrawCmds.push_back(DrawCmd{std::move(grid), modelMat});
 }
 
@@ -36,6 +53,12 @@ void RendererFrame::light(glm::mat4 transform, const PointLight& light)
 void RendererFrame::clear()
 {
     mDrawCmds.clear();
+    mBounds.centerX.clear();
+    mBounds.centerY.clear();
+    mBounds.centerZ.clear();
+    mBounds.extentX.clear();
+    mBounds.extentY.clear();
+    mBounds.extentZ.clear();
     mSpotLights.clear();
     mDirectionalLights.clear();
     mPointLights.clear();
@@ -46,6 +69,45 @@ const std::vector<RendererFrame::DrawCmd>& RendererFrame::drawCmds() const
     return mDrawCmds;
 }
 
+void RendererFrame::cull(const glm::mat4& viewProj, std::vector<uint8_t>& visible) const
+{
+    const std::size_t count = mDrawCmds.size();
+    visible.assign(count, 1);
+
+    const float* centerX = mBounds.centerX.data();
+    const float* centerY = mBounds.centerY.data();
+    const float* centerZ = mBounds.centerZ.data();
+    const float* extentX = mBounds.extentX.data();
+    const float* extentY = mBounds.extentY.data();
+    const float* extentZ = mBounds.extentZ.data();
+    uint8_t* out = visible.data();
+
+    // Each plane of the frustum is a sum or difference of two rows of the view projection matrix,
+    // with its normal pointing inwards. The planes don't need to be normalized, as only the sign
+    // of the distances matters.
+    for (glm::length_t plane = 0; plane < 6; ++plane)
+    {
+        glm::length_t row = plane / 2;
+        float sign = plane % 2 == 0 ? 1.0F : -1.0F;
+        float nx = viewProj[0][3] + sign * viewProj[0][row];
+        float ny = viewProj[1][3] + sign * viewProj[1][row];
+        float nz = viewProj[2][3] + sign * viewProj[2][row];
+        float d = viewProj[3][3] + sign * viewProj[3][row];
+        float ax = glm::abs(nx);
+        float ay = glm::abs(ny);
+        float az = glm::abs(nz);
+
+        // A box is outside of the frustum if it's fully behind any of its planes. The loop has no
+        // branches and works on separate arrays, so that it can be vectorized by the compiler.
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float distance = nx * centerX[i] + ny * centerY[i] + nz * centerZ[i] + d;
+            float radius = ax * extentX[i] + ay * extentY[i] + az * extentZ[i];
+            out[i] &= static_cast<uint8_t>(distance + radius >= 0.0F);
+        }
+    }
+}
+
 const glm::vec3& RendererFrame::ambient() const
 {
     return mAmbientColor;
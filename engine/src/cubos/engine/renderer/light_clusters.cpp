@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+
+#include <cubos/engine/renderer/light_clusters.hpp>
+
+using cubos::engine::LightClusters;
+
+/// @brief Gets the depth slice which contains a depth.
+/// @param depth View space depth.
+/// @param zNear Near plane.
+/// @param scale Number of slices divided by log(zFar / zNear).
+/// @return Slice index.
+static int sliceOf(float depth, float zNear, float scale)
+{
+    auto slice = static_cast<int>(std::floor(std::log(std::max(depth, zNear) / zNear) * scale));
+    return std::clamp(slice, 0, LightClusters::Slices - 1);
+}
+
+/// @brief Gets the tile which contains a normalized device coordinate.
+/// @param ndc Normalized device coordinate, from -1 to 1.
+/// @param tiles Number of tiles along the axis.
+/// @return Tile index.
+static int tileOf(float ndc, int tiles)
+{
+    auto tile = static_cast<int>(std::floor((ndc + 1.0F) * 0.5F * static_cast<float>(tiles)));
+    return std::clamp(tile, 0, tiles - 1);
+}
+
+/// @brief Checks if a cone may intersect a sphere.
+/// @param tip Tip of the cone.
+/// @param direction Normalized direction of the cone.
+/// @param range Length of the cone.
+/// @param cosAngle Cosine of the cone's angle.
+/// @param sinAngle Sine of the cone's angle.
+/// @param center Center of the sphere.
+/// @param radius Radius of the sphere.
+/// @return Whether they may intersect.
+static bool coneIntersects(glm::vec3 tip, glm::vec3 direction, float range, float cosAngle, float sinAngle,
+                           glm::vec3 center, float radius)
+{
+    auto toCenter = center - tip;
+    float distanceSq = glm::dot(toCenter, toCenter);
+    float along = glm::dot(toCenter, direction);
+    float distanceToCone = cosAngle * std::sqrt(std::max(distanceSq - along * along, 0.0F)) - along * sinAngle;
+    return distanceToCone <= radius && along <= radius + range && along >= -radius;
+}
+
+void LightClusters::build(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                          const std::vector<Light>& lights)
+{
+    mZNear = zNear;
+    mSliceScale = static_cast<float>(Slices) / std::log(zFar / zNear);
+
+    // Compute the bounds of each cluster. A point at depth d with normalized device coordinates
+    // (x, y) is at (x * d / P[0][0], y * d / P[1][1]) in view space.
+    auto count = static_cast<std::size_t>(Count);
+    mBounds.resize(count);
+    float invScaleX = 1.0F / projection[0][0];
+    float invScaleY = 1.0F / projection[1][1];
+    for (int z = 0; z < Slices; ++z)
+    {
+        float near = zNear * std::pow(zFar / zNear, static_cast<float>(z) / static_cast<float>(Slices));
+        float far = zNear * std::pow(zFar / zNear, static_cast<float>(z + 1) / static_cast<float>(Slices));
+        for (int y = 0; y < TilesY; ++y)
+        {
+            float y0 = static_cast<float>(y) / static_cast<float>(TilesY) * 2.0F - 1.0F;
+            float y1 = static_cast<float>(y + 1) / static_cast<float>(TilesY) * 2.0F - 1.0F;
+            for (int x = 0; x < TilesX; ++x)
+            {
+                float x0 = static_cast<float>(x) / static_cast<float>(TilesX) * 2.0F - 1.0F;
+                float x1 = static_cast<float>(x + 1) / static_cast<float>(TilesX) * 2.0F - 1.0F;
+                auto i = static_cast<std::size_t>(x + y * TilesX + z * TilesX * TilesY);
+                mBounds[i].min = {std::min(x0 * near, x0 * far) * invScaleX,
+                                  std::min(y0 * near, y0 * far) * invScaleY, near};
+                mBounds[i].max = {std::max(x1 * near, x1 * far) * invScaleX,
+                                  std::max(y1 * near, y1 * far) * invScaleY, far};
+            }
+        }
+    }
+
+    mLightsOf.resize(count);
+    for (auto& lightsOf : mLightsOf)
+    {
+        lightsOf.clear();
+    }
+
+    for (std::size_t l = 0; l < lights.size(); ++l)
+    {
+        const auto& light = lights[l];
+
+        // Work in view space, with depth pointing forward, as the cluster bounds are.
+        auto position = glm::vec3(view * glm::vec4(light.position, 1.0F));
+        auto direction = glm::vec3(view * glm::vec4(light.direction, 0.0F));
+        position.z = -position.z;
+        direction.z = -direction.z;
+        float range = light.range;
+        if (position.z + range < zNear || position.z - range > zFar)
+        {
+            continue;
+        }
+
+        // Find the clusters covered by the screen space bounds of the light's sphere. For a fixed
+        // x, x / d is monotonic in d, so its extremes are at the nearest and farthest depths.
+        float depthMin = std::max(position.z - range, zNear);
+        float depthMax = position.z + range;
+        float ndcMinX = std::min((position.x - range) / depthMin, (position.x - range) / depthMax) * projection[0][0];
+        float ndcMaxX = std::max((position.x + range) / depthMin, (position.x + range) / depthMax) * projection[0][0];
+        float ndcMinY = std::min((position.y - range) / depthMin, (position.y - range) / depthMax) * projection[1][1];
+        float ndcMaxY = std::max((position.y + range) / depthMin, (position.y + range) / depthMax) * projection[1][1];
+        int x0 = tileOf(ndcMinX, TilesX);
+        int x1 = tileOf(ndcMaxX, TilesX);
+        int y0 = tileOf(ndcMinY, TilesY);
+        int y1 = tileOf(ndcMaxY, TilesY);
+        int z0 = sliceOf(depthMin, zNear, mSliceScale);
+        int z1 = sliceOf(depthMax, zNear, mSliceScale);
+
+        // Spot lights wider than a half-space are only tested as spheres.
+        bool isSpot = light.spotCutoff > 0.0F;
+        float cosAngle = light.spotCutoff;
+        float sinAngle = std::sqrt(std::max(1.0F - cosAngle * cosAngle, 0.0F));
+
+        for (int z = z0; z <= z1; ++z)
+        {
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    auto i = static_cast<std::size_t>(x + y * TilesX + z * TilesX * TilesY);
+                    const auto& boxMin = mBounds[i].min;
+                    const auto& boxMax = mBounds[i].max;
+
+                    auto closest = glm::clamp(position, boxMin, boxMax);
+                    auto offset = closest - position;
+                    if (glm::dot(offset, offset) > range * range)
+                    {
+                        continue;
+                    }
+
+                    auto center = (boxMin + boxMax) * 0.5F;
+                    auto radius = glm::length(boxMax - center);
+                    if (isSpot && !coneIntersects(position, direction, range, cosAngle, sinAngle, center, radius))
+                    {
+                        continue;
+                    }
+
+                    mLightsOf[i].push_back(static_cast<uint32_t>(l));
+                }
+            }
+        }
+    }
+
+    // Compact the lights of every cluster into a single array.
+    mRanges.resize(count);
+    mIndices.clear();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        mRanges[i] = {static_cast<uint32_t>(mIndices.size()), static_cast<uint32_t>(mLightsOf[i].size())};
+        mIndices.insert(mIndices.end(), mLightsOf[i].begin(), mLightsOf[i].end());
+    }
+}
+
+std::size_t LightClusters::cluster(glm::vec2 uv, float depth) const
+{
+    int x = std::clamp(static_cast<int>(uv.x * static_cast<float>(TilesX)), 0, TilesX - 1);
+    int y = std::clamp(static_cast<int>(uv.y * static_cast<float>(TilesY)), 0, TilesY - 1);
+    int z = sliceOf(depth, mZNear, mSliceScale);
+    return static_cast<std::size_t>(x + y * TilesX + z * TilesX * TilesY);
+}
+
+glm::vec2 LightClusters::sliceParams() const
+{
+    return {mZNear, mSliceScale};
+}
+
+const std::vector<glm::uvec2>& LightClusters::ranges() const
+{
+    return mRanges;
+}
+
+const std::vector<uint32_t>& LightClusters::indices() const
+{
+    return mIndices;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <thread>
+
+#include <cubos/engine/renderer/mesh_jobs.hpp>
+
+using cubos::core::ThreadPool;
+using namespace cubos::engine;
+
+MeshJobs::MeshJobs()
+    : MeshJobs(std::max(std::thread::hardware_concurrency(), 2U) - 1)
+{
+}
+
+MeshJobs::MeshJobs(std::size_t threadCount)
+    : mPool(std::make_unique<ThreadPool>(std::max(threadCount, std::size_t{1})))
+{
+}
+
+MeshJob MeshJobs::submit(const VoxelGrid& grid)
+{
+    VoxelGrid copy;
+    copy = grid;
+    return this->submit(std::move(copy));
+}
+
+MeshJob MeshJobs::submit(VoxelGrid&& grid)
+{
+    // Tasks must be copyable, so the promise and the grid are shared with the task.
+    auto promise = std::make_shared<std::promise<VoxelMesh>>();
+    auto shared = std::make_shared<VoxelGrid>(std::move(grid));
+    MeshJob job = promise->get_future().share();
+
+    mPool->addTask([promise, shared]() {
+        VoxelMesh mesh;
+        triangulate(*shared, mesh.vertices, mesh.indices);
+        promise->set_value(std::move(mesh));
+    });
+
+    return job;
+}
+
+MeshJob MeshJobs::submit(const VoxelGrid& grid, const glm::uvec3& origin, const glm::uvec3& size)
+{
+    // Copy the region, along with the voxels around it, as they may hide some of its faces.
+    auto begin = glm::uvec3{glm::max(glm::ivec3{origin} - 1, glm::ivec3{0})};
+    auto end = glm::min(origin + size + 1U, grid.size());
+    auto copySize = end - begin;
+
+    std::vector<uint16_t> indices;
+    indices.reserve(static_cast<std::size_t>(copySize.x) * copySize.y * copySize.z);
+    for (auto z = begin.z; z < end.z; ++z)
+    {
+        for (auto y = begin.y; y < end.y; ++y)
+        {
+            for (auto x = begin.x; x < end.x; ++x)
+            {
+                indices.push_back(grid.get(glm::ivec3{glm::uvec3{x, y, z}}));
+            }
+        }
+    }
+
+    auto copy = std::make_shared<VoxelGrid>(copySize, indices);
+    auto promise = std::make_shared<std::promise<VoxelMesh>>();
+    MeshJob job = promise->get_future().share();
+
+    mPool->addTask([promise, copy, begin, local = origin - begin, size]() {
+        VoxelMesh mesh;
+        triangulate(*copy, local, size, mesh.vertices, mesh.indices);
+
+        // Move the vertices back to the coordinates of the original grid.
+        for (auto& vertex : mesh.vertices)
+        {
+            vertex.position += begin;
+        }
+        promise->set_value(std::move(mesh));
+    });
+
+    return job;
+}
+
+MeshJob MeshJobs::submit(VoxelGrid&& grid, const glm::uvec3& origin, const glm::uvec3& size)
+{
+    auto promise = std::make_shared<std::promise<VoxelMesh>>();
+    auto shared = std::make_shared<VoxelGrid>(std::move(grid));
+    MeshJob job = promise->get_future().share();
+
+    mPool->addTask([promise, shared, origin, size]() {
+        VoxelMesh mesh;
+        triangulate(*shared, origin, size, mesh.vertices, mesh.indices);
+        promise->set_value(std::move(mesh));
+    });
+
+    return job;
+}
+
+MeshJob MeshJobs::submit(const VoxelGrid& grid, const VoxelPalette& palette, unsigned int level, float minSimilarity)
+{
+    auto copy = std::make_shared<VoxelGrid>();
+    *copy = grid;
+    auto promise = std::make_shared<std::promise<VoxelMesh>>();
+    MeshJob job = promise->get_future().share();
+
+    mPool->addTask([promise, copy, palette, level, minSimilarity]() {
+        for (unsigned int i = 0; i < level; ++i)
+        {
+            *copy = copy->downsample(palette, minSimilarity);
+        }
+
+        VoxelMesh mesh;
+        triangulate(*copy, mesh.vertices, mesh.indices);
+
+        // Each voxel of the downsampled grid covers 2^level voxels of the original grid.
+        for (auto& vertex : mesh.vertices)
+        {
+            vertex.position *= 1U << level;
+        }
+        promise->set_value(std::move(mesh));
+    });
+
+    return job;
+}
+
+bool MeshJobs::isReady(const MeshJob& job)
+{
+    return job.valid() && job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
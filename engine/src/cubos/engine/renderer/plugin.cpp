@@ -1,3 +1,5 @@
+#include <future>
+
 #include <cubos/core/ecs/query.hpp>
 
 #include <cubos/engine/renderer/deferred_renderer.hpp>
@@ -10,7 +12,10 @@
 #include <cubos/engine/renderer/spot_light.hpp>
 #include <cubos/engine/settings/plugin.hpp>
 #include <cubos/engine/transform/plugin.hpp>
+#include <cubos/engine/voxels/plugin.hpp>
+#include <cubos/engine/voxels/world.hpp>
 #include <cubos/engine/window/plugin.hpp>
+#include <cubos/engine/window/render_thread.hpp>
 
 using cubos::core::ecs::EventReader;
 using cubos::core::ecs::Query;
@@ -22,42 +27,365 @@ using cubos::core::io::WindowEvent;
 
 using namespace cubos::engine;
 
-static void init(Write<Renderer> renderer, Read<Window> window, Write<Settings> settings)
+/// @brief Resource which holds the grids uploaded for each chunk of the @ref VoxelWorld.
+struct VoxelWorldGrids
 {
-    auto& renderDevice = (*window)->renderDevice();
-    *renderer = std::make_shared<DeferredRenderer>(renderDevice, (*window)->framebufferSize(), *settings);
+    std::unordered_map<glm::ivec3, RendererGrid, VoxelWorld::ChunkHash> grids;
+    std::unordered_map<glm::ivec3, MeshJob, VoxelWorld::ChunkHash> pending;
+    std::unordered_map<glm::ivec3, std::shared_future<RendererGrid>, VoxelWorld::ChunkHash> uploads;
+};
 
-    if (settings->getBool("cubos.renderer.bloom.enabled", false))
-    {
-        (*renderer)->pps().addPass<PostProcessingBloom>();
-    }
+/// @brief Resource which holds the frame being rendered by the @ref RenderThread, while the next
+/// one is written to the @ref RendererFrame resource.
+struct SubmittedFrame
+{
+    std::shared_ptr<RendererFrame> frame = std::make_shared<RendererFrame>();
+};
+
+static void init(Write<Renderer> renderer, Read<Window> window, Write<Settings> settings,
+                 Write<RenderThread> renderThread)
+{
+    renderThread->call([&] {
+        auto& renderDevice = (*window)->renderDevice();
+        *renderer = std::make_shared<DeferredRenderer>(renderDevice, (*window)->framebufferSize(), *settings);
+
+        if (settings->getBool("cubos.renderer.bloom.enabled", false))
+        {
+            (*renderer)->pps().addPass<PostProcessingBloom>();
+        }
+    });
 }
 
-static void resize(Write<Renderer> renderer, EventReader<WindowEvent> evs)
+static void resize(Write<Renderer> renderer, Write<RenderThread> renderThread, EventReader<WindowEvent> evs)
 {
     for (const auto& ev : evs)
     {
         if (const auto* resizeEv = std::get_if<ResizeEvent>(&ev))
         {
-            (*renderer)->resize(resizeEv->size);
+            // Posted jobs run in order, so the frames drawn after this one already see the new size.
+            renderThread->post([renderer = *renderer, size = resizeEv->size] { renderer->resize(size); });
+        }
+    }
+}
+
+/// @brief Minimum similarity between two materials for them to be merged in lower levels of detail.
+static constexpr float LodSimilarity = 0.9F;
+
+/// @brief Splits the viewport recursively for the given cameras.
+/// @param position Viewport position.
+/// @param size Viewport size.
+/// @param count How many cameras need to be fitted in to the given viewport.
+/// @param viewport Output array where the viewports will be set.
+static void splitViewport(glm::ivec2 position, glm::ivec2 size, int count, BaseRenderer::Viewport* viewports)
+{
+    if (count == 1)
+    {
+        viewports[0].position = position;
+        viewports[0].size = size;
+    }
+    else if (count >= 2)
+    {
+        glm::ivec2 splitSize;
+        glm::ivec2 splitOffset;
+
+        // Split along the largest axis.
+        if (size.x > size.y)
+        {
+            splitSize = {size.x / 2, size.y};
+            splitOffset = {size.x / 2, 0};
         }
+        else
+        {
+            splitSize = {size.x, size.y / 2};
+            splitOffset = {0, size.y / 2};
+        }
+
+        splitViewport(position, splitSize, count / 2, viewports);
+        splitViewport(position + splitOffset, splitSize, (count + 1) / 2, &viewports[count / 2]);
+    }
+}
+
+/// @brief Position, field of view and viewport height of a camera, used to pick the level of
+/// detail of grids.
+struct LodCamera
+{
+    glm::vec3 position;
+    float fovY;
+    float viewportHeight;
+};
+
+/// @brief Picks the level of detail of a grid, from how many pixels its voxels take on the screen.
+/// @param transform Transform of the grid.
+/// @param size Size of the grid.
+/// @param cameras Active cameras.
+/// @param threshold Pixels per voxel below which a lower level of detail is used.
+/// @param levelCount Number of lower levels of detail.
+/// @return Picked level, where 0 is full detail.
+static unsigned int pickLevel(const glm::mat4& transform, glm::uvec3 size, const std::vector<LodCamera>& cameras,
+                              float threshold, unsigned int levelCount)
+{
+    auto scale = glm::max(glm::length(glm::vec3(transform[0])),
+                          glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+    auto center = glm::vec3(transform * glm::vec4(glm::vec3(size) / 2.0F, 1.0F));
+    auto radius = glm::length(glm::vec3(size)) / 2.0F * scale;
+
+    // The closest camera, where voxels take the most pixels, decides the level.
+    float pixels = 0.0F;
+    for (const auto& camera : cameras)
+    {
+        auto distance = glm::distance(camera.position, center) - radius;
+        if (distance <= 0.0F)
+        {
+            return 0;
+        }
+
+        auto halfHeight = distance * glm::tan(glm::radians(camera.fovY) / 2.0F);
+        pixels = glm::max(pixels, scale / halfHeight * camera.viewportHeight / 2.0F);
+    }
+
+    if (pixels <= 0.0F || pixels >= threshold)
+    {
+        return 0;
+    }
+
+    // Each level doubles the size of the voxels.
+    auto level = static_cast<unsigned int>(glm::log2(threshold / pixels));
+    return glm::min(level, levelCount);
+}
+
+/// @brief Checks if an upload has finished, without blocking.
+/// @param upload Upload to check.
+/// @return Whether the upload is valid and its handle is ready.
+static bool isUploaded(const std::shared_future<RendererGrid>& upload)
+{
+    return upload.valid() && upload.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+/// @brief Posts an upload of a mesh to the render thread, without waiting for it.
+/// @param renderThread Render thread.
+/// @param renderer Renderer.
+/// @param mesh Finished mesh job.
+/// @return Handle of the uploaded mesh, or null if there's nothing to draw, once the upload finishes.
+static std::shared_future<RendererGrid> postUpload(RenderThread& renderThread, const Renderer& renderer, MeshJob mesh)
+{
+    auto promise = std::make_shared<std::promise<RendererGrid>>();
+    auto upload = promise->get_future().share();
+    renderThread.post([renderer, promise, mesh = std::move(mesh)] {
+        const auto& voxels = mesh.get();
+        promise->set_value(voxels.indices.empty() ? nullptr : renderer->upload(voxels));
+    });
+    return upload;
+}
+
+/// @brief Uploads the mesh of a grid region once it is ready, and picks up the handle of its
+/// previous upload once it has finished.
+/// @param renderThread Render thread.
+/// @param renderer Renderer.
+/// @param region Region.
+static void uploadIfReady(RenderThread& renderThread, const Renderer& renderer, RenderableGridRegion& region)
+{
+    // Uploads of a region finish in order, so a new one only starts once the previous has finished.
+    if (MeshJobs::isReady(region.mesh) && !region.upload.valid())
+    {
+        region.upload = postUpload(renderThread, renderer, std::move(region.mesh));
+        region.mesh = {};
+    }
+
+    // Without a running render thread, the upload has already finished.
+    if (isUploaded(region.upload))
+    {
+        region.handle = region.upload.get();
+        region.upload = {};
     }
 }
 
 static void frameGrids(Read<Assets> assets, Write<Renderer> renderer, Write<RendererFrame> frame,
-                       Query<Write<RenderableGrid>, Read<LocalToWorld>> query)
+                       Write<MeshJobs> jobs, Write<Settings> settings, Read<ActiveCameras> activeCameras,
+                       Read<Window> window, Write<RenderThread> renderThread,
+                       Query<Write<RenderableGrid>, Read<LocalToWorld>> query,
+                       Query<Read<LocalToWorld>, Read<Camera>> cameraQuery)
 {
+    auto levelCount = static_cast<unsigned int>(glm::max(settings->getInteger("cubos.renderer.lod.levels", 3), 0));
+    auto threshold = static_cast<float>(settings->getDouble("cubos.renderer.lod.threshold", 1.0));
+
+    std::vector<LodCamera> cameras;
+    for (auto entity : activeCameras->entities)
+    {
+        if (entity.isNull())
+        {
+            continue;
+        }
+
+        if (auto components = cameraQuery[entity])
+        {
+            auto [localToWorld, camera] = *components;
+            cameras.push_back({glm::vec3(localToWorld->mat[3]), camera->fovY, 0.0F});
+        }
+    }
+
+    // The screen is split between the cameras in the same way as when they're drawn, so each
+    // camera only covers the height of its own viewport.
+    BaseRenderer::Viewport viewports[4]{};
+    splitViewport({0, 0}, (*window)->framebufferSize(), static_cast<int>(cameras.size()), viewports);
+    for (std::size_t i = 0; i < cameras.size(); ++i)
+    {
+        cameras[i].viewportHeight = static_cast<float>(viewports[i].size.y);
+    }
+
     for (auto [entity, grid, localToWorld] : query)
     {
-        if (grid->handle == nullptr || assets->update(grid->asset))
+        if (grid->regions.empty() || assets->update(grid->asset))
         {
-            // If the grid wasn't already uploaded, we need to upload it now.
+            // Only the regions which changed since they were last submitted are triangulated again.
             grid->asset = assets->load(grid->asset);
             auto gridRead = assets->read(grid->asset);
-            grid->handle = (*renderer)->upload(gridRead.get());
+            const auto& voxels = gridRead.get();
+            auto count = voxels.regionCount();
+            auto regionSize = static_cast<unsigned int>(VoxelGrid::RegionSize);
+            grid->regions.resize(static_cast<std::size_t>(count.x) * count.y * count.z);
+            grid->size = voxels.size();
+
+            std::size_t i = 0;
+            for (unsigned int z = 0; z < count.z; ++z)
+            {
+                for (unsigned int y = 0; y < count.y; ++y)
+                {
+                    for (unsigned int x = 0; x < count.x; ++x, ++i)
+                    {
+                        auto& region = grid->regions[i];
+                        auto version = voxels.regionVersion({x, y, z});
+                        grid->version = glm::max(grid->version, version);
+                        if (region.version != version)
+                        {
+                            auto origin = glm::uvec3{x, y, z} * regionSize;
+                            auto end = glm::min(origin + regionSize, voxels.size());
+                            region.mesh = jobs->submit(voxels, origin, end - origin);
+                            region.version = version;
+                        }
+                    }
+                }
+            }
+        }
+
+        auto transform = localToWorld->mat * glm::translate(glm::mat4(1.0F), grid->offset);
+        auto level = pickLevel(transform, grid->size, cameras, threshold, levelCount);
+        grid->levels.resize(levelCount);
+
+        // Lower levels of detail are only triangulated when they are picked, and at most one job
+        // runs for each level, as they cover the whole grid.
+        if (level > 0)
+        {
+            auto& lod = grid->levels[level - 1];
+            if (lod.version != grid->version && !lod.mesh.valid())
+            {
+                auto gridRead = assets->read(grid->asset);
+                lod.mesh = jobs->submit(gridRead.get(), (*renderer)->palette(), level, LodSimilarity);
+                lod.version = grid->version;
+            }
+        }
+
+        // Uploads are posted to the render thread, and their handles are picked up on a later
+        // frame, once they have finished, so that the main thread never waits for them.
+        for (auto& lod : grid->levels)
+        {
+            uploadIfReady(*renderThread, *renderer, lod);
+        }
+
+        for (auto& region : grid->regions)
+        {
+            uploadIfReady(*renderThread, *renderer, region);
+        }
+
+        // As with regions, levels keep drawing their previous mesh until the new one is ready. The
+        // grid is drawn at full detail until the picked level has been triangulated once.
+        if (level > 0)
+        {
+            const auto& lod = grid->levels[level - 1];
+            if (lod.handle != nullptr)
+            {
+                frame->draw(lod.handle, transform);
+                continue;
+            }
+
+            if (lod.version != 0 && !lod.mesh.valid())
+            {
+                // The level was triangulated, but it has nothing to draw.
+                continue;
+            }
+        }
+
+        for (auto& region : grid->regions)
+        {
+            if (region.handle != nullptr)
+            {
+                frame->draw(region.handle, transform);
+            }
+        }
+    }
+}
+
+static void frameVoxelWorld(Write<Renderer> renderer, Write<RendererFrame> frame, Write<VoxelWorld> world,
+                            Write<VoxelWorldGrids> grids, Write<MeshJobs> jobs, Write<RenderThread> renderThread)
+{
+    // Only the chunks which changed since the last frame are triangulated again.
+    for (const auto& chunk : world->dirtyChunks())
+    {
+        if (world->uniform(chunk) == uint16_t{0})
+        {
+            grids->grids.erase(chunk);
+            grids->pending.erase(chunk);
+            grids->uploads.erase(chunk);
+        }
+        else
+        {
+            // The chunk is copied with the voxels around it, so that the faces hidden by its
+            // neighbours aren't generated.
+            grids->pending[chunk] = jobs->submit(world->chunkWithApron(chunk), glm::uvec3{1},
+                                                 glm::uvec3{VoxelWorld::ChunkSize});
+        }
+    }
+    world->clearDirty();
+
+    // Chunks keep their previous grid until their new mesh is ready and uploaded. As with grid
+    // regions, a new upload of a chunk only starts once the previous one has finished.
+    for (auto it = grids->pending.begin(); it != grids->pending.end();)
+    {
+        if (MeshJobs::isReady(it->second) && !grids->uploads.contains(it->first))
+        {
+            grids->uploads[it->first] = postUpload(*renderThread, *renderer, std::move(it->second));
+            it = grids->pending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (auto it = grids->uploads.begin(); it != grids->uploads.end();)
+    {
+        if (isUploaded(it->second))
+        {
+            if (auto handle = it->second.get())
+            {
+                grids->grids[it->first] = handle;
+            }
+            else
+            {
+                grids->grids.erase(it->first);
+            }
+            it = grids->uploads.erase(it);
+        }
+        else
+        {
+            ++it;
         }
+    }
 
-        frame->draw(grid->handle, localToWorld->mat * glm::translate(glm::mat4(1.0F), grid->offset));
+    // Chunk meshes are in the coordinates of the chunk's grid with its apron, which starts one
+    // voxel before the chunk.
+    for (const auto& [chunk, grid] : grids->grids)
+    {
+        frame->draw(grid, glm::translate(glm::mat4(1.0F), glm::vec3(chunk * VoxelWorld::ChunkSize - 1)));
     }
 }
 
@@ -91,41 +419,8 @@ static void frameEnvironment(Write<RendererFrame> frame, Read<RendererEnvironmen
     frame->skyGradient(env->skyGradient[0], env->skyGradient[1]);
 }
 
-/// @brief Splits the viewport recursively for the given cameras.
-/// @param position Viewport position.
-/// @param size Viewport size.
-/// @param count How many cameras need to be fitted in to the given viewport.
-/// @param viewport Output array where the viewports will be set.
-static void splitViewport(glm::ivec2 position, glm::ivec2 size, int count, BaseRenderer::Viewport* viewports)
-{
-    if (count == 1)
-    {
-        viewports[0].position = position;
-        viewports[0].size = size;
-    }
-    else if (count >= 2)
-    {
-        glm::ivec2 splitSize;
-        glm::ivec2 splitOffset;
-
-        // Split along the largest axis.
-        if (size.x > size.y)
-        {
-            splitSize = {size.x / 2, size.y};
-            splitOffset = {size.x / 2, 0};
-        }
-        else
-        {
-            splitSize = {size.x, size.y / 2};
-            splitOffset = {0, size.y / 2};
-        }
-
-        splitViewport(position, splitSize, count / 2, viewports);
-        splitViewport(position + splitOffset, splitSize, (count + 1) / 2, &viewports[count / 2]);
-    }
-}
-
 static void draw(Write<Renderer> renderer, Read<ActiveCameras> activeCameras, Write<RendererFrame> frame,
+                 Write<SubmittedFrame> submitted, Read<Window> window, Write<RenderThread> renderThread,
                  Query<Read<LocalToWorld>, Read<Camera>> query)
 {
     Camera cameras[4]{};
@@ -152,19 +447,32 @@ static void draw(Write<Renderer> renderer, Read<ActiveCameras> activeCameras, Wr
         }
     }
 
-    splitViewport({0, 0}, (*renderer)->size(), cameraCount, viewports);
+    // The renderer is resized on the render thread, so the size is read from the window instead.
+    splitViewport({0, 0}, (*window)->framebufferSize(), cameraCount, viewports);
 
     if (cameraCount == 0)
     {
         CUBOS_WARN("No active camera set - renderer skipping frame");
     }
 
+    // The previous frame must have been rendered before its buffers are reused for the next one.
+    renderThread->wait();
+    std::swap(*frame, *submitted->frame);
+    frame->clear();
+
+    // Every camera is drawn at once, so that the work they share is only done once.
+    std::vector<BaseRenderer::CameraView> cameraViews;
     for (int i = 0; i < cameraCount; ++i)
     {
-        (*renderer)->render(views[i], viewports[i], cameras[i], *frame);
+        cameraViews.push_back({views[i], viewports[i], cameras[i]});
     }
 
-    frame->clear();
+    renderThread->post([renderer = *renderer, submitted = submitted->frame, cameraViews = std::move(cameraViews)] {
+        if (!cameraViews.empty())
+        {
+            renderer->render(cameraViews, *submitted);
+        }
+    });
 }
 
 void cubos::engine::rendererPlugin(Cubos& cubos)
@@ -172,11 +480,15 @@ void cubos::engine::rendererPlugin(Cubos& cubos)
     cubos.addPlugin(transformPlugin);
     cubos.addPlugin(windowPlugin);
     cubos.addPlugin(assetsPlugin);
+    cubos.addPlugin(voxelsPlugin);
 
     cubos.addResource<RendererFrame>();
     cubos.addResource<Renderer>();
     cubos.addResource<ActiveCameras>();
     cubos.addResource<RendererEnvironment>();
+    cubos.addResource<VoxelWorldGrids>();
+    cubos.addResource<MeshJobs>();
+    cubos.addResource<SubmittedFrame>();
 
     cubos.addComponent<RenderableGrid>();
     cubos.addComponent<Camera>();
@@ -185,11 +497,12 @@ void cubos::engine::rendererPlugin(Cubos& cubos)
     cubos.addComponent<PointLight>();
 
     cubos.startupTag("cubos.renderer.init").after("cubos.window.init");
-    cubos.tag("cubos.renderer.frame").after("cubos.transform.update");
+    cubos.tag("cubos.renderer.frame").after("cubos.transform.update").after("cubos.voxels.compact");
     cubos.tag("cubos.renderer.render").after("cubos.renderer.frame").before("cubos.window.render");
 
     cubos.startupSystem(init).tagged("cubos.renderer.init");
     cubos.system(frameGrids).tagged("cubos.renderer.frame");
+    cubos.system(frameVoxelWorld).tagged("cubos.renderer.frame");
     cubos.system(frameSpotLights).tagged("cubos.renderer.frame");
     cubos.system(frameDirectionalLights).tagged("cubos.renderer.frame");
     cubos.system(framePointLights).tagged("cubos.renderer.frame");
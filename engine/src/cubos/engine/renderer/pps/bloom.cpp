@@ -7,6 +7,8 @@
 
 using namespace cubos::core::gl;
 using cubos::engine::PostProcessingBloom;
+using cubos::engine::PostProcessingPassDesc;
+using cubos::engine::PostProcessingTarget;
 
 #define CUBOS_CORE_GL_PPS_BLOOM_DOWNSCALE_PASS 0
 #define CUBOS_CORE_GL_PPS_BLOOM_UPSCALE_PASS 1
@@ -120,8 +122,6 @@ PostProcessingBloom::PostProcessingBloom(RenderDevice& renderDevice, glm::uvec2
     , mIntensity(intensity)
     , mSize(size)
 {
-    generateTextures();
-
     // Create the shader pipelines.
     /// Extraction
     auto vs = mRenderDevice.createShaderStage(Stage::Vertex, commonVs);
@@ -190,56 +190,37 @@ void PostProcessingBloom::setIntensity(float intensity)
     mIntensity = intensity;
 }
 
-void PostProcessingBloom::generateTextures()
+void PostProcessingBloom::resize(glm::uvec2 size)
 {
-    // Generate textures
-    Texture2DDesc texDesc;
-    texDesc.width = mSize.x;
-    texDesc.height = mSize.y;
-    texDesc.usage = Usage::Dynamic;
-    texDesc.format = TextureFormat::RGBA32Float;
-    mExtTex = mRenderDevice.createTexture2D(texDesc);
-
-    mBloomTexBuffer.clear();
-    mBloomTexBuffer.resize(mIterations);
-    for (unsigned int i = 0; i < mIterations; i++)
-    {
-        texDesc.width /= 2;
-        texDesc.height /= 2;
-        if (texDesc.width == 0 or texDesc.height == 0)
-        {
-            mIterations = i;
-            mBloomTexBuffer.resize(mIterations);
-            break;
-        }
-        mBloomTexBuffer[i] = mRenderDevice.createTexture2D(texDesc);
-    }
-
-    // Generate framebuffers
-    FramebufferDesc fbDesc;
-    fbDesc.targetCount = 1;
-    fbDesc.targets[0].setTexture2DTarget(mExtTex);
-    mExtFb = mRenderDevice.createFramebuffer(fbDesc);
+    mSize = size;
+}
 
-    mBloomFBs.clear();
-    mBloomFBs.resize(mIterations);
-    fbDesc.targetCount = 1;
-    for (unsigned int i = 0; i < mIterations; i++)
+PostProcessingPassDesc PostProcessingBloom::describe() const
+{
+    // The extraction target, followed by each level of the mip chain, stopping early if the
+    // window is too small for the requested number of iterations.
+    PostProcessingPassDesc desc;
+    desc.transients.push_back({mSize});
+    auto size = mSize / 2U;
+    for (unsigned int i = 0; i < mIterations && size.x > 0 && size.y > 0; i++, size /= 2U)
     {
-        fbDesc.targets[0].setTexture2DTarget(mBloomTexBuffer[i]);
-        mBloomFBs[i] = mRenderDevice.createFramebuffer(fbDesc);
+        desc.transients.push_back({size});
     }
+    return desc;
 }
 
-void PostProcessingBloom::resize(glm::uvec2 size)
+bool PostProcessingBloom::enabled() const
 {
-    mSize = size;
-    generateTextures();
+    return mIntensity > 0.0F;
 }
 
 void PostProcessingBloom::execute(std::map<PostProcessingInput, Texture2D>& /*inputs*/, Texture2D prev,
-                                  Framebuffer out) const
+                                  Framebuffer out, std::span<const PostProcessingTarget> transients) const
 {
+    const auto& extraction = transients[0];
+    auto mips = transients.subspan(1);
+    auto iterations = static_cast<unsigned int>(mips.size());
+
     // Set the framebuffer and state.
     mRenderDevice.setViewport(0, 0, static_cast<int>(mSize.x), static_cast<int>(mSize.y));
     mRenderDevice.setRasterState(nullptr);
@@ -257,7 +238,7 @@ void PostProcessingBloom::execute(std::map<PostProcessingInput, Texture2D>& /*in
     filter.w = 0.25F / (knee + 0.00001F);
 
     // Extraction pipeline, used to extract bright areas
-    mRenderDevice.setFramebuffer(mExtFb);
+    mRenderDevice.setFramebuffer(extraction.framebuffer);
     mRenderDevice.setShaderPipeline(mExtPipeline);
     mExtInputTexBp->bind(prev);
     mExtInputTexBp->bind(mTexSampler);
@@ -267,18 +248,18 @@ void PostProcessingBloom::execute(std::map<PostProcessingInput, Texture2D>& /*in
 
     // Bloom pipeline, contains multiple operations combined for creating the final effect.
     mRenderDevice.setShaderPipeline(mBloomPipeline);
-    mBloomInputTexBp->bind(mExtTex);
+    mBloomInputTexBp->bind(extraction.texture);
     mBloomInputTexBp->bind(mTexSampler);
 
     // Downscale textures
     mBloomCurrPassBp->setConstant(CUBOS_CORE_GL_PPS_BLOOM_DOWNSCALE_PASS);
     float scaling = 2.0F;
-    for (unsigned int i = 0; i < mIterations; i++)
+    for (unsigned int i = 0; i < iterations; i++)
     {
         mBloomScalingBp->setConstant(scaling);
-        mRenderDevice.setFramebuffer(mBloomFBs[i]);
+        mRenderDevice.setFramebuffer(mips[i].framebuffer);
         mRenderDevice.drawTriangles(0, 6);
-        mBloomInputTexBp->bind(mBloomTexBuffer[i]);
+        mBloomInputTexBp->bind(mips[i].texture);
         scaling *= 2.0F;
     }
 
@@ -286,13 +267,13 @@ void PostProcessingBloom::execute(std::map<PostProcessingInput, Texture2D>& /*in
     scaling /= 2.0F;
     mBloomCurrPassBp->setConstant(CUBOS_CORE_GL_PPS_BLOOM_UPSCALE_PASS);
     mRenderDevice.setBlendState(mBlendState);
-    for (int i = static_cast<int>(mIterations) - 2; i >= 0; i--)
+    for (int i = static_cast<int>(iterations) - 2; i >= 0; i--)
     {
         scaling /= 2.0F;
         mBloomScalingBp->setConstant(scaling);
-        mRenderDevice.setFramebuffer(mBloomFBs[static_cast<std::size_t>(i)]);
+        mRenderDevice.setFramebuffer(mips[static_cast<std::size_t>(i)].framebuffer);
         mRenderDevice.drawTriangles(0, 6);
-        mBloomInputTexBp->bind(mBloomTexBuffer[static_cast<std::size_t>(i)]);
+        mBloomInputTexBp->bind(mips[static_cast<std::size_t>(i)].texture);
     }
 
     // Combine the final bloom effect with source texture
@@ -5,6 +5,7 @@
 using namespace cubos::core::gl;
 using cubos::engine::PostProcessingCopy;
 using cubos::engine::PostProcessingInput;
+using cubos::engine::PostProcessingTarget;
 
 /// The vertex shader of the copy pass.
 static const char* copyVs = R"glsl(
@@ -66,7 +67,8 @@ void PostProcessingCopy::resize(glm::uvec2 size)
 }
 
 void PostProcessingCopy::execute(std::map<PostProcessingInput, core::gl::Texture2D>& /*inputs*/,
-                                 core::gl::Texture2D prev, core::gl::Framebuffer out) const
+                                 core::gl::Texture2D prev, core::gl::Framebuffer out,
+                                 std::span<const PostProcessingTarget> /*transients*/) const
 {
     // Set the framebuffer and state.
     mRenderDevice.setFramebuffer(out);
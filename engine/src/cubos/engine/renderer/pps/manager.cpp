@@ -1,11 +1,31 @@
+#include <algorithm>
+#include <cstddef>
 #include <utility>
 
+#include <cubos/engine/renderer/pps/copy_pass.hpp>
 #include <cubos/engine/renderer/pps/manager.hpp>
 #include <cubos/engine/renderer/pps/pass.hpp>
 
 using namespace cubos::core::gl;
 using cubos::engine::PostProcessingInput;
 using cubos::engine::PostProcessingManager;
+using cubos::engine::PostProcessingTargetDesc;
+
+/// @brief Pool index used for the output framebuffer, which isn't a pooled target.
+static constexpr std::size_t NoTarget = static_cast<std::size_t>(-1);
+
+/// @brief Gets a bit mask with the bits of the given inputs set.
+/// @param inputs Inputs.
+/// @return Bit mask.
+static unsigned inputMask(const std::vector<PostProcessingInput>& inputs)
+{
+    unsigned mask = 0;
+    for (auto input : inputs)
+    {
+        mask |= 1U << static_cast<unsigned>(input);
+    }
+    return mask;
+}
 
 PostProcessingManager::PostProcessingManager(RenderDevice& renderDevice, glm::uvec2 size)
     : mRenderDevice(renderDevice)
@@ -34,24 +54,16 @@ void PostProcessingManager::resize(glm::uvec2 size)
     for (auto& pass : mPasses)
     {
         pass.second->resize(size);
+        mDescs[pass.first] = pass.second->describe();
     }
 
-    // Create the intermediate texture.
-    Texture2DDesc desc;
-    desc.width = mSize.x;
-    desc.height = mSize.y;
-    desc.format = TextureFormat::RGBA32Float;
-    desc.usage = Usage::Dynamic;
-    mIntermediateTex[0] = mRenderDevice.createTexture2D(desc);
-    mIntermediateTex[1] = mRenderDevice.createTexture2D(desc);
+    if (mCopy != nullptr)
+    {
+        mCopy->resize(size);
+    }
 
-    // Create the intermediate framebuffer.
-    FramebufferDesc fbDesc;
-    fbDesc.targetCount = 1;
-    fbDesc.targets[0].setTexture2DTarget(mIntermediateTex[0]);
-    mIntermediateFb[0] = mRenderDevice.createFramebuffer(fbDesc);
-    fbDesc.targets[0].setTexture2DTarget(mIntermediateTex[1]);
-    mIntermediateFb[1] = mRenderDevice.createFramebuffer(fbDesc);
+    // The pooled targets have the old size, and will be recreated when the passes next need them.
+    mPool.clear();
 }
 
 void PostProcessingManager::provideInput(PostProcessingInput input, Texture2D texture)
@@ -63,30 +75,140 @@ void PostProcessingManager::removePass(std::size_t id)
 {
     delete mPasses[id];
     mPasses.erase(id);
+    mDescs.erase(id);
 }
 
 void PostProcessingManager::execute(const Framebuffer& out)
 {
+    // Cull the passes which are disabled or miss one of their inputs, which may be provided either
+    // by the renderer or by an earlier pass.
+    unsigned provided = 0;
+    for (const auto& [input, texture] : mInputs)
+    {
+        provided |= 1U << static_cast<unsigned>(input);
+    }
+
+    mLive.clear();
+    for (const auto& [id, pass] : mPasses)
+    {
+        const auto& desc = mDescs.at(id);
+        if (pass->enabled() && (inputMask(desc.inputs) & ~provided) == 0)
+        {
+            provided |= inputMask(desc.outputs);
+            mLive.push_back(id);
+        }
+    }
+
+    // Walking back from the output, also cull the passes whose result isn't read by the next pass
+    // and which don't provide an input read by a later pass.
+    bool prevRead = true;
+    unsigned needed = 0;
+    std::size_t first = mLive.size();
+    for (std::size_t i = mLive.size(); i-- > 0;)
+    {
+        const auto& desc = mDescs.at(mLive[i]);
+        if (!prevRead && (inputMask(desc.outputs) & needed) == 0)
+        {
+            continue;
+        }
+
+        prevRead = desc.readsPrevious;
+        needed |= inputMask(desc.inputs);
+        mLive[--first] = mLive[i];
+    }
+    mLive.erase(mLive.begin(), mLive.begin() + static_cast<std::ptrdiff_t>(first));
+
     auto prev = mInputs.at(PostProcessingInput::Lighting);
-    std::size_t nextI = 0;
+    if (mLive.empty())
+    {
+        // The renderer's output must still reach the output framebuffer.
+        if (mCopy == nullptr)
+        {
+            mCopy = std::make_unique<PostProcessingCopy>(mRenderDevice, mSize);
+        }
+        mCopy->execute(mInputs, prev, out, {});
+    }
 
-    for (auto it = mPasses.begin(); it != mPasses.end(); ++it)
+    std::size_t prevIndex = NoTarget;
+    for (std::size_t i = 0; i < mLive.size(); ++i)
     {
-        auto nextIt = it;
-        ++nextIt;
+        auto id = mLive[i];
+
+        // Lend the pass its transient targets, and a target for its result, unless it's the last pass.
+        mLent.clear();
+        mTransients.clear();
+        for (const auto& desc : mDescs.at(id).transients)
+        {
+            mLent.push_back(this->acquire(desc));
+            mTransients.push_back(mPool[mLent.back()].target);
+        }
+
+        std::size_t outIndex = NoTarget;
+        Framebuffer passOut = out;
+        if (i + 1 < mLive.size())
+        {
+            outIndex = this->acquire({mSize});
+            passOut = mPool[outIndex].target.framebuffer;
+        }
+
+        mPasses.at(id)->execute(mInputs, prev, passOut, mTransients);
 
-        if (nextIt == mPasses.end())
+        // Pooled targets published as inputs by the pass are read by later passes, and thus stay
+        // lent until the end of the execution.
+        for (auto input : mDescs.at(id).outputs)
         {
-            // If the pass is the last one, render to the output framebuffer.
-            it->second->execute(mInputs, prev, out);
+            auto it = mInputs.find(input);
+            if (it == mInputs.end())
+            {
+                continue;
+            }
+
+            for (auto& pooled : mPool)
+            {
+                if (pooled.target.texture == it->second && !pooled.published)
+                {
+                    pooled.published = true;
+                    mPublished.push_back(input);
+                }
+            }
         }
-        else
+
+        // The transient targets of the pass, and the result of the previous pass, can now be
+        // reused by the next passes.
+        for (auto index : mLent)
+        {
+            mPool[index].lent = mPool[index].published;
+        }
+        if (prevIndex != NoTarget)
+        {
+            mPool[prevIndex].lent = mPool[prevIndex].published;
+        }
+
+        if (outIndex != NoTarget)
         {
-            // Otherwise, render to the intermediate framebuffer.
-            it->second->execute(mInputs, prev, mIntermediateFb[nextI]);
-            prev = mIntermediateTex[nextI];
-            nextI = (nextI + 1) % 2;
+            prev = mPool[outIndex].target.texture;
         }
+        prevIndex = outIndex;
+    }
+
+    // Published targets are only valid during the execution, so they're removed from the inputs.
+    for (auto input : mPublished)
+    {
+        mInputs.erase(input);
+    }
+    mPublished.clear();
+    for (auto& pooled : mPool)
+    {
+        pooled.lent = false;
+        pooled.published = false;
+    }
+
+    // Free the targets which are no longer needed, e.g., because the pass which needed them was culled,
+    // which includes every target when all passes are culled.
+    std::erase_if(mPool, [](const PooledTarget& pooled) { return !pooled.used; });
+    for (auto& pooled : mPool)
+    {
+        pooled.used = false;
     }
 }
 
@@ -94,3 +216,39 @@ std::size_t PostProcessingManager::passCount() const
 {
     return mPasses.size();
 }
+
+std::size_t PostProcessingManager::pooledTargetCount() const
+{
+    return mPool.size();
+}
+
+std::size_t PostProcessingManager::acquire(const PostProcessingTargetDesc& desc)
+{
+    for (std::size_t i = 0; i < mPool.size(); ++i)
+    {
+        auto& pooled = mPool[i];
+        if (!pooled.lent && pooled.desc.size == desc.size && pooled.desc.format == desc.format)
+        {
+            pooled.lent = true;
+            pooled.used = true;
+            return i;
+        }
+    }
+
+    PooledTarget pooled{desc, {}, true, true, false};
+
+    Texture2DDesc texDesc;
+    texDesc.width = desc.size.x;
+    texDesc.height = desc.size.y;
+    texDesc.format = desc.format;
+    texDesc.usage = Usage::Dynamic;
+    pooled.target.texture = mRenderDevice.createTexture2D(texDesc);
+
+    FramebufferDesc fbDesc;
+    fbDesc.targetCount = 1;
+    fbDesc.targets[0].setTexture2DTarget(pooled.target.texture);
+    pooled.target.framebuffer = mRenderDevice.createFramebuffer(fbDesc);
+
+    mPool.push_back(std::move(pooled));
+    return mPool.size() - 1;
+}
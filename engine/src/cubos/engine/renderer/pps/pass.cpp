@@ -1,7 +1,20 @@
 #include <cubos/engine/renderer/pps/pass.hpp>
 
-cubos::engine::PostProcessingPass::PostProcessingPass(core::gl::RenderDevice& renderDevice)
+using cubos::engine::PostProcessingPass;
+using cubos::engine::PostProcessingPassDesc;
+
+PostProcessingPass::PostProcessingPass(core::gl::RenderDevice& renderDevice)
     : mRenderDevice(renderDevice)
 {
     // Do nothing.
 }
+
+PostProcessingPassDesc PostProcessingPass::describe() const
+{
+    return {};
+}
+
+bool PostProcessingPass::enabled() const
+{
+    return true;
+}
@@ -2,6 +2,10 @@
 
 using cubos::core::gl::RenderDevice;
 using cubos::engine::BaseRenderer;
+using cubos::engine::RendererGrid;
+using cubos::engine::VoxelGrid;
+using cubos::engine::VoxelMesh;
+using cubos::engine::VoxelPalette;
 
 BaseRenderer::BaseRenderer(RenderDevice& renderDevice, glm::uvec2 size)
     : mRenderDevice(renderDevice)
@@ -19,6 +23,24 @@ void BaseRenderer::resize(glm::uvec2 size)
     this->onResize(size);
 }
 
+RendererGrid BaseRenderer::upload(const VoxelGrid& grid)
+{
+    VoxelMesh mesh;
+    triangulate(grid, mesh.vertices, mesh.indices);
+    return this->upload(mesh);
+}
+
+void BaseRenderer::setPalette(const VoxelPalette& palette)
+{
+    mPalette = palette;
+    this->onSetPalette(palette);
+}
+
+const VoxelPalette& BaseRenderer::palette() const
+{
+    return mPalette;
+}
+
 glm::uvec2 BaseRenderer::size() const
 {
     return mSize;
@@ -26,16 +48,23 @@ glm::uvec2 BaseRenderer::size() const
 
 void BaseRenderer::render(const glm::mat4& view, const Viewport& viewport, const engine::Camera& camera,
                           const RendererFrame& frame, bool usePostProcessing, const core::gl::Framebuffer& target)
+{
+    CameraView cameraView{view, viewport, camera};
+    this->render({&cameraView, 1}, frame, usePostProcessing, target);
+}
+
+void BaseRenderer::render(std::span<const CameraView> views, const RendererFrame& frame, bool usePostProcessing,
+                          const core::gl::Framebuffer& target)
 {
     if (usePostProcessing && mPpsManager.passCount() > 0)
     {
-        this->onRender(view, viewport, camera, frame, mFramebuffer);
+        this->onRender(views, frame, mFramebuffer);
         mPpsManager.provideInput(PostProcessingInput::Lighting, mTexture);
         mPpsManager.execute(target);
     }
     else
     {
-        this->onRender(view, viewport, camera, frame, target);
+        this->onRender(views, frame, target);
     }
 }
 
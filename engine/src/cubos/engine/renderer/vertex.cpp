@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <bit>
 #include <vector>
 
+#include <cubos/core/log.hpp>
+
 #include <cubos/engine/renderer/vertex.hpp>
 #include <cubos/engine/voxels/grid.hpp>
 
@@ -23,14 +27,194 @@ void cubos::core::data::old::deserialize(Deserializer& deserializer, VoxelVertex
     deserializer.endObject();
 }
 
+PackedVoxelVertex PackedVoxelVertex::pack(const VoxelVertex& vertex)
+{
+    CUBOS_ASSERT(vertex.position.x <= MaxXY && vertex.position.y <= MaxXY && vertex.position.z <= MaxZ,
+                 "Vertex position ({}, {}, {}) is too large to be packed", vertex.position.x, vertex.position.y,
+                 vertex.position.z);
+
+    uint32_t normal = 0;
+    for (glm::length_t axis = 0; axis < 3; ++axis)
+    {
+        if (vertex.normal[axis] != 0.0F)
+        {
+            normal = static_cast<uint32_t>(axis) * 2 + (vertex.normal[axis] < 0.0F ? 1 : 0);
+        }
+    }
+
+    return {
+        vertex.position.x | (vertex.position.y << 14) | (normal << 28),
+        vertex.position.z | (static_cast<uint32_t>(vertex.material) << 16),
+    };
+}
+
+VoxelVertex PackedVoxelVertex::unpack() const
+{
+    VoxelVertex vertex{};
+    vertex.position = {xyNormal & MaxXY, (xyNormal >> 14) & MaxXY, zMaterial & MaxZ};
+    auto normal = (xyNormal >> 28) & 7;
+    vertex.normal[static_cast<glm::length_t>(normal / 2)] = normal % 2 == 0 ? 1.0F : -1.0F;
+    vertex.material = static_cast<uint16_t>(zMaterial >> 16);
+    return vertex;
+}
+
+/// @brief Number of bits in each word of a face bitmask.
+static constexpr std::size_t WordBits = 64;
+
+/// @brief Checks whether a bit is set in a row of a bitmask.
+/// @param row Words of the row.
+/// @param i Bit index.
+/// @return Whether the bit is set.
+static bool testBit(const uint64_t* row, std::size_t i)
+{
+    return ((row[i / WordBits] >> (i % WordBits)) & 1) != 0;
+}
+
+/// @brief Clears a range of bits in a row of a bitmask.
+/// @param row Words of the row.
+/// @param i First bit index.
+/// @param count Number of bits to clear.
+static void clearBits(uint64_t* row, std::size_t i, std::size_t count)
+{
+    while (count > 0)
+    {
+        auto bit = i % WordBits;
+        auto n = std::min(count, WordBits - bit);
+        auto mask = n == WordBits ? ~uint64_t{0} : ((uint64_t{1} << n) - 1) << bit;
+        row[i / WordBits] &= ~mask;
+        i += n;
+        count -= n;
+    }
+}
+
+/// @brief Adds a quad to a mesh.
+/// @param x Position of the first corner.
+/// @param du Offset to the second corner.
+/// @param dv Offset from the second to the third corner.
+/// @param normal Normal of the quad.
+/// @param backFace Whether the quad is a back face, which reverses its winding.
+/// @param material Material of the quad.
+/// @param vertices Vertices of the mesh.
+/// @param indices Indices of the mesh.
+static void pushQuad(const glm::ivec3& x, const glm::ivec3& du, const glm::ivec3& dv, const glm::ivec3& normal,
+                     bool backFace, uint16_t material, std::vector<VoxelVertex>& vertices,
+                     std::vector<uint32_t>& indices)
+{
+    auto vi = vertices.size();
+    vertices.resize(vi + 4, {{}, normal, material});
+    vertices[vi + 0].position = x;
+    vertices[vi + 1].position = x + du;
+    vertices[vi + 2].position = x + du + dv;
+    vertices[vi + 3].position = x + dv;
+
+    auto ii = indices.size();
+    indices.resize(ii + 6);
+    if (backFace)
+    {
+        indices[ii + 0] = static_cast<uint32_t>(vi) + 0;
+        indices[ii + 1] = static_cast<uint32_t>(vi) + 2;
+        indices[ii + 2] = static_cast<uint32_t>(vi) + 1;
+        indices[ii + 3] = static_cast<uint32_t>(vi) + 3;
+        indices[ii + 4] = static_cast<uint32_t>(vi) + 2;
+        indices[ii + 5] = static_cast<uint32_t>(vi) + 0;
+    }
+    else
+    {
+        indices[ii + 0] = static_cast<uint32_t>(vi) + 0;
+        indices[ii + 1] = static_cast<uint32_t>(vi) + 1;
+        indices[ii + 2] = static_cast<uint32_t>(vi) + 2;
+        indices[ii + 3] = static_cast<uint32_t>(vi) + 2;
+        indices[ii + 4] = static_cast<uint32_t>(vi) + 3;
+        indices[ii + 5] = static_cast<uint32_t>(vi) + 0;
+    }
+}
+
 void cubos::engine::triangulate(const VoxelGrid& grid, std::vector<VoxelVertex>& vertices,
                                 std::vector<uint32_t>& indices)
 {
-    std::vector<uint16_t> mask;
+    triangulate(grid, {0, 0, 0}, grid.size(), vertices, indices);
+}
+
+void cubos::engine::triangulate(const VoxelGrid& grid, const glm::uvec3& origin, const glm::uvec3& size,
+                                std::vector<VoxelVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    const auto& gridSize = grid.size();
+    const auto& voxels = grid.indices();
+    const std::size_t stride[3] = {1, gridSize.x,
+                                   static_cast<std::size_t>(gridSize.x) * static_cast<std::size_t>(gridSize.y)};
+
+    CUBOS_ASSERT(origin.x + size.x <= gridSize.x && origin.y + size.y <= gridSize.y && origin.z + size.z <= gridSize.z,
+                 "Region is out of the grid bounds");
+
+    // For each axis d, store the occupancy of the region as bitmasks: for each layer along d and
+    // each row along v, one bit per voxel along u. This way, the faces between two layers can be
+    // found 64 voxels at a time, by combining the rows of both layers. The layers right before and
+    // after the region are also stored, as their voxels may hide faces of the region.
+    std::vector<uint64_t> occupancy[3];
+    std::size_t words[3];
+    for (int d = 0; d < 3; ++d)
+    {
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        words[d] = (size[u] + WordBits - 1) / WordBits;
+        occupancy[d].assign((static_cast<std::size_t>(size[d]) + 2) * size[v] * words[d], 0);
+    }
+
+    // Go through the region and the voxels around it which are still inside the grid.
+    auto bit = [](std::size_t i) { return uint64_t{1} << (i % WordBits); };
+    auto begin = glm::max(glm::ivec3{origin} - 1, glm::ivec3{0});
+    auto end = glm::min(glm::ivec3{origin + size} + 1, glm::ivec3{gridSize});
+    for (int z = begin.z; z < end.z; ++z)
+    {
+        for (int y = begin.y; y < end.y; ++y)
+        {
+            auto n = static_cast<std::size_t>(begin.x) + static_cast<std::size_t>(y) * stride[1] +
+                     static_cast<std::size_t>(z) * stride[2];
+            for (int x = begin.x; x < end.x; ++x, ++n)
+            {
+                if (voxels[n] == 0)
+                {
+                    continue;
+                }
+
+                // Voxels outside of the region are only stored in the layers before and after it,
+                // and layer indices are offset by one to make room for the layer before.
+                // d = 0: layers along x, rows along z, bits along y.
+                // d = 1: layers along y, rows along x, bits along z.
+                // d = 2: layers along z, rows along y, bits along x.
+                auto local = glm::ivec3{x, y, z} - glm::ivec3{origin};
+                bool insideX = local.x >= 0 && local.x < static_cast<int>(size.x);
+                bool insideY = local.y >= 0 && local.y < static_cast<int>(size.y);
+                bool insideZ = local.z >= 0 && local.z < static_cast<int>(size.z);
+                if (insideY && insideZ)
+                {
+                    auto layer = static_cast<std::size_t>(local.x + 1);
+                    auto row = static_cast<std::size_t>(local.z);
+                    auto col = static_cast<std::size_t>(local.y);
+                    occupancy[0][(layer * size.z + row) * words[0] + col / WordBits] |= bit(col);
+                }
+                if (insideZ && insideX)
+                {
+                    auto layer = static_cast<std::size_t>(local.y + 1);
+                    auto row = static_cast<std::size_t>(local.x);
+                    auto col = static_cast<std::size_t>(local.z);
+                    occupancy[1][(layer * size.x + row) * words[1] + col / WordBits] |= bit(col);
+                }
+                if (insideX && insideY)
+                {
+                    auto layer = static_cast<std::size_t>(local.z + 1);
+                    auto row = static_cast<std::size_t>(local.y);
+                    auto col = static_cast<std::size_t>(local.x);
+                    occupancy[2][(layer * size.y + row) * words[2] + col / WordBits] |= bit(col);
+                }
+            }
+        }
+    }
 
-    const auto& sz = grid.size();
+    std::vector<uint64_t> faces;
 
-    // For both back and front faces.
+    // For both back and front faces. The order in which quads are generated matches the scalar
+    // version of this algorithm: front faces first, then for each axis, slice, row and column.
     bool backFace = true;
     do
     {
@@ -41,62 +225,72 @@ void cubos::engine::triangulate(const VoxelGrid& grid, std::vector<VoxelVertex>&
         {
             int u = (d + 1) % 3;
             int v = (d + 2) % 3;
+            auto su = static_cast<std::size_t>(size[u]);
+            auto sv = static_cast<std::size_t>(size[v]);
+            auto rowWords = words[d];
+            const auto* layers = occupancy[d].data();
+            faces.resize(sv * rowWords);
 
-            glm::ivec3 x = {0, 0, 0};
             glm::ivec3 q = {0, 0, 0};
             q[d] = 1;
-            mask.resize(static_cast<std::size_t>(sz[u]) * static_cast<std::size_t>(sz[v]));
+            auto normal = backFace ? -q : q;
 
-            for (x[d] = -1; x[d] < int(sz[d]);)
+            // For each plane between two layers, including the outer faces of the region.
+            for (int s = -1; s < int(size[d]); ++s)
             {
-                std::size_t n = 0;
+                // The faces of the plane belong to the voxels of the layer facing it.
+                int layer = backFace ? s + 1 : s;
+                if (layer < 0 || layer >= int(size[d]))
+                {
+                    continue;
+                }
 
-                // Create mask
-                for (x[v] = 0; x[v] < int(sz[v]); ++x[v])
+                // Visible faces are those of filled voxels whose neighbor across the plane is empty.
+                // Layers are offset by one in the occupancy arrays, due to the layer before the region.
+                int neighborLayer = backFace ? s : s + 1;
+                const auto* self = layers + static_cast<std::size_t>(layer + 1) * sv * rowWords;
+                const auto* neighbor = layers + static_cast<std::size_t>(neighborLayer + 1) * sv * rowWords;
+                bool any = false;
+                for (std::size_t k = 0; k < sv * rowWords; ++k)
                 {
-                    for (x[u] = 0; x[u] < int(sz[u]); ++x[u])
-                    {
-                        if (x[d] < 0)
-                        {
-                            mask[n++] = backFace ? grid.get(x + q) : 0;
-                        }
-                        else if (x[d] == int(sz[d]) - 1)
-                        {
-                            mask[n++] = backFace ? 0 : grid.get(x);
-                        }
-                        else if (grid.get(x) == 0 || grid.get(x + q) == 0)
-                        {
-                            mask[n++] = backFace ? grid.get(x + q) : grid.get(x);
-                        }
-                        else
-                        {
-                            mask[n++] = 0;
-                        }
-                    }
+                    faces[k] = self[k] & ~neighbor[k];
+                    any = any || faces[k] != 0;
                 }
 
-                ++x[d];
-                n = 0;
+                if (!any)
+                {
+                    continue;
+                }
+
+                const auto* slice = voxels.data() + (origin[d] + static_cast<std::size_t>(layer)) * stride[d] +
+                                    origin[u] * stride[u] + origin[v] * stride[v];
+                auto material = [&](std::size_t i, std::size_t j) { return slice[i * stride[u] + j * stride[v]]; };
 
-                // Generate mesh from mask
-                for (std::size_t j = 0; j < sz[v]; ++j)
+                // Greedily merge the faces into quads, jumping straight to the next face with bit scans.
+                for (std::size_t j = 0; j < sv; ++j)
                 {
-                    for (std::size_t i = 0; i < sz[u];)
+                    auto* row = faces.data() + j * rowWords;
+                    for (std::size_t word = 0; word < rowWords; ++word)
                     {
-                        if (mask[n] != 0)
+                        while (row[word] != 0)
                         {
+                            auto i = word * WordBits + static_cast<std::size_t>(std::countr_zero(row[word]));
+                            auto mat = material(i, j);
+
                             std::size_t w;
                             std::size_t h;
-                            for (w = 1; i + w < sz[u] && mask[n + w] == mask[n]; ++w)
+                            for (w = 1; i + w < su && testBit(row, i + w) && material(i + w, j) == mat; ++w)
                             {
                                 ;
                             }
+
                             bool done = false;
-                            for (h = 1; j + h < sz[v]; ++h)
+                            for (h = 1; j + h < sv; ++h)
                             {
+                                const auto* next = row + h * rowWords;
                                 for (std::size_t k = 0; k < w; ++k)
                                 {
-                                    if (mask[n + k + h * sz[u]] == 0 || mask[n + k + h * sz[u]] != mask[n])
+                                    if (!testBit(next, i + k) || material(i + k, j + h) != mat)
                                     {
                                         done = true;
                                         break;
@@ -109,60 +303,22 @@ void cubos::engine::triangulate(const VoxelGrid& grid, std::vector<VoxelVertex>&
                                 }
                             }
 
-                            if (mask[n] != 0)
-                            {
-                                x[u] = static_cast<int>(i);
-                                x[v] = static_cast<int>(j);
-
-                                glm::ivec3 du = {0, 0, 0};
-                                glm::ivec3 dv = {0, 0, 0};
-                                du[u] = static_cast<int>(w);
-                                dv[v] = static_cast<int>(h);
-
-                                auto vi = vertices.size();
-                                vertices.resize(vi + 4, {{}, backFace ? -q : q, mask[n]});
-                                vertices[vi + 0].position = x;
-                                vertices[vi + 1].position = x + du;
-                                vertices[vi + 2].position = x + du + dv;
-                                vertices[vi + 3].position = x + dv;
-
-                                auto ii = indices.size();
-                                indices.resize(ii + 6);
-                                if (backFace)
-                                {
-                                    indices[ii + 0] = static_cast<uint32_t>(vi) + 0;
-                                    indices[ii + 1] = static_cast<uint32_t>(vi) + 2;
-                                    indices[ii + 2] = static_cast<uint32_t>(vi) + 1;
-                                    indices[ii + 3] = static_cast<uint32_t>(vi) + 3;
-                                    indices[ii + 4] = static_cast<uint32_t>(vi) + 2;
-                                    indices[ii + 5] = static_cast<uint32_t>(vi) + 0;
-                                }
-                                else
-                                {
-                                    indices[ii + 0] = static_cast<uint32_t>(vi) + 0;
-                                    indices[ii + 1] = static_cast<uint32_t>(vi) + 1;
-                                    indices[ii + 2] = static_cast<uint32_t>(vi) + 2;
-                                    indices[ii + 3] = static_cast<uint32_t>(vi) + 2;
-                                    indices[ii + 4] = static_cast<uint32_t>(vi) + 3;
-                                    indices[ii + 5] = static_cast<uint32_t>(vi) + 0;
-                                }
-                            }
+                            glm::ivec3 x = {0, 0, 0};
+                            x[d] = static_cast<int>(origin[d]) + s + 1;
+                            x[u] = static_cast<int>(origin[u] + i);
+                            x[v] = static_cast<int>(origin[v] + j);
+
+                            glm::ivec3 du = {0, 0, 0};
+                            glm::ivec3 dv = {0, 0, 0};
+                            du[u] = static_cast<int>(w);
+                            dv[v] = static_cast<int>(h);
+
+                            pushQuad(x, du, dv, normal, backFace, mat, vertices, indices);
 
                             for (std::size_t l = 0; l < h; ++l)
                             {
-                                for (std::size_t k = 0; k < w; ++k)
-                                {
-                                    mask[n + k + l * sz[u]] = 0;
-                                }
+                                clearBits(row + l * rowWords, i, w);
                             }
-
-                            i += w;
-                            n += w;
-                        }
-                        else
-                        {
-                            ++i;
-                            ++n;
                         }
                     }
                 }
@@ -0,0 +1,175 @@
+/// @file
+/// @brief Minimal 4-wide float vector helpers used by data-parallel engine kernels.
+///
+/// Uses SSE when available (always the case on x86-64) and falls back to plain scalar code
+/// otherwise, so that kernels can be written once in structure-of-arrays form.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CUBOS_ENGINE_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace cubos::engine::simd
+{
+    /// @brief Number of lanes in a @ref Float4.
+    constexpr std::size_t Width = 4;
+
+    /// @brief Rounds @p count up to a multiple of @ref Width.
+    /// @param count Element count.
+    /// @return Padded element count.
+    inline std::size_t padded(std::size_t count)
+    {
+        return (count + Width - 1) / Width * Width;
+    }
+
+#ifdef CUBOS_ENGINE_SIMD_SSE
+    using Float4 = __m128;
+
+    inline Float4 load(const float* ptr)
+    {
+        return _mm_loadu_ps(ptr);
+    }
+
+    inline void store(float* ptr, Float4 v)
+    {
+        _mm_storeu_ps(ptr, v);
+    }
+
+    inline Float4 splat(float v)
+    {
+        return _mm_set1_ps(v);
+    }
+
+    inline Float4 add(Float4 a, Float4 b)
+    {
+        return _mm_add_ps(a, b);
+    }
+
+    inline Float4 sub(Float4 a, Float4 b)
+    {
+        return _mm_sub_ps(a, b);
+    }
+
+    inline Float4 mul(Float4 a, Float4 b)
+    {
+        return _mm_mul_ps(a, b);
+    }
+
+    inline Float4 min(Float4 a, Float4 b)
+    {
+        return _mm_min_ps(a, b);
+    }
+
+    inline Float4 max(Float4 a, Float4 b)
+    {
+        return _mm_max_ps(a, b);
+    }
+
+    inline Float4 abs(Float4 a)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0F), a);
+    }
+
+    inline Float4 sqrt(Float4 a)
+    {
+        return _mm_sqrt_ps(a);
+    }
+
+    /// @brief Compares two vectors lane-wise.
+    /// @return Bitmask with bit `i` set if `a[i] <= b[i]`.
+    inline int lessEqual(Float4 a, Float4 b)
+    {
+        return _mm_movemask_ps(_mm_cmple_ps(a, b));
+    }
+#else
+    struct Float4
+    {
+        float v[Width];
+    };
+
+    template <typename F>
+    inline Float4 map(Float4 a, Float4 b, F f)
+    {
+        Float4 r;
+        for (std::size_t i = 0; i < Width; ++i)
+        {
+            r.v[i] = f(a.v[i], b.v[i]);
+        }
+        return r;
+    }
+
+    inline Float4 load(const float* ptr)
+    {
+        return {{ptr[0], ptr[1], ptr[2], ptr[3]}};
+    }
+
+    inline void store(float* ptr, Float4 v)
+    {
+        for (std::size_t i = 0; i < Width; ++i)
+        {
+            ptr[i] = v.v[i];
+        }
+    }
+
+    inline Float4 splat(float v)
+    {
+        return {{v, v, v, v}};
+    }
+
+    inline Float4 add(Float4 a, Float4 b)
+    {
+        return map(a, b, [](float x, float y) { return x + y; });
+    }
+
+    inline Float4 sub(Float4 a, Float4 b)
+    {
+        return map(a, b, [](float x, float y) { return x - y; });
+    }
+
+    inline Float4 mul(Float4 a, Float4 b)
+    {
+        return map(a, b, [](float x, float y) { return x * y; });
+    }
+
+    inline Float4 min(Float4 a, Float4 b)
+    {
+        return map(a, b, [](float x, float y) { return x < y ? x : y; });
+    }
+
+    inline Float4 max(Float4 a, Float4 b)
+    {
+        return map(a, b, [](float x, float y) { return x > y ? x : y; });
+    }
+
+    inline Float4 abs(Float4 a)
+    {
+        return map(a, a, [](float x, float /*unused*/) { return std::fabs(x); });
+    }
+
+    inline Float4 sqrt(Float4 a)
+    {
+        return map(a, a, [](float x, float /*unused*/) { return std::sqrt(x); });
+    }
+
+    inline int lessEqual(Float4 a, Float4 b)
+    {
+        int mask = 0;
+        for (std::size_t i = 0; i < Width; ++i)
+        {
+            mask |= (a.v[i] <= b.v[i] ? 1 : 0) << i;
+        }
+        return mask;
+    }
+#endif
+
+    /// @brief Computes `a * b + c` lane-wise.
+    inline Float4 mulAdd(Float4 a, Float4 b, Float4 c)
+    {
+        return add(mul(a, b), c);
+    }
+} // namespace cubos::engine::simd
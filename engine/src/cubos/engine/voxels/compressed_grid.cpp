@@ -0,0 +1,414 @@
+#include <algorithm>
+
+#include <cubos/core/log.hpp>
+
+#include <cubos/engine/voxels/compressed_grid.hpp>
+
+using namespace cubos::engine;
+
+/// @brief Number of voxels in a brick.
+static constexpr std::size_t BrickVolume = CompressedVoxelGrid::BrickSize * CompressedVoxelGrid::BrickSize *
+                                           CompressedVoxelGrid::BrickSize;
+
+/// @brief Gets the smallest number of bits which can index a palette of the given size.
+///
+/// Only powers of two are used, so that indices never straddle two words.
+///
+/// @param paletteSize Number of materials in the palette.
+/// @return Number of bits.
+static uint8_t bitsFor(std::size_t paletteSize)
+{
+    if (paletteSize <= 1)
+    {
+        return 0;
+    }
+    if (paletteSize <= 2)
+    {
+        return 1;
+    }
+    if (paletteSize <= 4)
+    {
+        return 2;
+    }
+    if (paletteSize <= 16)
+    {
+        return 4;
+    }
+    if (paletteSize <= 256)
+    {
+        return 8;
+    }
+    return 16;
+}
+
+/// @brief Gets the number of bricks needed to cover a grid dimension.
+/// @param size Size of the grid in that dimension.
+/// @return Number of bricks.
+static unsigned int bricksFor(unsigned int size)
+{
+    return (size + CompressedVoxelGrid::BrickSize - 1) / CompressedVoxelGrid::BrickSize;
+}
+
+uint16_t CompressedVoxelGrid::Brick::index(std::size_t index) const
+{
+    if (bits == 0)
+    {
+        return 0;
+    }
+
+    std::size_t perWord = 64 / bits;
+    auto shift = (index % perWord) * bits;
+    auto mask = (uint64_t{1} << bits) - 1;
+    return static_cast<uint16_t>((words[index / perWord] >> shift) & mask);
+}
+
+void CompressedVoxelGrid::Brick::setIndex(std::size_t index, uint16_t paletteIndex)
+{
+    if (bits == 0)
+    {
+        CUBOS_ASSERT(paletteIndex == 0, "Palette index doesn't fit in the brick");
+        return;
+    }
+
+    std::size_t perWord = 64 / bits;
+    auto shift = (index % perWord) * bits;
+    auto mask = ((uint64_t{1} << bits) - 1) << shift;
+    auto& word = words[index / perWord];
+    word = (word & ~mask) | (static_cast<uint64_t>(paletteIndex) << shift);
+}
+
+void CompressedVoxelGrid::Brick::repack(uint8_t newBits)
+{
+    if (newBits == bits)
+    {
+        return;
+    }
+
+    std::vector<uint16_t> indices(BrickVolume);
+    for (std::size_t i = 0; i < BrickVolume; ++i)
+    {
+        indices[i] = this->index(i);
+    }
+
+    bits = newBits;
+    words.clear();
+    if (bits != 0)
+    {
+        words.resize(BrickVolume / (64 / bits), 0);
+    }
+
+    for (std::size_t i = 0; i < BrickVolume; ++i)
+    {
+        this->setIndex(i, indices[i]);
+    }
+}
+
+CompressedVoxelGrid::CompressedVoxelGrid()
+    : CompressedVoxelGrid(glm::uvec3{1, 1, 1})
+{
+}
+
+CompressedVoxelGrid::CompressedVoxelGrid(const glm::uvec3& size)
+{
+    if (size.x < 1 || size.y < 1 || size.z < 1)
+    {
+        CUBOS_WARN("Grid size must be at least 1 in each dimension: was ({}, {}, {}), defaulting to (1, 1, 1).", size.x,
+                   size.y, size.z);
+        mSize = {1, 1, 1};
+    }
+    else
+    {
+        mSize = size;
+    }
+
+    mBrickCount = {bricksFor(mSize.x), bricksFor(mSize.y), bricksFor(mSize.z)};
+    mBricks.resize(static_cast<std::size_t>(mBrickCount.x) * static_cast<std::size_t>(mBrickCount.y) *
+                   static_cast<std::size_t>(mBrickCount.z));
+}
+
+CompressedVoxelGrid::CompressedVoxelGrid(const VoxelGrid& grid)
+    : CompressedVoxelGrid(grid.size())
+{
+    std::vector<uint16_t> materials(BrickVolume);
+    std::vector<uint16_t> palette;
+    palette.reserve(BrickVolume);
+
+    auto size = glm::ivec3{mSize};
+    for (int bz = 0; bz < static_cast<int>(mBrickCount.z); ++bz)
+    {
+        for (int by = 0; by < static_cast<int>(mBrickCount.y); ++by)
+        {
+            for (int bx = 0; bx < static_cast<int>(mBrickCount.x); ++bx)
+            {
+                // Gather the materials of the brick. Voxels outside of the grid take the material
+                // of the first voxel of the brick, so that they don't add materials to its palette.
+                auto origin = glm::ivec3{bx, by, bz} * BrickSize;
+                auto padding = grid.get(origin);
+                std::size_t i = 0;
+                for (int z = 0; z < BrickSize; ++z)
+                {
+                    for (int y = 0; y < BrickSize; ++y)
+                    {
+                        for (int x = 0; x < BrickSize; ++x, ++i)
+                        {
+                            auto position = origin + glm::ivec3{x, y, z};
+                            bool inside = position.x < size.x && position.y < size.y && position.z < size.z;
+                            materials[i] = inside ? grid.get(position) : padding;
+                        }
+                    }
+                }
+
+                // Build a sorted palette with the unique materials of the brick.
+                palette.assign(materials.begin(), materials.end());
+                std::sort(palette.begin(), palette.end());
+                palette.erase(std::unique(palette.begin(), palette.end()), palette.end());
+
+                auto& brick = mBricks[static_cast<std::size_t>(bx) +
+                                      static_cast<std::size_t>(by) * mBrickCount.x +
+                                      static_cast<std::size_t>(bz) * mBrickCount.x * mBrickCount.y];
+                brick.palette = palette;
+                brick.repack(bitsFor(palette.size()));
+                for (i = 0; i < BrickVolume; ++i)
+                {
+                    auto it = std::lower_bound(palette.begin(), palette.end(), materials[i]);
+                    brick.setIndex(i, static_cast<uint16_t>(it - palette.begin()));
+                }
+            }
+        }
+    }
+}
+
+VoxelGrid CompressedVoxelGrid::decompress() const
+{
+    VoxelGrid grid{mSize};
+    auto size = glm::ivec3{mSize};
+    for (int z = 0; z < size.z; ++z)
+    {
+        for (int y = 0; y < size.y; ++y)
+        {
+            for (int x = 0; x < size.x; ++x)
+            {
+                grid.set({x, y, z}, this->get({x, y, z}));
+            }
+        }
+    }
+    return grid;
+}
+
+const glm::uvec3& CompressedVoxelGrid::size() const
+{
+    return mSize;
+}
+
+void CompressedVoxelGrid::clear()
+{
+    for (auto& brick : mBricks)
+    {
+        brick = Brick{};
+    }
+}
+
+void CompressedVoxelGrid::set(const glm::ivec3& position, uint16_t mat)
+{
+    std::size_t voxel = 0;
+    auto brickIndex = this->locate(position, voxel);
+    auto& brick = mBricks[brickIndex];
+
+    // Linear search is fine here, as brick palettes are bounded by the brick volume, and in
+    // practice only have a handful of materials.
+    auto it = std::find(brick.palette.begin(), brick.palette.end(), mat);
+    auto paletteIndex = static_cast<std::size_t>(it - brick.palette.begin());
+    if (it == brick.palette.end())
+    {
+        if (brick.palette.size() >= BrickVolume)
+        {
+            // The palette holds materials which are no longer used, drop them before it grows
+            // past what the indices can address.
+            this->compact(brickIndex);
+        }
+
+        paletteIndex = brick.palette.size();
+        brick.palette.push_back(mat);
+        brick.repack(bitsFor(brick.palette.size()));
+    }
+
+    brick.setIndex(voxel, static_cast<uint16_t>(paletteIndex));
+}
+
+uint16_t CompressedVoxelGrid::get(const glm::ivec3& position) const
+{
+    std::size_t voxel = 0;
+    const auto& brick = mBricks[this->locate(position, voxel)];
+    return brick.palette[brick.index(voxel)];
+}
+
+void CompressedVoxelGrid::compact()
+{
+    for (std::size_t b = 0; b < mBricks.size(); ++b)
+    {
+        this->compact(b);
+    }
+}
+
+std::size_t CompressedVoxelGrid::memoryUsage() const
+{
+    std::size_t bytes = 0;
+    for (const auto& brick : mBricks)
+    {
+        bytes += brick.palette.size() * sizeof(uint16_t) + brick.words.size() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+void CompressedVoxelGrid::compact(std::size_t b)
+{
+    auto& brick = mBricks[b];
+    if (brick.palette.size() <= 1)
+    {
+        return;
+    }
+
+    // Only voxels inside the grid count as uses, as the others are never read.
+    auto origin = glm::ivec3{static_cast<int>(b % mBrickCount.x), static_cast<int>((b / mBrickCount.x) % mBrickCount.y),
+                             static_cast<int>(b / (mBrickCount.x * mBrickCount.y))} *
+                  BrickSize;
+    auto extent = glm::min(glm::ivec3{mSize} - origin, glm::ivec3{BrickSize});
+
+    std::vector<bool> used(brick.palette.size(), false);
+    for (int z = 0; z < extent.z; ++z)
+    {
+        for (int y = 0; y < extent.y; ++y)
+        {
+            for (int x = 0; x < extent.x; ++x)
+            {
+                auto i = static_cast<std::size_t>(x + y * BrickSize + z * BrickSize * BrickSize);
+                used[brick.index(i)] = true;
+            }
+        }
+    }
+
+    // Give the used materials new consecutive indices.
+    std::vector<uint16_t> palette;
+    std::vector<uint16_t> remap(brick.palette.size(), 0);
+    for (std::size_t i = 0; i < brick.palette.size(); ++i)
+    {
+        if (used[i])
+        {
+            remap[i] = static_cast<uint16_t>(palette.size());
+            palette.push_back(brick.palette[i]);
+        }
+    }
+
+    if (palette.size() == brick.palette.size())
+    {
+        return;
+    }
+
+    // Remapped indices are never larger than the original ones, so they can be written before the
+    // indices are shrunk. Voxels outside of the grid end up pointing to the first material.
+    for (std::size_t i = 0; i < BrickVolume; ++i)
+    {
+        auto index = brick.index(i);
+        brick.setIndex(i, used[index] ? remap[index] : 0);
+    }
+
+    brick.palette = std::move(palette);
+    brick.repack(bitsFor(brick.palette.size()));
+}
+
+std::size_t CompressedVoxelGrid::locate(const glm::ivec3& position, std::size_t& voxel) const
+{
+    CUBOS_ASSERT(position.x >= 0 && position.y >= 0 && position.z >= 0, "Voxel position out of bounds");
+    CUBOS_ASSERT(position.x < static_cast<int>(mSize.x) && position.y < static_cast<int>(mSize.y) &&
+                     position.z < static_cast<int>(mSize.z),
+                 "Voxel position out of bounds");
+
+    auto brick = glm::uvec3{position} / static_cast<unsigned int>(BrickSize);
+    auto local = glm::uvec3{position} % static_cast<unsigned int>(BrickSize);
+    voxel = static_cast<std::size_t>(local.x + local.y * BrickSize + local.z * BrickSize * BrickSize);
+    return static_cast<std::size_t>(brick.x) + static_cast<std::size_t>(brick.y) * mBrickCount.x +
+           static_cast<std::size_t>(brick.z) * mBrickCount.x * mBrickCount.y;
+}
+
+void cubos::core::data::old::serialize(Serializer& serializer, const CompressedVoxelGrid& grid, const char* name)
+{
+    serializer.beginObject(name);
+    serializer.write(grid.mSize, "size");
+    serializer.beginArray(grid.mBricks.size(), "bricks");
+    for (const auto& brick : grid.mBricks)
+    {
+        // Run-length encode the palette indices of the brick, as pairs of length and index.
+        std::vector<uint16_t> runs;
+        for (std::size_t i = 0; i < BrickVolume;)
+        {
+            auto index = brick.index(i);
+            std::size_t length = 1;
+            while (i + length < BrickVolume && brick.index(i + length) == index)
+            {
+                length += 1;
+            }
+
+            runs.push_back(static_cast<uint16_t>(length));
+            runs.push_back(index);
+            i += length;
+        }
+
+        serializer.beginObject(nullptr);
+        serializer.write(brick.palette, "palette");
+        serializer.write(runs, "runs");
+        serializer.endObject();
+    }
+    serializer.endArray();
+    serializer.endObject();
+}
+
+void cubos::core::data::old::deserialize(Deserializer& deserializer, CompressedVoxelGrid& grid)
+{
+    glm::uvec3 size;
+    deserializer.beginObject();
+    deserializer.read(size);
+    grid = CompressedVoxelGrid{size};
+
+    std::size_t brickCount = deserializer.beginArray();
+    bool valid = brickCount == grid.mBricks.size();
+    std::vector<uint16_t> runs;
+    for (std::size_t b = 0; b < brickCount; ++b)
+    {
+        CompressedVoxelGrid::Brick brick{};
+        deserializer.beginObject();
+        deserializer.read(brick.palette);
+        deserializer.read(runs);
+        deserializer.endObject();
+
+        if (!valid || brick.palette.empty() || runs.size() % 2 != 0)
+        {
+            valid = false;
+            continue;
+        }
+
+        brick.repack(bitsFor(brick.palette.size()));
+        std::size_t i = 0;
+        for (std::size_t r = 0; r < runs.size() && valid; r += 2)
+        {
+            valid = runs[r + 1] < brick.palette.size() && i + runs[r] <= BrickVolume;
+            for (std::size_t j = 0; j < runs[r] && valid; ++j, ++i)
+            {
+                brick.setIndex(i, runs[r + 1]);
+            }
+        }
+
+        valid = valid && i == BrickVolume;
+        if (valid)
+        {
+            grid.mBricks[b] = std::move(brick);
+        }
+    }
+    deserializer.endArray();
+    deserializer.endObject();
+
+    if (!valid)
+    {
+        CUBOS_WARN("Invalid compressed voxel grid data, defaulting to an empty (1, 1, 1) grid.");
+        grid = CompressedVoxelGrid{};
+    }
+}
@@ -1,4 +1,4 @@
-#include <unordered_map>
+#include <atomic>
 
 #include <cubos/core/log.hpp>
 
@@ -7,6 +7,22 @@
 
 using namespace cubos::engine;
 
+/// @brief Gets a new region version, never returned before.
+/// @return Region version.
+static uint64_t nextVersion()
+{
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+/// @brief Gets the number of regions needed to cover a grid dimension.
+/// @param size Size of the grid in that dimension.
+/// @return Number of regions.
+static unsigned int regionsFor(unsigned int size)
+{
+    return (size + VoxelGrid::RegionSize - 1) / VoxelGrid::RegionSize;
+}
+
 VoxelGrid::VoxelGrid(const glm::uvec3& size)
 {
     if (size.x < 1 || size.y < 1 || size.z < 1)
@@ -22,6 +38,7 @@ VoxelGrid::VoxelGrid(const glm::uvec3& size)
 
     mIndices.resize(
         static_cast<std::size_t>(mSize.x) * static_cast<std::size_t>(mSize.y) * static_cast<std::size_t>(mSize.z), 0);
+    this->resetVersions();
 }
 
 VoxelGrid::VoxelGrid(const glm::uvec3& size, const std::vector<uint16_t>& indices)
@@ -45,18 +62,21 @@ VoxelGrid::VoxelGrid(const glm::uvec3& size, const std::vector<uint16_t>& indice
     }
 
     mIndices = indices;
+    this->resetVersions();
 }
 
 VoxelGrid::VoxelGrid(VoxelGrid&& other) noexcept
     : mSize(other.mSize)
 {
     new (&mIndices) std::vector<uint16_t>(std::move(other.mIndices));
+    new (&mRegionVersions) std::vector<uint64_t>(std::move(other.mRegionVersions));
 }
 
 VoxelGrid::VoxelGrid()
 {
     mSize = {1, 1, 1};
     mIndices.resize(1, 0);
+    this->resetVersions();
 }
 
 VoxelGrid& VoxelGrid::operator=(const VoxelGrid& rhs) = default;
@@ -79,6 +99,7 @@ void VoxelGrid::setSize(const glm::uvec3& size)
     mIndices.clear();
     mIndices.resize(
         static_cast<std::size_t>(mSize.x) * static_cast<std::size_t>(mSize.y) * static_cast<std::size_t>(mSize.z), 0);
+    this->resetVersions();
 }
 
 const glm::uvec3& VoxelGrid::size() const
@@ -92,6 +113,7 @@ void VoxelGrid::clear()
     {
         i = 0;
     }
+    this->resetVersions();
 }
 
 uint16_t VoxelGrid::get(const glm::ivec3& position) const
@@ -109,40 +131,209 @@ void VoxelGrid::set(const glm::ivec3& position, uint16_t mat)
     assert(position.y >= 0 && position.y < static_cast<int>(mSize.y));
     assert(position.z >= 0 && position.z < static_cast<int>(mSize.z));
     auto index = position.x + position.y * static_cast<int>(mSize.x) + position.z * static_cast<int>(mSize.x * mSize.y);
+    if (mIndices[static_cast<std::size_t>(index)] == mat)
+    {
+        return;
+    }
     mIndices[static_cast<std::size_t>(index)] = mat;
+
+    // Update the version of the region of the voxel, and of the regions next to it if the voxel is
+    // on their border, as the faces of their voxels may have become visible or hidden.
+    auto count = glm::ivec3{this->regionCount()};
+    auto region = position / RegionSize;
+    auto local = position % RegionSize;
+    auto bump = [&](const glm::ivec3& r) {
+        auto i = r.x + r.y * count.x + r.z * count.x * count.y;
+        mRegionVersions[static_cast<std::size_t>(i)] = nextVersion();
+    };
+
+    bump(region);
+    for (glm::length_t axis = 0; axis < 3; ++axis)
+    {
+        auto neighbor = region;
+        if (local[axis] == 0 && region[axis] > 0)
+        {
+            neighbor[axis] -= 1;
+            bump(neighbor);
+        }
+        else if (local[axis] == RegionSize - 1 && region[axis] + 1 < count[axis])
+        {
+            neighbor[axis] += 1;
+            bump(neighbor);
+        }
+    }
+}
+
+const std::vector<uint16_t>& VoxelGrid::indices() const
+{
+    return mIndices;
+}
+
+glm::uvec3 VoxelGrid::regionCount() const
+{
+    return {regionsFor(mSize.x), regionsFor(mSize.y), regionsFor(mSize.z)};
+}
+
+uint64_t VoxelGrid::regionVersion(const glm::uvec3& region) const
+{
+    auto count = this->regionCount();
+    assert(region.x < count.x && region.y < count.y && region.z < count.z);
+    return mRegionVersions[region.x + region.y * count.x + region.z * count.x * count.y];
+}
+
+void VoxelGrid::resetVersions()
+{
+    auto count = this->regionCount();
+    mRegionVersions.resize(static_cast<std::size_t>(count.x) * static_cast<std::size_t>(count.y) *
+                           static_cast<std::size_t>(count.z));
+    for (auto& version : mRegionVersions)
+    {
+        version = nextVersion();
+    }
 }
 
 bool VoxelGrid::convert(const VoxelPalette& src, const VoxelPalette& dst, float minSimilarity)
 {
-    // Find the mappings for every material in the source palette.
-    std::unordered_map<uint16_t, uint16_t> mappings;
-    for (uint16_t i = 0; i <= src.size(); ++i)
+    // Find the mappings for every material in the source palette. Materials without a mapping,
+    // including the ones outside of the palette, are marked as invalid.
+    std::vector<uint16_t> mappings(65536, 0);
+    std::vector<uint8_t> valid(65536, 0);
+    for (uint32_t i = 0; i <= src.size(); ++i)
     {
-        uint16_t j = dst.find(src.get(i));
-        if (src.get(i).similarity(dst.get(j)) >= minSimilarity)
+        auto mat = static_cast<uint16_t>(i);
+        uint16_t j = dst.find(src.get(mat));
+        if (src.get(mat).similarity(dst.get(j)) >= minSimilarity)
         {
             mappings[i] = j;
+            valid[i] = 1;
         }
     }
 
-    // Check if the mappings are complete for every material being used in the grid.
-    for (uint32_t i = 0; i < mSize.x * mSize.y * mSize.z; ++i)
+    // Check if the mappings are complete for every material being used in the grid. Both loops
+    // are branchless lookups into 65536 entry tables. They stay scalar: a table lookup is a gather,
+    // which the float-only helpers in simd.hpp can't express, and SSE has no gather instruction.
+    const uint16_t* indices = mIndices.data();
+    std::size_t count = mIndices.size();
+    uint8_t allValid = 1;
+    for (std::size_t i = 0; i < count; ++i)
     {
-        if (mappings.find(mIndices[i]) == mappings.end())
-        {
-            return false;
-        }
+        allValid &= valid[indices[i]];
     }
 
-    // Apply the mappings.
-    for (uint32_t i = 0; i < mSize.x * mSize.y * mSize.z; ++i)
+    if (allValid == 0)
     {
-        mIndices[i] = mappings[mIndices[i]];
+        return false;
     }
 
+    this->remap(mappings);
     return true;
 }
 
+void VoxelGrid::remap(const std::vector<uint16_t>& mappings)
+{
+    uint16_t* indices = mIndices.data();
+    std::size_t count = mIndices.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        indices[i] = mappings[indices[i]];
+    }
+    this->resetVersions();
+}
+
+VoxelGrid VoxelGrid::downsample(const VoxelPalette& palette, float minSimilarity) const
+{
+    auto size = (mSize + 1U) / 2U;
+    std::vector<uint16_t> indices;
+    indices.reserve(static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y) *
+                    static_cast<std::size_t>(size.z));
+
+    // Distinct non-empty materials of the current block, and how many of its voxels have them.
+    uint16_t materials[8];
+    int counts[8];
+
+    for (unsigned int z = 0; z < size.z; ++z)
+    {
+        for (unsigned int y = 0; y < size.y; ++y)
+        {
+            for (unsigned int x = 0; x < size.x; ++x)
+            {
+                int found = 0;
+                int empty = 0;
+                int total = 0;
+                for (unsigned int dz = 0; dz < 2; ++dz)
+                {
+                    for (unsigned int dy = 0; dy < 2; ++dy)
+                    {
+                        for (unsigned int dx = 0; dx < 2; ++dx)
+                        {
+                            auto src = glm::uvec3{x * 2 + dx, y * 2 + dy, z * 2 + dz};
+                            if (src.x >= mSize.x || src.y >= mSize.y || src.z >= mSize.z)
+                            {
+                                continue;
+                            }
+
+                            total += 1;
+                            auto mat = mIndices[src.x + src.y * mSize.x + src.z * mSize.x * mSize.y];
+                            if (mat == 0)
+                            {
+                                empty += 1;
+                                continue;
+                            }
+
+                            int i = 0;
+                            while (i < found && materials[i] != mat)
+                            {
+                                ++i;
+                            }
+
+                            if (i == found)
+                            {
+                                materials[found] = mat;
+                                counts[found] = 0;
+                                found += 1;
+                            }
+
+                            counts[i] += 1;
+                        }
+                    }
+                }
+
+                if (empty * 2 > total)
+                {
+                    indices.push_back(0);
+                    continue;
+                }
+
+                // Each material also gets the votes of the materials similar to it. Ties are broken
+                // in favour of the material which is used the most by itself.
+                int best = 0;
+                int bestVotes = 0;
+                for (int i = 0; i < found; ++i)
+                {
+                    int votes = 0;
+                    for (int j = 0; j < found; ++j)
+                    {
+                        if (i == j || palette.get(materials[i]).similarity(palette.get(materials[j])) >= minSimilarity)
+                        {
+                            votes += counts[j];
+                        }
+                    }
+
+                    if (votes > bestVotes || (votes == bestVotes && counts[i] > counts[best]))
+                    {
+                        best = i;
+                        bestVotes = votes;
+                    }
+                }
+
+                indices.push_back(materials[best]);
+            }
+        }
+    }
+
+    return {size, indices};
+}
+
 void cubos::core::data::old::serialize(Serializer& serializer, const VoxelGrid& grid, const char* name)
 {
     serializer.beginObject(name);
@@ -166,4 +357,6 @@ void cubos::core::data::old::deserialize(Deserializer& deserializer, VoxelGrid&
         grid.mIndices.clear();
         grid.mIndices.resize(1, 0);
     }
+
+    grid.resetVersions();
 }
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 #include <cubos/core/log.hpp>
@@ -6,9 +8,20 @@
 
 using namespace cubos::engine;
 
+/// @brief Number of dimensions of the k-d tree: red, green, blue and alpha.
+static constexpr int Dimensions = 4;
+
+/// @brief Minimum number of materials searched linearly before the k-d tree is rebuilt.
+static constexpr std::size_t MinLinear = 64;
+
+/// @brief Margin used when pruning the k-d tree, so that rounding errors never prune a material
+/// which would be as similar as the best one.
+static constexpr float PruneMargin = 1e-5F;
+
 VoxelPalette::VoxelPalette(std::vector<VoxelMaterial>&& materials)
     : mMaterials(std::move(materials))
 {
+    this->rebuild();
 }
 
 const VoxelMaterial* VoxelPalette::data() const
@@ -43,23 +56,14 @@ void VoxelPalette::set(uint16_t index, const VoxelMaterial& material)
     }
 
     mMaterials[index - 1] = material;
+    this->changed(index);
 }
 
 uint16_t VoxelPalette::find(const VoxelMaterial& material) const
 {
     uint16_t bestI = 0;
     float bestS = material.similarity(VoxelMaterial::Empty);
-
-    for (uint16_t i = 0; i < this->size(); ++i)
-    {
-        float s = material.similarity(this->get(i + 1));
-        if (s > bestS)
-        {
-            bestS = s;
-            bestI = i + 1;
-        }
-    }
-
+    this->search(material, bestI, bestS);
     return bestI;
 }
 
@@ -71,13 +75,15 @@ uint16_t VoxelPalette::add(const VoxelMaterial& material, float similarity)
         return i;
     }
 
-    for (uint16_t i = 0; i < this->size(); ++i)
+    // Reuse the first empty material, if there's any. Only materials with a similarity of 1 beat
+    // the starting similarity, so the search can skip most of the palette.
+    uint16_t emptyI = 0;
+    float emptyS = std::nextafter(1.0F, 0.0F);
+    this->search(VoxelMaterial::Empty, emptyI, emptyS);
+    if (emptyI != 0)
     {
-        if (this->get(i + 1).similarity(VoxelMaterial::Empty) >= 1.0F)
-        {
-            this->set(i + 1, material);
-            return i + 1;
-        }
+        this->set(emptyI, material);
+        return emptyI;
     }
 
     if (this->size() == UINT16_MAX)
@@ -87,6 +93,7 @@ uint16_t VoxelPalette::add(const VoxelMaterial& material, float similarity)
     }
 
     mMaterials.push_back(material);
+    this->changed(this->size());
     return this->size();
 }
 
@@ -98,6 +105,145 @@ void VoxelPalette::merge(const VoxelPalette& palette, float similarity)
     }
 }
 
+/// @brief Arranges the nodes in the given range as an implicit k-d tree, where the root of each
+/// range is the node in its middle.
+/// @tparam T Node type.
+/// @param nodes Nodes.
+/// @param begin First node of the range.
+/// @param end End of the range.
+/// @param axis Axis to split the range along.
+template <typename T>
+static void buildTree(std::vector<T>& nodes, std::size_t begin, std::size_t end, int axis)
+{
+    if (end - begin <= 1)
+    {
+        return;
+    }
+
+    auto mid = begin + (end - begin) / 2;
+    std::nth_element(nodes.begin() + static_cast<std::ptrdiff_t>(begin),
+                     nodes.begin() + static_cast<std::ptrdiff_t>(mid), nodes.begin() + static_cast<std::ptrdiff_t>(end),
+                     [axis](const T& a, const T& b) { return a.color[axis] < b.color[axis]; });
+    buildTree(nodes, begin, mid, (axis + 1) % Dimensions);
+    buildTree(nodes, mid + 1, end, (axis + 1) % Dimensions);
+}
+
+/// @brief Searches a range of the k-d tree for a material more similar to the given one than the
+/// current best.
+/// @tparam T Node type.
+/// @param nodes Nodes.
+/// @param begin First node of the range.
+/// @param end End of the range.
+/// @param axis Axis the range is split along.
+/// @param materials Materials of the palette.
+/// @param stale Whether each material in the tree was set since it was built.
+/// @param material Material to compare with.
+/// @param[in,out] bestI Index of the best material found so far.
+/// @param[in,out] bestS Similarity of the best material found so far.
+template <typename T>
+static void searchTree(const std::vector<T>& nodes, std::size_t begin, std::size_t end, int axis,
+                       const std::vector<VoxelMaterial>& materials, const std::vector<bool>& stale,
+                       const VoxelMaterial& material, uint16_t& bestI, float& bestS)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    auto mid = begin + (end - begin) / 2;
+    const auto& node = nodes[mid];
+    if (!stale[node.index - 1])
+    {
+        float s = material.similarity(materials[node.index - 1]);
+        if (s > bestS || (s == bestS && node.index < bestI))
+        {
+            bestS = s;
+            bestI = node.index;
+        }
+    }
+
+    // Search the side of the split which contains the material first, as it's more likely to
+    // contain similar materials, and only then the other side, if it may contain a material at
+    // least as similar as the best one.
+    float diff = material.color[axis] - node.color[axis];
+    auto next = (axis + 1) % Dimensions;
+    if (diff < 0.0F)
+    {
+        searchTree(nodes, begin, mid, next, materials, stale, material, bestI, bestS);
+    }
+    else
+    {
+        searchTree(nodes, mid + 1, end, next, materials, stale, material, bestI, bestS);
+    }
+
+    if (1.0F - glm::abs(diff) / 4.0F >= bestS - PruneMargin)
+    {
+        if (diff < 0.0F)
+        {
+            searchTree(nodes, mid + 1, end, next, materials, stale, material, bestI, bestS);
+        }
+        else
+        {
+            searchTree(nodes, begin, mid, next, materials, stale, material, bestI, bestS);
+        }
+    }
+}
+
+void VoxelPalette::rebuild()
+{
+    mTree.clear();
+    mTree.reserve(mMaterials.size());
+    for (std::size_t i = 0; i < mMaterials.size(); ++i)
+    {
+        mTree.push_back({mMaterials[i].color, static_cast<uint16_t>(i + 1)});
+    }
+
+    buildTree(mTree, 0, mTree.size(), 0);
+    mStale.assign(mTree.size(), false);
+    mChanged.clear();
+}
+
+void VoxelPalette::changed(uint16_t index)
+{
+    if (index <= mTree.size() && !mStale[index - 1])
+    {
+        mStale[index - 1] = true;
+        mChanged.push_back(index);
+    }
+
+    // Rebuilding takes O(n log n), so by only doing it once the number of materials searched
+    // linearly is a fraction of the size of the tree, its cost is amortized.
+    auto linear = mChanged.size() + (mMaterials.size() - mTree.size());
+    if (linear > std::max(MinLinear, mTree.size() / 16))
+    {
+        this->rebuild();
+    }
+}
+
+void VoxelPalette::search(const VoxelMaterial& material, uint16_t& bestI, float& bestS) const
+{
+    searchTree(mTree, 0, mTree.size(), 0, mMaterials, mStale, material, bestI, bestS);
+
+    auto check = [&](uint16_t index) {
+        float s = material.similarity(mMaterials[index - 1]);
+        if (s > bestS || (s == bestS && index < bestI))
+        {
+            bestS = s;
+            bestI = index;
+        }
+    };
+
+    for (auto index : mChanged)
+    {
+        check(index);
+    }
+
+    for (std::size_t i = mTree.size(); i < mMaterials.size(); ++i)
+    {
+        check(static_cast<uint16_t>(i + 1));
+    }
+}
+
 void cubos::core::data::old::serialize(Serializer& serializer, const VoxelPalette& palette, const char* name)
 {
     // Count non-empty materials.
@@ -147,4 +293,5 @@ void cubos::core::data::old::deserialize(Deserializer& deserializer, VoxelPalett
         palette.mMaterials[index - 1] = mat;
     }
     deserializer.endDictionary();
+    palette.rebuild();
 }
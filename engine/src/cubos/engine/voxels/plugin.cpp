@@ -3,6 +3,7 @@
 #include <cubos/engine/voxels/grid.hpp>
 #include <cubos/engine/voxels/palette.hpp>
 #include <cubos/engine/voxels/plugin.hpp>
+#include <cubos/engine/voxels/world.hpp>
 
 using cubos::core::ecs::Write;
 using namespace cubos::engine;
@@ -14,9 +15,19 @@ static void bridges(Write<Assets> assets)
     assets->registerBridge(".pal", std::make_unique<BinaryBridge<VoxelPalette>>());
 }
 
+static void compact(Write<VoxelWorld> world)
+{
+    // Only the chunks which were modified since the last frame are checked.
+    world->compact();
+}
+
 void cubos::engine::voxelsPlugin(Cubos& cubos)
 {
     cubos.addPlugin(assetsPlugin);
 
+    cubos.addResource<VoxelWorld>();
+
     cubos.startupSystem(bridges).tagged("cubos.assets.bridge");
+
+    cubos.system(compact).tagged("cubos.voxels.compact");
 }
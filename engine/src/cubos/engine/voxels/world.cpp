@@ -0,0 +1,352 @@
+#include <cubos/core/log.hpp>
+
+#include <cubos/engine/voxels/palette.hpp>
+#include <cubos/engine/voxels/world.hpp>
+
+using namespace cubos::engine;
+
+/// @brief Number of voxels in a chunk.
+static constexpr int ChunkVolume = VoxelWorld::ChunkSize * VoxelWorld::ChunkSize * VoxelWorld::ChunkSize;
+
+/// @brief Divides a coordinate by the chunk size, rounding down.
+/// @param coord Coordinate.
+/// @return Chunk coordinate.
+static int floorDiv(int coord)
+{
+    return coord >= 0 ? coord / VoxelWorld::ChunkSize : (coord + 1) / VoxelWorld::ChunkSize - 1;
+}
+
+std::size_t VoxelWorld::ChunkHash::operator()(const glm::ivec3& chunk) const
+{
+    auto hash = std::hash<int>()(chunk.x);
+    hash = hash * 31 + std::hash<int>()(chunk.y);
+    hash = hash * 31 + std::hash<int>()(chunk.z);
+    return hash;
+}
+
+void VoxelWorld::clear()
+{
+    for (const auto& [position, chunk] : mChunks)
+    {
+        mDirty.insert(position);
+    }
+
+    mChunks.clear();
+    mModified.clear();
+}
+
+void VoxelWorld::set(const glm::ivec3& position, uint16_t mat)
+{
+    auto chunkPosition = chunkOf(position);
+    auto it = mChunks.find(chunkPosition);
+    if (it == mChunks.end())
+    {
+        if (mat == 0)
+        {
+            // Setting a voxel of an empty chunk to empty doesn't change anything.
+            return;
+        }
+
+        it = mChunks.emplace(chunkPosition, Chunk{}).first;
+    }
+
+    auto& chunk = it->second;
+    if (chunk.grid == nullptr)
+    {
+        if (chunk.uniform == mat)
+        {
+            return;
+        }
+
+        // The chunk is no longer uniform, so we must store its voxels.
+        chunk.grid = std::make_unique<VoxelGrid>(
+            glm::uvec3{ChunkSize}, std::vector<uint16_t>(static_cast<std::size_t>(ChunkVolume), chunk.uniform));
+    }
+
+    auto local = position - chunkPosition * ChunkSize;
+    bool wasEmpty = chunk.grid->get(local) == 0;
+    chunk.grid->set(local, mat);
+    mDirty.insert(chunkPosition);
+    mModified.insert(chunkPosition);
+
+    // Voxels on the border of a chunk hide the faces of the voxels of the neighbouring chunks
+    // which touch them, so those chunks must also be marked as dirty if the voxel was filled or
+    // emptied.
+    if (wasEmpty == (mat == 0))
+    {
+        return;
+    }
+
+    for (glm::length_t axis = 0; axis < 3; ++axis)
+    {
+        for (int side : {-1, 1})
+        {
+            if (local[axis] != (side < 0 ? 0 : ChunkSize - 1))
+            {
+                continue;
+            }
+
+            auto neighbour = chunkPosition;
+            neighbour[axis] += side;
+            if (mChunks.contains(neighbour))
+            {
+                mDirty.insert(neighbour);
+            }
+        }
+    }
+}
+
+uint16_t VoxelWorld::get(const glm::ivec3& position) const
+{
+    auto chunkPosition = chunkOf(position);
+    auto it = mChunks.find(chunkPosition);
+    if (it == mChunks.end())
+    {
+        return 0;
+    }
+
+    const auto& chunk = it->second;
+    if (chunk.grid == nullptr)
+    {
+        return chunk.uniform;
+    }
+
+    return chunk.grid->get(position - chunkPosition * ChunkSize);
+}
+
+void VoxelWorld::paste(const VoxelGrid& grid, const glm::ivec3& offset)
+{
+    auto size = glm::ivec3{grid.size()};
+    for (int z = 0; z < size.z; ++z)
+    {
+        for (int y = 0; y < size.y; ++y)
+        {
+            for (int x = 0; x < size.x; ++x)
+            {
+                this->set(offset + glm::ivec3{x, y, z}, grid.get({x, y, z}));
+            }
+        }
+    }
+
+    this->compact();
+}
+
+bool VoxelWorld::convert(const VoxelPalette& src, const VoxelPalette& dst, float minSimilarity)
+{
+    // Find the mappings for every material in the source palette. Materials without a mapping,
+    // including the ones outside of the palette, are marked as invalid.
+    std::vector<uint16_t> mappings(65536, 0);
+    std::vector<uint8_t> valid(65536, 0);
+    for (uint32_t i = 0; i <= src.size(); ++i)
+    {
+        auto mat = static_cast<uint16_t>(i);
+        uint16_t j = dst.find(src.get(mat));
+        if (src.get(mat).similarity(dst.get(j)) >= minSimilarity)
+        {
+            mappings[i] = j;
+            valid[i] = 1;
+        }
+    }
+
+    // Check if the mappings are complete for every material being used in the world. Chunks
+    // which aren't stored are empty, so the empty material must also have a mapping.
+    uint8_t allValid = valid[0];
+    for (const auto& [position, chunk] : mChunks)
+    {
+        if (chunk.grid == nullptr)
+        {
+            allValid &= valid[chunk.uniform];
+            continue;
+        }
+
+        for (auto index : chunk.grid->indices())
+        {
+            allValid &= valid[index];
+        }
+    }
+
+    if (allValid == 0)
+    {
+        return false;
+    }
+
+    // Apply the mappings to the storage of each chunk at once. Different materials may be mapped
+    // to the same one, so dense chunks may become uniform.
+    for (auto& [position, chunk] : mChunks)
+    {
+        mDirty.insert(position);
+
+        if (chunk.grid == nullptr)
+        {
+            chunk.uniform = mappings[chunk.uniform];
+            continue;
+        }
+
+        chunk.grid->remap(mappings);
+        mModified.insert(position);
+    }
+    this->compact();
+
+    if (mappings[0] != 0)
+    {
+        CUBOS_WARN("Converting a voxel world maps the empty material to {}, but chunks which aren't stored will "
+                   "remain empty",
+                   mappings[0]);
+    }
+
+    return true;
+}
+
+void VoxelWorld::compact()
+{
+    for (const auto& position : mModified)
+    {
+        auto it = mChunks.find(position);
+        if (it == mChunks.end() || it->second.grid == nullptr)
+        {
+            continue;
+        }
+
+        auto& chunk = it->second;
+        auto first = chunk.grid->get({0, 0, 0});
+        bool isUniform = true;
+        for (int z = 0; z < ChunkSize && isUniform; ++z)
+        {
+            for (int y = 0; y < ChunkSize && isUniform; ++y)
+            {
+                for (int x = 0; x < ChunkSize && isUniform; ++x)
+                {
+                    isUniform = chunk.grid->get({x, y, z}) == first;
+                }
+            }
+        }
+
+        if (!isUniform)
+        {
+            continue;
+        }
+
+        if (first == 0)
+        {
+            mChunks.erase(it);
+        }
+        else
+        {
+            chunk.uniform = first;
+            chunk.grid.reset();
+        }
+    }
+
+    mModified.clear();
+}
+
+glm::ivec3 VoxelWorld::chunkOf(const glm::ivec3& position)
+{
+    return {floorDiv(position.x), floorDiv(position.y), floorDiv(position.z)};
+}
+
+std::vector<glm::ivec3> VoxelWorld::chunks() const
+{
+    std::vector<glm::ivec3> positions;
+    positions.reserve(mChunks.size());
+    for (const auto& [position, chunk] : mChunks)
+    {
+        positions.push_back(position);
+    }
+    return positions;
+}
+
+std::size_t VoxelWorld::chunkCount() const
+{
+    return mChunks.size();
+}
+
+std::size_t VoxelWorld::denseChunkCount() const
+{
+    std::size_t count = 0;
+    for (const auto& [position, chunk] : mChunks)
+    {
+        if (chunk.grid != nullptr)
+        {
+            count += 1;
+        }
+    }
+    return count;
+}
+
+std::optional<uint16_t> VoxelWorld::uniform(const glm::ivec3& chunk) const
+{
+    auto it = mChunks.find(chunk);
+    if (it == mChunks.end())
+    {
+        return uint16_t{0};
+    }
+
+    if (it->second.grid != nullptr)
+    {
+        return {};
+    }
+
+    return it->second.uniform;
+}
+
+VoxelGrid VoxelWorld::chunk(const glm::ivec3& chunk) const
+{
+    auto it = mChunks.find(chunk);
+    if (it == mChunks.end())
+    {
+        return VoxelGrid{glm::uvec3{ChunkSize}};
+    }
+
+    if (it->second.grid == nullptr)
+    {
+        return VoxelGrid{glm::uvec3{ChunkSize},
+                         std::vector<uint16_t>(static_cast<std::size_t>(ChunkVolume), it->second.uniform)};
+    }
+
+    VoxelGrid grid;
+    grid = *it->second.grid;
+    return grid;
+}
+
+VoxelGrid VoxelWorld::chunkWithApron(const glm::ivec3& chunk) const
+{
+    constexpr int ApronSize = ChunkSize + 2;
+    VoxelGrid grid{glm::uvec3{ApronSize}};
+
+    // Copy the chunk itself directly from its storage, and only look up the voxels around it.
+    auto it = mChunks.find(chunk);
+    const VoxelGrid* stored = it == mChunks.end() ? nullptr : it->second.grid.get();
+    uint16_t uniform = it == mChunks.end() ? 0 : it->second.uniform;
+    auto origin = chunk * ChunkSize - 1;
+    for (int z = 0; z < ApronSize; ++z)
+    {
+        for (int y = 0; y < ApronSize; ++y)
+        {
+            for (int x = 0; x < ApronSize; ++x)
+            {
+                bool inside = x > 0 && x <= ChunkSize && y > 0 && y <= ChunkSize && z > 0 && z <= ChunkSize;
+                if (!inside)
+                {
+                    grid.set({x, y, z}, this->get(origin + glm::ivec3{x, y, z}));
+                }
+                else
+                {
+                    grid.set({x, y, z}, stored == nullptr ? uniform : stored->get({x - 1, y - 1, z - 1}));
+                }
+            }
+        }
+    }
+
+    return grid;
+}
+
+const VoxelWorld::ChunkSet& VoxelWorld::dirtyChunks() const
+{
+    return mDirty;
+}
+
+void VoxelWorld::clearDirty()
+{
+    mDirty.clear();
+}
@@ -1,5 +1,8 @@
+#include <cubos/core/gl/render_device.hpp>
+
 #include <cubos/engine/settings/plugin.hpp>
 #include <cubos/engine/window/plugin.hpp>
+#include <cubos/engine/window/render_thread.hpp>
 
 using cubos::core::ecs::EventWriter;
 using cubos::core::ecs::Read;
@@ -10,11 +13,18 @@ using cubos::core::io::WindowEvent;
 
 using namespace cubos::engine;
 
-static void init(Write<Window> window, Write<ShouldQuit> quit, Write<Settings> settings)
+static void init(Write<Window> window, Write<RenderThread> renderThread, Write<ShouldQuit> quit,
+                 Write<Settings> settings)
 {
     quit->value = false;
     *window = openWindow(settings->getString("window.title", "CUBOS."),
                          {settings->getInteger("window.width", 800), settings->getInteger("window.height", 600)});
+    (*window)->renderDevice().setShaderPipelineCache(settings->getString("window.shaderCache", ""));
+
+    if (settings->getBool("window.renderThread", true))
+    {
+        renderThread->start(*window);
+    }
 }
 
 static void poll(Read<Window> window, Write<ShouldQuit> quit, EventWriter<WindowEvent> events)
@@ -31,9 +41,16 @@ static void poll(Read<Window> window, Write<ShouldQuit> quit, EventWriter<Window
     }
 }
 
-static void render(Read<Window> window)
+static void render(Read<Window> window, Write<RenderThread> renderThread, Read<ShouldQuit> quit)
 {
-    (*window)->swapBuffers();
+    renderThread->post([window = *window] { window->swapBuffers(); });
+
+    // Resources which hold render device objects are destroyed on the main thread, so the context
+    // must be moved back to it before the engine stops.
+    if (quit->value)
+    {
+        renderThread->stop();
+    }
 }
 
 void cubos::engine::windowPlugin(Cubos& cubos)
@@ -41,6 +58,7 @@ void cubos::engine::windowPlugin(Cubos& cubos)
     cubos.addPlugin(settingsPlugin);
 
     cubos.addResource<Window>();
+    cubos.addResource<RenderThread>();
     cubos.addEvent<WindowEvent>();
 
     cubos.startupTag("cubos.window.init").after("cubos.settings");
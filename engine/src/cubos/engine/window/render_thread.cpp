@@ -0,0 +1,113 @@
+#include <cubos/engine/window/render_thread.hpp>
+
+using cubos::engine::RenderThread;
+
+RenderThread::~RenderThread()
+{
+    this->stop();
+}
+
+void RenderThread::start(core::io::Window window)
+{
+    if (this->running())
+    {
+        return;
+    }
+
+    mWindow = std::move(window);
+    mWindow->releaseContext();
+    mStopping = false;
+    mThread = std::thread([this] { this->run(); });
+}
+
+void RenderThread::stop()
+{
+    if (!this->running())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mJobPosted.notify_one();
+    mThread.join();
+
+    mWindow->makeContextCurrent();
+    mWindow = nullptr;
+}
+
+bool RenderThread::running() const
+{
+    return mThread.joinable();
+}
+
+void RenderThread::post(std::function<void()> job)
+{
+    if (!this->running())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mJobPosted.notify_one();
+}
+
+void RenderThread::wait()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this] { return mJobs.empty() && !mBusy; });
+}
+
+void RenderThread::call(const std::function<void()>& job)
+{
+    if (!this->running())
+    {
+        job();
+        return;
+    }
+
+    // Borrow the context from the thread, which stays idle until it's given back, as no other
+    // jobs are posted in the meantime.
+    this->post([this] { mWindow->releaseContext(); });
+    this->wait();
+    mWindow->makeContextCurrent();
+    job();
+    mWindow->releaseContext();
+    this->post([this] { mWindow->makeContextCurrent(); });
+}
+
+void RenderThread::run()
+{
+    mWindow->makeContextCurrent();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        mJobPosted.wait(lock, [this] { return !mJobs.empty() || mStopping; });
+        if (mJobs.empty())
+        {
+            break;
+        }
+
+        auto job = std::move(mJobs.front());
+        mJobs.pop_front();
+        mBusy = true;
+        lock.unlock();
+        job();
+        lock.lock();
+        mBusy = false;
+
+        if (mJobs.empty())
+        {
+            mIdle.notify_all();
+        }
+    }
+
+    mWindow->releaseContext();
+}
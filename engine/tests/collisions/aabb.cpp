@@ -1,5 +1,6 @@
 #include <doctest/doctest.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <cubos/engine/collisions/aabb.hpp>
 #include <cubos/engine/collisions/colliders/box.hpp>
@@ -7,6 +8,7 @@
 #include <cubos/engine/collisions/colliders/plane.hpp>
 #include <cubos/engine/collisions/colliders/simplex.hpp>
 #include <cubos/engine/collisions/plugin.hpp>
+#include <cubos/engine/transform/plugin.hpp>
 
 using cubos::core::ecs::Commands;
 using cubos::core::ecs::OptRead;
@@ -27,6 +29,43 @@ static void setup(Commands commands)
     commands.create(PlaneCollider{glm::vec3{0.0F}, Plane{glm::vec3{1.0F}}});
 }
 
+static void setupTransformed(Commands commands)
+{
+    auto position = Position{glm::vec3{1.0F, 2.0F, 3.0F}};
+    commands.create(LocalToWorld{}, position, BoxCollider{glm::mat4{1.0F}, Box{glm::vec3{1.0F, 2.0F, 3.0F}}, 0.0F});
+    commands.create(LocalToWorld{}, position, CapsuleCollider{glm::mat4{1.0F}, Capsule{1.0F, 2.0F}});
+    commands.create(LocalToWorld{}, position,
+                    SimplexCollider{glm::vec3{0.0F}, Simplex{{glm::vec3{-1.0F}, glm::vec3{1.0F}}}, 0.0F});
+}
+
+static void setupRotated(Commands commands)
+{
+    // Rotated by 90 degrees around Z, so that the local X and Y axes are swapped.
+    auto position = Position{glm::vec3{1.0F, 2.0F, 3.0F}};
+    auto rotation = Rotation{glm::angleAxis(glm::radians(90.0F), glm::vec3{0.0F, 0.0F, 1.0F})};
+    commands.create(LocalToWorld{}, position, rotation,
+                    BoxCollider{glm::mat4{1.0F}, Box{glm::vec3{1.0F, 2.0F, 3.0F}}, 0.0F});
+    commands.create(LocalToWorld{}, position, rotation, CapsuleCollider{glm::mat4{1.0F}, Capsule{1.0F, 2.0F}});
+}
+
+/// @brief Number of colliders spawned to test the parallel path, more than fit in a single block.
+static constexpr int ManyCount = 2500;
+
+static void setupMany(Commands commands)
+{
+    for (int i = 0; i < ManyCount; ++i)
+    {
+        auto position = Position{glm::vec3{static_cast<float>(i), 0.0F, 0.0F}};
+        commands.create(LocalToWorld{}, position, BoxCollider{glm::mat4{1.0F}, Box{glm::vec3{0.5F}}, 0.0F});
+    }
+}
+
+/// @brief Checks if two vectors are equal, up to rounding errors.
+static bool approxEqual(glm::vec3 a, glm::vec3 b)
+{
+    return glm::all(glm::lessThan(glm::abs(a - b), glm::vec3{1e-4F}));
+}
+
 template <typename C>
 void testAddMissingAABBs(Query<Read<C>, OptRead<ColliderAABB>> query)
 {
@@ -36,6 +75,65 @@ void testAddMissingAABBs(Query<Read<C>, OptRead<ColliderAABB>> query)
     }
 }
 
+static void testBoxAABB(Query<Read<BoxCollider>, Read<ColliderAABB>> query)
+{
+    for (auto [entity, collider, aabb] : query)
+    {
+        CHECK(aabb->min == glm::vec3{0.0F, 0.0F, 0.0F});
+        CHECK(aabb->max == glm::vec3{2.0F, 4.0F, 6.0F});
+    }
+}
+
+static void testCapsuleAABB(Query<Read<CapsuleCollider>, Read<ColliderAABB>> query)
+{
+    for (auto [entity, collider, aabb] : query)
+    {
+        CHECK(aabb->min == glm::vec3{0.0F, 0.0F, 2.0F});
+        CHECK(aabb->max == glm::vec3{2.0F, 4.0F, 4.0F});
+    }
+}
+
+static void testSimplexAABB(Query<Read<SimplexCollider>, Read<ColliderAABB>> query)
+{
+    for (auto [entity, collider, aabb] : query)
+    {
+        CHECK(aabb->min == glm::vec3{0.0F, 1.0F, 2.0F});
+        CHECK(aabb->max == glm::vec3{2.0F, 3.0F, 4.0F});
+    }
+}
+
+static void testRotatedBoxAABB(Query<Read<BoxCollider>, Read<ColliderAABB>> query)
+{
+    for (auto [entity, collider, aabb] : query)
+    {
+        CHECK(approxEqual(aabb->min, {-1.0F, 1.0F, 0.0F}));
+        CHECK(approxEqual(aabb->max, {3.0F, 3.0F, 6.0F}));
+    }
+}
+
+static void testRotatedCapsuleAABB(Query<Read<CapsuleCollider>, Read<ColliderAABB>> query)
+{
+    for (auto [entity, collider, aabb] : query)
+    {
+        CHECK(approxEqual(aabb->min, {-1.0F, 1.0F, 2.0F}));
+        CHECK(approxEqual(aabb->max, {3.0F, 3.0F, 4.0F}));
+    }
+}
+
+static void testManyAABBs(Query<Read<Position>, Read<BoxCollider>, Read<ColliderAABB>> query)
+{
+    int count = 0;
+    bool allCorrect = true;
+    for (auto [entity, position, collider, aabb] : query)
+    {
+        allCorrect = allCorrect && approxEqual(aabb->min, position->vec - 0.5F);
+        allCorrect = allCorrect && approxEqual(aabb->max, position->vec + 0.5F);
+        count += 1;
+    }
+    CHECK(count == ManyCount);
+    CHECK(allCorrect);
+}
+
 TEST_CASE("collisions.aabb")
 {
     auto cubos = Cubos{};
@@ -52,4 +150,52 @@ TEST_CASE("collisions.aabb")
     }
 
     cubos.run();
-}
\ No newline at end of file
+}
+
+TEST_CASE("collisions.aabb.update")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.system(setupTransformed).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+
+    SUBCASE("box, capsule and simplex aabbs were computed")
+    {
+        cubos.system(testBoxAABB).after("cubos.collisions.aabb");
+        cubos.system(testCapsuleAABB).after("cubos.collisions.aabb");
+        cubos.system(testSimplexAABB).after("cubos.collisions.aabb");
+    }
+
+    cubos.run();
+}
+
+TEST_CASE("collisions.aabb.rotated")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.system(setupRotated).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+
+    SUBCASE("box and capsule aabbs cover their rotated shapes")
+    {
+        cubos.system(testRotatedBoxAABB).after("cubos.collisions.aabb");
+        cubos.system(testRotatedCapsuleAABB).after("cubos.collisions.aabb");
+    }
+
+    cubos.run();
+}
+
+TEST_CASE("collisions.aabb.many")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.system(setupMany).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+
+    SUBCASE("aabbs split over several blocks were all computed")
+    {
+        cubos.system(testManyAABBs).after("cubos.collisions.aabb");
+    }
+
+    cubos.run();
+}
@@ -0,0 +1,314 @@
+#include <any>
+
+#include <doctest/doctest.h>
+#include <glm/glm.hpp>
+
+#include <cubos/core/ecs/event_reader.hpp>
+
+#include <cubos/engine/collisions/aabb.hpp>
+#include <cubos/engine/collisions/broad_phase_collisions.hpp>
+#include <cubos/engine/collisions/colliders/box.hpp>
+#include <cubos/engine/collisions/collision_events.hpp>
+#include <cubos/engine/collisions/collision_layers.hpp>
+#include <cubos/engine/collisions/plugin.hpp>
+#include <cubos/engine/transform/plugin.hpp>
+
+using cubos::core::ecs::Commands;
+using cubos::core::ecs::EventReader;
+using cubos::core::ecs::Query;
+using cubos::core::ecs::Read;
+using cubos::core::ecs::Write;
+using cubos::core::geom::Box;
+using namespace cubos::engine;
+
+static void setup(Commands commands)
+{
+    commands.create(LocalToWorld{}, Position{}, BoxCollider{});
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.5F}}, BoxCollider{});
+    commands.create(LocalToWorld{}, Position{glm::vec3{10.0F}}, BoxCollider{});
+}
+
+static void setupLayers(Commands commands)
+{
+    // Two overlapping static colliders.
+    commands.create(LocalToWorld{}, Position{}, BoxCollider{}, CollisionLayers{1, 0xFFFFFFFF, true});
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.1F}}, BoxCollider{}, CollisionLayers{1, 0xFFFFFFFF, true});
+
+    // Two overlapping colliders in the second layer, which ignore the first layer.
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.2F}}, BoxCollider{}, CollisionLayers{2, 2, false});
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.3F}}, BoxCollider{}, CollisionLayers{2, 2, false});
+}
+
+static void setupSleeping(Commands commands, Write<BroadPhaseCollisions> collisions)
+{
+    // Colliders fall asleep as soon as their AABBs are first computed.
+    collisions->framesToSleep = 0;
+
+    commands.create(LocalToWorld{}, Position{}, BoxCollider{}, CollisionLayers{});
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.5F}}, BoxCollider{}, CollisionLayers{});
+}
+
+/// @brief Stops the app once the pair cache has been updated the given number of times.
+template <std::size_t Frames>
+static void quitAfter(Write<ShouldQuit> quit, Read<BroadPhaseCollisions> collisions)
+{
+    quit->value = collisions->frame >= Frames;
+}
+
+static void testStarted(EventReader<CollisionStarted> started, Read<BroadPhaseCollisions> collisions)
+{
+    std::size_t count = 0;
+    for (const auto& event : started)
+    {
+        CHECK(event.type == BroadPhaseCollisions::CollisionType::BoxBox);
+        CHECK(BroadPhaseCollisions::canonical(event.other, event.entity) ==
+              BroadPhaseCollisions::Candidate{event.entity, event.other});
+
+        const auto* pair = collisions->pair(event.other, event.entity);
+        REQUIRE(pair != nullptr);
+        CHECK(pair->firstFrame == collisions->frame);
+        CHECK(pair->lastFrame == collisions->frame);
+        count += 1;
+    }
+
+    CHECK(count == 1);
+    CHECK(collisions->pairs.size() == 1);
+}
+
+static void setupPair(Commands commands)
+{
+    commands.create(LocalToWorld{}, Position{}, BoxCollider{});
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.5F}}, BoxCollider{});
+}
+
+static void attachUserData(Write<BroadPhaseCollisions> collisions)
+{
+    if (collisions->frame == 1)
+    {
+        for (auto& [candidate, pair] : collisions->pairs)
+        {
+            pair.userData = 42;
+        }
+    }
+}
+
+static void moveApart(Query<Write<Position>, Read<BoxCollider>> query, Read<BroadPhaseCollisions> collisions)
+{
+    // After the pair has been a candidate for two frames, move one of the colliders away.
+    if (collisions->frame == 2)
+    {
+        for (auto [entity, position, collider] : query)
+        {
+            if (position->vec.x > 0.0F)
+            {
+                position->vec = glm::vec3{10.0F};
+            }
+        }
+    }
+}
+
+static void testLifetime(EventReader<CollisionEnded> ended, Read<BroadPhaseCollisions> collisions)
+{
+    std::size_t endedCount = 0;
+    for (const auto& event : ended)
+    {
+        CHECK(event.type == BroadPhaseCollisions::CollisionType::BoxBox);
+        CHECK(collisions->pair(event.entity, event.other) == nullptr);
+        endedCount += 1;
+    }
+
+    if (collisions->frame == 3)
+    {
+        // The colliders no longer overlap, so the pair ended.
+        CHECK(endedCount == 1);
+        CHECK(collisions->pairs.empty());
+        return;
+    }
+
+    CHECK(endedCount == 0);
+    REQUIRE(collisions->pairs.size() == 1);
+    const auto& pair = collisions->pairs.begin()->second;
+    CHECK(pair.firstFrame == 1);
+    CHECK(pair.lastFrame == collisions->frame);
+    if (collisions->frame == 2)
+    {
+        // The data attached in the first frame is kept while the pair stays.
+        REQUIRE(pair.userData.has_value());
+        CHECK(std::any_cast<int>(pair.userData) == 42);
+    }
+}
+
+static void testFiltered(Read<BroadPhaseCollisions> collisions)
+{
+    // Only the two colliders in the second layer may collide.
+    CHECK(collisions->pairs.size() == 1);
+    for (const auto& [candidate, pair] : collisions->pairs)
+    {
+        CHECK(pair.type == BroadPhaseCollisions::CollisionType::BoxBox);
+    }
+}
+
+static void testSleeping(Read<BroadPhaseCollisions> collisions)
+{
+    CHECK(collisions->motions.size() == 2);
+    for (const auto& [entity, motion] : collisions->motions)
+    {
+        CHECK(motion.isSleeping);
+        CHECK(collisions->isSleeping(entity));
+    }
+
+    for (const auto& markers : collisions->markersPerAxis)
+    {
+        CHECK(markers.empty());
+    }
+
+    for (const auto& markers : collisions->sleepingMarkersPerAxis)
+    {
+        CHECK(markers.size() == 4);
+    }
+
+    // The colliders fell asleep in the same frame, but were still tested against each other.
+    CHECK(collisions->pairs.size() == 1);
+}
+
+static void ignoreEverything(Query<Write<CollisionLayers>> query, Read<BroadPhaseCollisions> collisions)
+{
+    // After both colliders fell asleep, change the layers of one of them.
+    if (collisions->frame == 1)
+    {
+        for (auto [entity, layers] : query)
+        {
+            layers->mask = 0;
+            break;
+        }
+    }
+}
+
+static void testWokenByLayers(Query<Read<CollisionLayers>> query, Read<BroadPhaseCollisions> collisions)
+{
+    if (collisions->frame == 1)
+    {
+        CHECK(collisions->pairs.size() == 1);
+        return;
+    }
+
+    // The collider whose layers changed woke up, and no longer collides with the other.
+    for (auto [entity, layers] : query)
+    {
+        CHECK(collisions->isSleeping(entity) == (layers->mask != 0));
+    }
+    CHECK(collisions->pairs.empty());
+}
+
+static void offsetSleepingAABBs(Query<Write<ColliderAABB>> query, Read<BroadPhaseCollisions> collisions)
+{
+    // The colliders fell asleep in the first frame, so their AABBs are no longer computed.
+    if (collisions->frame == 1)
+    {
+        for (auto [entity, aabb] : query)
+        {
+            aabb->min.x -= 100.0F;
+        }
+    }
+}
+
+static void testSleepingAABBs(Query<Write<ColliderAABB>> query, Read<BroadPhaseCollisions> collisions)
+{
+    if (collisions->frame == 1)
+    {
+        for (auto [entity, aabb] : query)
+        {
+            CHECK(collisions->isSleeping(entity));
+            CHECK(aabb->min.x < -50.0F);
+
+            // Restore the AABB, so that the collider isn't woken up by the change.
+            aabb->min.x += 100.0F;
+        }
+    }
+}
+
+TEST_CASE("collisions.pairs")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.system(setup).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+
+    SUBCASE("collisions.broad.pairs: overlapping colliders start a pair")
+    {
+        cubos.system(testStarted).after("cubos.collisions.broad.pairs");
+    }
+
+    cubos.run();
+}
+
+TEST_CASE("collisions.pairs.lifetime")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.startupSystem(setupPair);
+    cubos.system(quitAfter<3>).after("cubos.collisions.broad.pairs");
+
+    SUBCASE("collisions.broad.pairs: pairs keep their data until their colliders stop overlapping")
+    {
+        cubos.system(moveApart).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+        cubos.system(attachUserData).after("cubos.collisions.broad.pairs");
+        cubos.system(testLifetime).after("cubos.collisions.broad.pairs");
+    }
+
+    cubos.run();
+}
+
+TEST_CASE("collisions.layers")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.system(setupLayers).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+
+    SUBCASE("collisions.broad.sweep: pairs are filtered by their layers")
+    {
+        cubos.system(testFiltered).after("cubos.collisions.broad.pairs");
+    }
+
+    cubos.run();
+}
+
+TEST_CASE("collisions.sleep")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.system(setupSleeping).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+
+    SUBCASE("collisions.broad.markers: unchanged colliders fall asleep")
+    {
+        cubos.system(testSleeping).after("cubos.collisions.broad.pairs");
+    }
+
+    cubos.run();
+}
+
+TEST_CASE("collisions.sleep.layers")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.startupSystem(setupSleeping);
+    cubos.system(quitAfter<2>).after("cubos.collisions.broad.pairs");
+
+    SUBCASE("collisions.broad.markers: changing the layers of a sleeping collider wakes it")
+    {
+        cubos.system(ignoreEverything).before("cubos.collisions.aabb.missing");
+        cubos.system(testWokenByLayers).after("cubos.collisions.broad.pairs");
+    }
+
+    SUBCASE("collisions.aabb: the AABBs of sleeping colliders which didn't move aren't recomputed")
+    {
+        cubos.system(offsetSleepingAABBs).after("cubos.transform.update").before("cubos.collisions.aabb");
+        cubos.system(testSleepingAABBs).after("cubos.collisions.aabb").before("cubos.collisions.broad.markers");
+    }
+
+    cubos.run();
+}
@@ -0,0 +1,133 @@
+#include <doctest/doctest.h>
+#include <glm/glm.hpp>
+
+#include <cubos/engine/collisions/colliders/box.hpp>
+#include <cubos/engine/collisions/colliders/capsule.hpp>
+#include <cubos/engine/collisions/colliders/plane.hpp>
+#include <cubos/engine/collisions/collision_queries.hpp>
+#include <cubos/engine/collisions/plugin.hpp>
+#include <cubos/engine/transform/plugin.hpp>
+
+using cubos::core::ThreadPool;
+using cubos::core::ecs::Commands;
+using cubos::core::ecs::Read;
+using cubos::core::ecs::Write;
+using cubos::core::geom::Box;
+using cubos::core::geom::Capsule;
+using cubos::core::geom::Plane;
+using namespace cubos::engine;
+
+static void setup(Commands commands)
+{
+    commands.create(LocalToWorld{}, Position{}, BoxCollider{glm::mat4{1.0F}, Box{glm::vec3{1.0F}}});
+    commands.create(LocalToWorld{}, Position{glm::vec3{10.0F, 0.0F, 0.0F}},
+                    CapsuleCollider{glm::mat4{1.0F}, Capsule{1.0F, 2.0F}});
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.0F, -5.0F, 0.0F}}, PlaneCollider{});
+
+    // Box without a margin, so that its AABB matches its faces.
+    commands.create(LocalToWorld{}, Position{glm::vec3{0.0F, 0.0F, 20.0F}},
+                    BoxCollider{glm::mat4{1.0F}, Box{glm::vec3{1.0F}}, 0.0F});
+}
+
+static void testRaycast(Read<CollisionQueries> queries)
+{
+    // Hits the box face at x = -1.
+    auto hit = queries->raycast({{-5.0F, 0.0F, 0.0F}, {1.0F, 0.0F, 0.0F}});
+    REQUIRE(hit.has_value());
+    CHECK(hit->distance == 4.0F);
+    CHECK(hit->normal == glm::vec3{-1.0F, 0.0F, 0.0F});
+
+    // Passes between the box and the capsule, and then hits the plane at y = -5.
+    hit = queries->raycast({{5.0F, 5.0F, 0.0F}, {0.0F, -1.0F, 0.0F}});
+    REQUIRE(hit.has_value());
+    CHECK(hit->distance == 10.0F);
+    CHECK(hit->normal == glm::vec3{0.0F, 1.0F, 0.0F});
+
+    // Hits the capsule's cylinder at x = 9.
+    hit = queries->raycast({{5.0F, 0.0F, 0.0F}, {1.0F, 0.0F, 0.0F}});
+    REQUIRE(hit.has_value());
+    CHECK(hit->distance == 4.0F);
+
+    // Stops before reaching anything.
+    CHECK_FALSE(queries->raycast({{5.0F, 0.0F, 0.0F}, {1.0F, 0.0F, 0.0F}, 3.0F}).has_value());
+}
+
+static void testRaycastBatch(Read<CollisionQueries> queries, Write<ThreadPool> pool)
+{
+    // Parallel to the X axis, with its origin on the plane of the top face of the box without a
+    // margin, which it slides along until it hits the face at x = -1.
+    std::vector<Ray> rays;
+    rays.push_back({{-5.0F, 1.0F, 20.0F}, {1.0F, 0.0F, 0.0F}});
+
+    // Enough rays for more than one block of packets, so that they're cast on the pool, and an
+    // uneven number of them, so that the last packet isn't full.
+    for (int i = 0; i < 600; ++i)
+    {
+        rays.push_back({{-5.0F, static_cast<float>(i) * 0.02F - 6.0F, 0.5F}, {1.0F, 0.0F, 0.0F}});
+    }
+
+    auto hits = queries->raycastBatch(*pool, rays);
+    REQUIRE(hits.size() == rays.size());
+    REQUIRE(hits[0].has_value());
+    CHECK(hits[0]->distance == 4.0F);
+
+    for (std::size_t i = 0; i < rays.size(); ++i)
+    {
+        auto hit = queries->raycast(rays[i]);
+        REQUIRE(hits[i].has_value() == hit.has_value());
+        if (hit)
+        {
+            CHECK(hits[i]->entity == hit->entity);
+            CHECK(hits[i]->distance == hit->distance);
+        }
+    }
+}
+
+static void testSweepSphere(Read<CollisionQueries> queries)
+{
+    auto hit = queries->sweepSphere({{-5.0F, 0.0F, 0.0F}, {1.0F, 0.0F, 0.0F}}, 0.5F);
+    REQUIRE(hit.has_value());
+    CHECK(hit->distance == 3.5F);
+
+    hit = queries->sweepSphere({{5.0F, 0.0F, 0.0F}, {0.0F, -1.0F, 0.0F}}, 1.0F);
+    REQUIRE(hit.has_value());
+    CHECK(hit->distance == 4.0F);
+}
+
+static void testOverlapBox(Read<CollisionQueries> queries)
+{
+    CHECK(queries->overlapBox({0.0F, 0.0F, 0.0F}, glm::vec3{0.5F}).size() == 1);
+    CHECK(queries->overlapBox({5.0F, 0.0F, 0.0F}, glm::vec3{0.5F}).empty());
+    CHECK(queries->overlapBox({5.0F, -5.0F, 0.0F}, glm::vec3{0.5F}).size() == 1);
+    CHECK(queries->overlapBox({5.0F, 0.0F, 0.0F}, glm::vec3{5.0F}).size() == 3);
+}
+
+TEST_CASE("collisions.queries")
+{
+    auto cubos = Cubos{};
+
+    cubos.addPlugin(collisionsPlugin);
+    cubos.system(setup).before("cubos.transform.update").before("cubos.collisions.aabb.missing");
+
+    SUBCASE("raycast")
+    {
+        cubos.system(testRaycast).after("cubos.collisions.queries");
+    }
+
+    SUBCASE("raycastBatch matches raycast")
+    {
+        cubos.system(testRaycastBatch).after("cubos.collisions.queries");
+    }
+
+    SUBCASE("sweepSphere")
+    {
+        cubos.system(testSweepSphere).after("cubos.collisions.queries");
+    }
+
+    SUBCASE("overlapBox")
+    {
+        cubos.system(testOverlapBox).after("cubos.collisions.queries");
+    }
+
+    cubos.run();
+}
@@ -0,0 +1,168 @@
+#include <doctest/doctest.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cubos/core/gl/null_render_device.hpp>
+
+#include <cubos/engine/renderer/deferred_renderer.hpp>
+#include <cubos/engine/renderer/frame.hpp>
+#include <cubos/engine/renderer/point_light.hpp>
+
+using cubos::core::gl::NullRenderDevice;
+using cubos::engine::BaseRenderer;
+using cubos::engine::Camera;
+using cubos::engine::DeferredRenderer;
+using cubos::engine::RendererFrame;
+using cubos::engine::Settings;
+using cubos::engine::triangulate;
+using cubos::engine::VoxelGrid;
+using cubos::engine::VoxelMesh;
+using cubos::engine::VoxelVertex;
+
+TEST_CASE("renderer.deferred_renderer")
+{
+    NullRenderDevice device{};
+    Settings settings{};
+    DeferredRenderer renderer{device, {64, 64}, settings};
+
+    VoxelGrid grid{{2, 2, 2}};
+    grid.set({0, 0, 0}, 1);
+    VoxelMesh mesh;
+    triangulate(grid, mesh.vertices, mesh.indices);
+    auto first = renderer.upload(mesh);
+    auto second = renderer.upload(mesh);
+
+    // Camera at the origin, looking down -Z.
+    Camera camera{60.0F, 0.1F, 100.0F};
+    BaseRenderer::Viewport viewport{{0, 0}, {64, 64}};
+    RendererFrame frame{};
+
+    SUBCASE("draws of the same grid are batched into instanced draws")
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            auto x = static_cast<float>(i % 5) * 3.0F - 6.0F;
+            auto y = static_cast<float>(i / 5) * 3.0F;
+            frame.draw(i % 2 == 0 ? first : second, glm::translate(glm::mat4(1.0F), {x, y, -20.0F}));
+        }
+
+        // One instanced draw per grid, plus the screen quad of the lighting pass.
+        device.resetStats();
+        renderer.render(glm::mat4(1.0F), viewport, camera, frame, false);
+        CHECK(device.stats().drawCalls == 3);
+        CHECK(device.stats().instances == 11);
+    }
+
+    SUBCASE("draws outside of the camera's view are culled")
+    {
+        frame.draw(first, glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, -20.0F}));
+        frame.draw(first, glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, 20.0F}));
+        frame.draw(second, glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, -200.0F}));
+
+        device.resetStats();
+        renderer.render(glm::mat4(1.0F), viewport, camera, frame, false);
+        CHECK(device.stats().drawCalls == 2);
+        CHECK(device.stats().instances == 2);
+    }
+
+    SUBCASE("meshes too large for packed vertices are uploaded unpacked")
+    {
+        // A single quad, wider than the largest coordinate a packed vertex can hold.
+        auto wide = cubos::engine::PackedVoxelVertex::MaxXY + 1;
+        VoxelMesh large;
+        large.vertices = {{{0, 0, 0}, {0.0F, 0.0F, 1.0F}, 1},
+                          {{wide, 0, 0}, {0.0F, 0.0F, 1.0F}, 1},
+                          {{wide, 1, 0}, {0.0F, 0.0F, 1.0F}, 1},
+                          {{0, 1, 0}, {0.0F, 0.0F, 1.0F}, 1}};
+        large.indices = {0, 1, 2, 2, 3, 0};
+
+        device.resetStats();
+        auto third = renderer.upload(large);
+        CHECK(device.stats().bytesUploaded == 4 * sizeof(VoxelVertex) + 6 * sizeof(uint16_t));
+
+        // Its batch is drawn with the unpacked pipeline, after the batches of packed grids.
+        frame.draw(third, glm::translate(glm::mat4(1.0F), {-8192.0F, 0.0F, -20.0F}));
+        frame.draw(first, glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, -20.0F}));
+        device.resetStats();
+        renderer.render(glm::mat4(1.0F), viewport, camera, frame, false);
+        CHECK(device.stats().drawCalls == 3);
+    }
+
+    SUBCASE("cameras drawn together share the work of the frame")
+    {
+        frame.draw(first, glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, -20.0F}));
+        frame.draw(second, glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, 20.0F}));
+        frame.light(glm::mat4(1.0F), cubos::engine::PointLight{});
+
+        // The second camera looks the other way, so each camera sees a different grid.
+        BaseRenderer::CameraView views[2]{
+            {glm::mat4(1.0F), {{0, 0}, {32, 64}}, camera},
+            {glm::rotate(glm::mat4(1.0F), glm::radians(180.0F), {0.0F, 1.0F, 0.0F}), {{32, 0}, {32, 64}}, camera},
+        };
+
+        device.resetStats();
+        renderer.render(views[0].view, views[0].viewport, views[0].camera, frame, false);
+        renderer.render(views[1].view, views[1].viewport, views[1].camera, frame, false);
+        auto separate = device.stats();
+
+        device.resetStats();
+        renderer.render(views, frame, false);
+        auto together = device.stats();
+
+        // The same draws are made, but the GBuffer is cleared, and the lights and per-frame data
+        // are uploaded, only once.
+        CHECK(together.drawCalls == 4);
+        CHECK(together.drawCalls == separate.drawCalls);
+        CHECK(together.clears * 2 == separate.clears);
+        CHECK(together.textureUpdates * 2 == separate.textureUpdates);
+        CHECK(together.maps * 2 == separate.maps);
+    }
+
+    SUBCASE("cameras are prepared in parallel on every frame")
+    {
+        frame.draw(first, glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, -20.0F}));
+
+        BaseRenderer::CameraView views[4]{
+            {glm::mat4(1.0F), {{0, 0}, {32, 32}}, camera},
+            {glm::mat4(1.0F), {{32, 0}, {32, 32}}, camera},
+            {glm::mat4(1.0F), {{0, 32}, {32, 32}}, camera},
+            {glm::mat4(1.0F), {{32, 32}, {32, 32}}, camera},
+        };
+
+        device.resetStats();
+        renderer.render(views, frame, false);
+        auto drawCalls = device.stats().drawCalls;
+        CHECK(drawCalls > 4);
+
+        // Each frame waits only for the work of its own cameras, so many frames in a row must all
+        // finish with the same draws.
+        for (int i = 0; i < 200; ++i)
+        {
+            device.resetStats();
+            renderer.render(views, frame, false);
+            REQUIRE(device.stats().drawCalls == drawCalls);
+        }
+    }
+}
+
+TEST_CASE("renderer.deferred_renderer.ssao")
+{
+    NullRenderDevice device{};
+    Settings settings{};
+    settings.setBool("renderer.ssao.enabled", true);
+    DeferredRenderer renderer{device, {64, 64}, settings};
+
+    Camera camera{60.0F, 0.1F, 100.0F};
+    BaseRenderer::Viewport viewport{{0, 0}, {64, 64}};
+    RendererFrame frame{};
+    renderer.render(glm::mat4(1.0F), viewport, camera, frame, false);
+
+    // The kernel was uploaded once, so frames only bind it, instead of setting each of its samples.
+    device.resetStats();
+    renderer.render(glm::mat4(1.0F), viewport, camera, frame, false);
+    CHECK(device.stats().resources == 0);
+    CHECK(device.stats().bytesUploaded == 0);
+    CHECK(device.stats().bindings < 64);
+
+    // The SSAO and upsample passes each draw a screen quad, besides the lighting pass.
+    CHECK(device.stats().drawCalls == 3);
+}
@@ -0,0 +1,67 @@
+#include <doctest/doctest.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cubos/engine/renderer/frame.hpp>
+
+using cubos::engine::RendererFrame;
+using cubos::engine::RendererGrid;
+
+/// @brief Grid which was never uploaded, used only for its bounding box.
+struct BoundsGrid : cubos::engine::impl::RendererGrid
+{
+    BoundsGrid(glm::vec3 boxMin, glm::vec3 boxMax)
+    {
+        min = boxMin;
+        max = boxMax;
+    }
+};
+
+TEST_CASE("renderer.frame.cull")
+{
+    RendererFrame frame{};
+    RendererGrid grid = std::make_shared<BoundsGrid>(glm::vec3{0.0F}, glm::vec3{2.0F});
+
+    // Camera at the origin, looking down -Z.
+    auto viewProj = glm::perspective(glm::radians(60.0F), 1.0F, 0.1F, 100.0F);
+    std::vector<uint8_t> visible;
+
+    SUBCASE("boxes in front of the camera are visible")
+    {
+        frame.draw(grid, glm::translate(glm::mat4(1.0F), {-1.0F, -1.0F, -10.0F}));
+        frame.cull(viewProj, visible);
+        REQUIRE(visible.size() == 1);
+        CHECK(visible[0] == 1);
+    }
+
+    SUBCASE("boxes behind, beside or beyond the camera are culled")
+    {
+        frame.draw(grid, glm::translate(glm::mat4(1.0F), {-1.0F, -1.0F, 10.0F}));
+        frame.draw(grid, glm::translate(glm::mat4(1.0F), {50.0F, -1.0F, -10.0F}));
+        frame.draw(grid, glm::translate(glm::mat4(1.0F), {-1.0F, -1.0F, -200.0F}));
+        frame.cull(viewProj, visible);
+        REQUIRE(visible.size() == 3);
+        CHECK(visible[0] == 0);
+        CHECK(visible[1] == 0);
+        CHECK(visible[2] == 0);
+    }
+
+    SUBCASE("boxes are transformed by their model matrix")
+    {
+        // The box is out of view, but scaling it makes it reach into the frustum.
+        auto model = glm::translate(glm::mat4(1.0F), {20.0F, 0.0F, -10.0F});
+        frame.draw(grid, model);
+        frame.draw(grid, glm::scale(model, glm::vec3{-10.0F, 1.0F, 1.0F}));
+        frame.cull(viewProj, visible);
+        REQUIRE(visible.size() == 2);
+        CHECK(visible[0] == 0);
+        CHECK(visible[1] == 1);
+    }
+
+    SUBCASE("clearing the frame removes the bounding boxes")
+    {
+        frame.draw(grid, glm::mat4(1.0F));
+        frame.clear();
+        frame.cull(viewProj, visible);
+        CHECK(visible.empty());
+    }
+}
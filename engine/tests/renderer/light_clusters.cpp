@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include <doctest/doctest.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cubos/engine/renderer/light_clusters.hpp>
+
+using cubos::engine::LightClusters;
+
+/// @brief Checks if a cluster has a given light.
+static bool hasLight(const LightClusters& clusters, std::size_t cluster, uint32_t light)
+{
+    auto range = clusters.ranges()[cluster];
+    auto begin = clusters.indices().begin() + range.x;
+    return std::find(begin, begin + range.y, light) != begin + range.y;
+}
+
+/// @brief Generates a pseudo-random number between 0 and 1.
+static float random(uint32_t& seed)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return static_cast<float>(seed >> 8) / static_cast<float>(1U << 24);
+}
+
+TEST_CASE("renderer.light_clusters")
+{
+    // Camera at (0, 0, 5), looking down -Z.
+    auto view = glm::translate(glm::mat4(1.0F), {0.0F, 0.0F, -5.0F});
+    auto projection = glm::perspective(glm::radians(60.0F), 16.0F / 9.0F, 0.1F, 100.0F);
+    LightClusters clusters{};
+
+    SUBCASE("lights are only in the clusters they reach")
+    {
+        std::vector<LightClusters::Light> lights{
+            {{0.0F, 0.0F, -5.0F}, 1.0F, {0.0F, 0.0F, -1.0F}, -1.0F},
+            {{0.0F, 0.0F, 10.0F}, 1.0F, {0.0F, 0.0F, -1.0F}, -1.0F},
+        };
+        clusters.build(view, projection, 0.1F, 100.0F, lights);
+
+        // The first light is in front of the camera, 10 units away, and the second behind it.
+        CHECK(hasLight(clusters, clusters.cluster({0.5F, 0.5F}, 10.0F), 0));
+        CHECK_FALSE(hasLight(clusters, clusters.cluster({0.5F, 0.5F}, 50.0F), 0));
+        CHECK_FALSE(hasLight(clusters, clusters.cluster({0.0F, 0.0F}, 10.0F), 0));
+        CHECK(std::count(clusters.indices().begin(), clusters.indices().end(), 1U) == 0);
+    }
+
+    SUBCASE("every lit point finds its lights in its cluster")
+    {
+        uint32_t seed = 7;
+        std::vector<LightClusters::Light> lights;
+        for (int i = 0; i < 200; ++i)
+        {
+            LightClusters::Light light{};
+            light.position = {random(seed) * 40.0F - 20.0F, random(seed) * 20.0F - 10.0F, -random(seed) * 40.0F};
+            light.range = 0.5F + random(seed) * 4.0F;
+            light.direction = glm::normalize(glm::vec3{random(seed), random(seed), random(seed)} - 0.5F);
+            light.spotCutoff = i % 2 == 0 ? -1.0F : 0.5F + random(seed) * 0.45F;
+            lights.push_back(light);
+        }
+        clusters.build(view, projection, 0.1F, 100.0F, lights);
+
+        bool allFound = true;
+        for (int i = 0; i < 20000; ++i)
+        {
+            glm::vec3 point{random(seed) * 40.0F - 20.0F, random(seed) * 20.0F - 10.0F, -random(seed) * 40.0F};
+            auto clip = projection * view * glm::vec4(point, 1.0F);
+            auto depth = clip.w;
+            auto uv = (glm::vec2(clip.x, clip.y) / clip.w + 1.0F) * 0.5F;
+            if (depth < 0.1F || uv.x < 0.0F || uv.x > 1.0F || uv.y < 0.0F || uv.y > 1.0F)
+            {
+                continue;
+            }
+
+            auto cluster = clusters.cluster(uv, depth);
+            for (uint32_t l = 0; l < lights.size(); ++l)
+            {
+                auto toPoint = point - lights[l].position;
+                if (glm::length(toPoint) >= lights[l].range ||
+                    glm::dot(glm::normalize(toPoint), lights[l].direction) <= lights[l].spotCutoff)
+                {
+                    continue;
+                }
+
+                allFound = allFound && hasLight(clusters, cluster, l);
+            }
+        }
+        CHECK(allFound);
+    }
+}
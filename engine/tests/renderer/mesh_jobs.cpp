@@ -0,0 +1,100 @@
+#include <doctest/doctest.h>
+
+#include <cubos/engine/renderer/mesh_jobs.hpp>
+
+using cubos::engine::MeshJob;
+using cubos::engine::MeshJobs;
+using cubos::engine::triangulate;
+using cubos::engine::VoxelGrid;
+using cubos::engine::VoxelMesh;
+using cubos::engine::VoxelPalette;
+
+TEST_CASE("renderer.mesh_jobs")
+{
+    MeshJobs jobs{2};
+
+    SUBCASE("jobs produce the same mesh as triangulate")
+    {
+        VoxelGrid grid{{4, 5, 6}};
+        grid.set({1, 2, 3}, 1);
+        grid.set({1, 3, 3}, 2);
+
+        VoxelMesh expected;
+        triangulate(grid, expected.vertices, expected.indices);
+
+        // The grid is copied on submission, so changing it afterwards doesn't affect the job.
+        MeshJob job = jobs.submit(grid);
+        grid.set({0, 0, 0}, 3);
+
+        job.wait();
+        CHECK(MeshJobs::isReady(job));
+        CHECK(job.get().vertices.size() == expected.vertices.size());
+        CHECK(job.get().indices == expected.indices);
+    }
+
+    SUBCASE("region jobs produce the same mesh as triangulating the region")
+    {
+        VoxelGrid grid{{10, 10, 10}};
+        grid.set({4, 4, 4}, 1);
+        grid.set({5, 4, 4}, 1);
+        grid.set({8, 8, 8}, 2);
+
+        VoxelMesh expected;
+        triangulate(grid, {5, 0, 0}, {5, 10, 10}, expected.vertices, expected.indices);
+
+        MeshJob job = jobs.submit(grid, {5, 0, 0}, {5, 10, 10});
+        job.wait();
+        REQUIRE(job.get().vertices.size() == expected.vertices.size());
+        CHECK(job.get().indices == expected.indices);
+
+        bool equal = true;
+        for (std::size_t i = 0; i < expected.vertices.size(); ++i)
+        {
+            equal = equal && job.get().vertices[i].position == expected.vertices[i].position;
+        }
+        CHECK(equal);
+
+        // Taking ownership of the grid produces the same mesh.
+        MeshJob moved = jobs.submit(VoxelGrid{grid.size(), grid.indices()}, {5, 0, 0}, {5, 10, 10});
+        moved.wait();
+        REQUIRE(moved.get().vertices.size() == expected.vertices.size());
+        CHECK(moved.get().indices == expected.indices);
+    }
+
+    SUBCASE("level of detail jobs keep the coordinates of the original grid")
+    {
+        // A 2x2x2 cube aligned to the blocks becomes a single voxel, whose mesh should match the
+        // mesh of the original cube.
+        VoxelGrid grid{{6, 6, 6}};
+        for (int z = 2; z < 4; ++z)
+        {
+            for (int y = 2; y < 4; ++y)
+            {
+                for (int x = 2; x < 4; ++x)
+                {
+                    grid.set({x, y, z}, 1);
+                }
+            }
+        }
+
+        VoxelMesh expected;
+        triangulate(grid, expected.vertices, expected.indices);
+
+        MeshJob job = jobs.submit(grid, VoxelPalette{}, 1, 1.0F);
+        job.wait();
+        REQUIRE(job.get().vertices.size() == expected.vertices.size());
+        CHECK(job.get().indices == expected.indices);
+
+        bool equal = true;
+        for (std::size_t i = 0; i < expected.vertices.size(); ++i)
+        {
+            equal = equal && job.get().vertices[i].position == expected.vertices[i].position;
+        }
+        CHECK(equal);
+    }
+
+    SUBCASE("invalid jobs are never ready")
+    {
+        CHECK_FALSE(MeshJobs::isReady(MeshJob{}));
+    }
+}
@@ -0,0 +1,198 @@
+#include <doctest/doctest.h>
+
+#include <cubos/core/gl/null_render_device.hpp>
+
+#include <cubos/engine/renderer/pps/manager.hpp>
+#include <cubos/engine/renderer/pps/pass.hpp>
+
+using cubos::core::gl::Framebuffer;
+using cubos::core::gl::NullRenderDevice;
+using cubos::core::gl::RenderDevice;
+using cubos::core::gl::Texture2D;
+using cubos::core::gl::Texture2DDesc;
+using cubos::core::gl::TextureFormat;
+using cubos::engine::PostProcessingInput;
+using cubos::engine::PostProcessingManager;
+using cubos::engine::PostProcessingPass;
+using cubos::engine::PostProcessingPassDesc;
+using cubos::engine::PostProcessingTarget;
+
+/// @brief Pass which counts its executions and needs a single full size transient target.
+/// @tparam ReadsPrevious Whether the pass reads the result of the previous pass.
+/// @tparam Inputs Renderer outputs read by the pass.
+template <bool ReadsPrevious, PostProcessingInput... Inputs>
+class CountingPass : public PostProcessingPass
+{
+public:
+    static inline int executions = 0;
+
+    CountingPass(RenderDevice& renderDevice, glm::uvec2 size)
+        : PostProcessingPass(renderDevice)
+        , mSize(size)
+    {
+    }
+
+    void resize(glm::uvec2 size) override
+    {
+        mSize = size;
+    }
+
+    PostProcessingPassDesc describe() const override
+    {
+        PostProcessingPassDesc desc;
+        desc.readsPrevious = ReadsPrevious;
+        desc.inputs = {Inputs...};
+        desc.transients.push_back({mSize});
+        return desc;
+    }
+
+    void execute(std::map<PostProcessingInput, Texture2D>& inputs, Texture2D prev, Framebuffer /*out*/,
+                 std::span<const PostProcessingTarget> transients) const override
+    {
+        CHECK(transients.size() == 1);
+        executions += 1;
+
+        // Transient targets must never alias a texture read by the pass.
+        for (const auto& transient : transients)
+        {
+            CHECK(transient.texture != prev);
+            for (const auto& [input, texture] : inputs)
+            {
+                CHECK(transient.texture != texture);
+            }
+        }
+    }
+
+private:
+    glm::uvec2 mSize;
+};
+
+/// @brief Pass which counts its executions and provides the normal input from the result of the previous pass.
+class ProvidingPass : public PostProcessingPass
+{
+public:
+    static inline int executions = 0;
+
+    ProvidingPass(RenderDevice& renderDevice, glm::uvec2 /*size*/)
+        : PostProcessingPass(renderDevice)
+    {
+    }
+
+    void resize(glm::uvec2 /*size*/) override
+    {
+    }
+
+    PostProcessingPassDesc describe() const override
+    {
+        PostProcessingPassDesc desc;
+        desc.outputs = {PostProcessingInput::Normal};
+        return desc;
+    }
+
+    void execute(std::map<PostProcessingInput, Texture2D>& inputs, Texture2D prev, Framebuffer /*out*/,
+                 std::span<const PostProcessingTarget> /*transients*/) const override
+    {
+        inputs[PostProcessingInput::Normal] = prev;
+        executions += 1;
+    }
+};
+
+using FilterPass = CountingPass<true>;
+using ReplacePass = CountingPass<false>;
+using NormalPass = CountingPass<true, PostProcessingInput::Normal>;
+using NormalReplacePass = CountingPass<false, PostProcessingInput::Normal>;
+
+TEST_CASE("renderer.pps")
+{
+    NullRenderDevice device{};
+    PostProcessingManager manager{device, {64, 64}};
+
+    Texture2DDesc desc;
+    desc.width = 64;
+    desc.height = 64;
+    desc.format = TextureFormat::RGBA32Float;
+    manager.provideInput(PostProcessingInput::Lighting, device.createTexture2D(desc));
+
+    FilterPass::executions = 0;
+    ReplacePass::executions = 0;
+    NormalPass::executions = 0;
+    NormalReplacePass::executions = 0;
+    ProvidingPass::executions = 0;
+
+    SUBCASE("transient targets are reused by later passes and frames")
+    {
+        manager.addPass<FilterPass>();
+        manager.addPass<FilterPass>();
+        manager.addPass<FilterPass>();
+        CHECK(manager.pooledTargetCount() == 0);
+
+        // Each pass needs a transient target and, except for the last, a target for its result,
+        // but at most three are lent at once.
+        manager.execute(nullptr);
+        CHECK(FilterPass::executions == 3);
+        CHECK(manager.pooledTargetCount() == 3);
+
+        device.resetStats();
+        manager.execute(nullptr);
+        CHECK(device.stats().resources == 0);
+
+        // Resizing drops the targets, which are only recreated when needed.
+        manager.resize({32, 32});
+        CHECK(manager.pooledTargetCount() == 0);
+        manager.execute(nullptr);
+        CHECK(manager.pooledTargetCount() == 3);
+    }
+
+    SUBCASE("passes whose results are never read are culled")
+    {
+        manager.addPass<FilterPass>();
+        manager.addPass<ReplacePass>();
+        manager.execute(nullptr);
+        CHECK(FilterPass::executions == 0);
+        CHECK(ReplacePass::executions == 1);
+        CHECK(manager.pooledTargetCount() == 1);
+    }
+
+    SUBCASE("passes which provide an input read by a later pass aren't culled")
+    {
+        manager.addPass<FilterPass>();
+        auto id = manager.addPass<ProvidingPass>();
+        manager.addPass<NormalReplacePass>();
+        manager.execute(nullptr);
+        CHECK(FilterPass::executions == 1);
+        CHECK(ProvidingPass::executions == 1);
+        CHECK(NormalReplacePass::executions == 1);
+
+        // The provided input only lasts for a single execution.
+        manager.removePass(id);
+        manager.execute(nullptr);
+        CHECK(NormalReplacePass::executions == 1);
+    }
+
+    SUBCASE("targets are freed when every pass is culled")
+    {
+        auto id = manager.addPass<FilterPass>();
+        manager.execute(nullptr);
+        CHECK(manager.pooledTargetCount() == 1);
+
+        manager.removePass(id);
+        manager.execute(nullptr);
+        CHECK(manager.pooledTargetCount() == 0);
+    }
+
+    SUBCASE("passes missing an input are culled")
+    {
+        manager.addPass<NormalPass>();
+
+        // The lighting input is still copied to the output.
+        device.resetStats();
+        manager.execute(nullptr);
+        CHECK(NormalPass::executions == 0);
+        CHECK(device.stats().drawCalls == 1);
+        CHECK(manager.pooledTargetCount() == 0);
+
+        manager.provideInput(PostProcessingInput::Normal, device.createTexture2D(desc));
+        manager.execute(nullptr);
+        CHECK(NormalPass::executions == 1);
+    }
+}
@@ -0,0 +1,391 @@
+#include <chrono>
+
+#include <doctest/doctest.h>
+
+#include <cubos/engine/renderer/vertex.hpp>
+#include <cubos/engine/voxels/grid.hpp>
+
+using cubos::engine::PackedVoxelVertex;
+using cubos::engine::triangulate;
+using cubos::engine::VoxelGrid;
+using cubos::engine::VoxelVertex;
+
+/// @brief Scalar greedy mesher which @ref triangulate must match exactly.
+static void referenceTriangulate(const VoxelGrid& grid, std::vector<VoxelVertex>& vertices,
+                                 std::vector<uint32_t>& indices)
+{
+    std::vector<uint16_t> mask;
+
+    const auto& sz = grid.size();
+
+    // For both back and front faces.
+    bool backFace = true;
+    do
+    {
+        backFace = !backFace;
+
+        // For each axis.
+        for (int d = 0; d < 3; ++d)
+        {
+            int u = (d + 1) % 3;
+            int v = (d + 2) % 3;
+
+            glm::ivec3 x = {0, 0, 0};
+            glm::ivec3 q = {0, 0, 0};
+            q[d] = 1;
+            mask.resize(static_cast<std::size_t>(sz[u]) * static_cast<std::size_t>(sz[v]));
+
+            for (x[d] = -1; x[d] < int(sz[d]);)
+            {
+                std::size_t n = 0;
+
+                // Create mask
+                for (x[v] = 0; x[v] < int(sz[v]); ++x[v])
+                {
+                    for (x[u] = 0; x[u] < int(sz[u]); ++x[u])
+                    {
+                        if (x[d] < 0)
+                        {
+                            mask[n++] = backFace ? grid.get(x + q) : 0;
+                        }
+                        else if (x[d] == int(sz[d]) - 1)
+                        {
+                            mask[n++] = backFace ? 0 : grid.get(x);
+                        }
+                        else if (grid.get(x) == 0 || grid.get(x + q) == 0)
+                        {
+                            mask[n++] = backFace ? grid.get(x + q) : grid.get(x);
+                        }
+                        else
+                        {
+                            mask[n++] = 0;
+                        }
+                    }
+                }
+
+                ++x[d];
+                n = 0;
+
+                // Generate mesh from mask
+                for (std::size_t j = 0; j < sz[v]; ++j)
+                {
+                    for (std::size_t i = 0; i < sz[u];)
+                    {
+                        if (mask[n] != 0)
+                        {
+                            std::size_t w;
+                            std::size_t h;
+                            for (w = 1; i + w < sz[u] && mask[n + w] == mask[n]; ++w)
+                            {
+                                ;
+                            }
+                            bool done = false;
+                            for (h = 1; j + h < sz[v]; ++h)
+                            {
+                                for (std::size_t k = 0; k < w; ++k)
+                                {
+                                    if (mask[n + k + h * sz[u]] == 0 || mask[n + k + h * sz[u]] != mask[n])
+                                    {
+                                        done = true;
+                                        break;
+                                    }
+                                }
+
+                                if (done)
+                                {
+                                    break;
+                                }
+                            }
+
+                            if (mask[n] != 0)
+                            {
+                                x[u] = static_cast<int>(i);
+                                x[v] = static_cast<int>(j);
+
+                                glm::ivec3 du = {0, 0, 0};
+                                glm::ivec3 dv = {0, 0, 0};
+                                du[u] = static_cast<int>(w);
+                                dv[v] = static_cast<int>(h);
+
+                                auto vi = vertices.size();
+                                vertices.resize(vi + 4, {{}, backFace ? -q : q, mask[n]});
+                                vertices[vi + 0].position = x;
+                                vertices[vi + 1].position = x + du;
+                                vertices[vi + 2].position = x + du + dv;
+                                vertices[vi + 3].position = x + dv;
+
+                                auto ii = indices.size();
+                                indices.resize(ii + 6);
+                                if (backFace)
+                                {
+                                    indices[ii + 0] = static_cast<uint32_t>(vi) + 0;
+                                    indices[ii + 1] = static_cast<uint32_t>(vi) + 2;
+                                    indices[ii + 2] = static_cast<uint32_t>(vi) + 1;
+                                    indices[ii + 3] = static_cast<uint32_t>(vi) + 3;
+                                    indices[ii + 4] = static_cast<uint32_t>(vi) + 2;
+                                    indices[ii + 5] = static_cast<uint32_t>(vi) + 0;
+                                }
+                                else
+                                {
+                                    indices[ii + 0] = static_cast<uint32_t>(vi) + 0;
+                                    indices[ii + 1] = static_cast<uint32_t>(vi) + 1;
+                                    indices[ii + 2] = static_cast<uint32_t>(vi) + 2;
+                                    indices[ii + 3] = static_cast<uint32_t>(vi) + 2;
+                                    indices[ii + 4] = static_cast<uint32_t>(vi) + 3;
+                                    indices[ii + 5] = static_cast<uint32_t>(vi) + 0;
+                                }
+                            }
+
+                            for (std::size_t l = 0; l < h; ++l)
+                            {
+                                for (std::size_t k = 0; k < w; ++k)
+                                {
+                                    mask[n + k + l * sz[u]] = 0;
+                                }
+                            }
+
+                            i += w;
+                            n += w;
+                        }
+                        else
+                        {
+                            ++i;
+                            ++n;
+                        }
+                    }
+                }
+            }
+        }
+    } while (!backFace);
+}
+
+/// @brief Checks that @ref triangulate produces the same mesh as the reference mesher.
+/// @param grid Grid to triangulate.
+static void checkMatchesReference(const VoxelGrid& grid)
+{
+    std::vector<VoxelVertex> expectedVertices;
+    std::vector<uint32_t> expectedIndices;
+    referenceTriangulate(grid, expectedVertices, expectedIndices);
+
+    std::vector<VoxelVertex> vertices;
+    std::vector<uint32_t> indices;
+    triangulate(grid, vertices, indices);
+
+    REQUIRE(vertices.size() == expectedVertices.size());
+    CHECK(indices == expectedIndices);
+
+    bool equal = true;
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        equal = equal && vertices[i].position == expectedVertices[i].position &&
+                vertices[i].normal == expectedVertices[i].normal &&
+                vertices[i].material == expectedVertices[i].material;
+    }
+    CHECK(equal);
+}
+
+TEST_CASE("renderer.triangulate")
+{
+    SUBCASE("a single voxel becomes a cube")
+    {
+        VoxelGrid grid{{1, 1, 1}};
+        grid.set({0, 0, 0}, 3);
+
+        std::vector<VoxelVertex> vertices;
+        std::vector<uint32_t> indices;
+        triangulate(grid, vertices, indices);
+        CHECK(vertices.size() == 6 * 4);
+        CHECK(indices.size() == 6 * 6);
+        checkMatchesReference(grid);
+    }
+
+    SUBCASE("faces are merged across word boundaries")
+    {
+        // Wider than a 64-bit word in every dimension, with a single material.
+        VoxelGrid grid{{70, 66, 65}};
+        for (int z = 1; z < 64; ++z)
+        {
+            for (int y = 0; y < 66; ++y)
+            {
+                for (int x = 2; x < 70; ++x)
+                {
+                    grid.set({x, y, z}, 1);
+                }
+            }
+        }
+
+        std::vector<VoxelVertex> vertices;
+        std::vector<uint32_t> indices;
+        triangulate(grid, vertices, indices);
+        CHECK(vertices.size() == 6 * 4);
+        checkMatchesReference(grid);
+    }
+
+    SUBCASE("mixed materials and holes match the reference mesher")
+    {
+        VoxelGrid grid{{67, 13, 9}};
+        for (int z = 0; z < 9; ++z)
+        {
+            for (int y = 0; y < 13; ++y)
+            {
+                for (int x = 0; x < 67; ++x)
+                {
+                    auto hash = static_cast<unsigned int>(x) * 73856093U ^ static_cast<unsigned int>(y) * 19349663U ^
+                                static_cast<unsigned int>(z) * 83492791U;
+                    auto mat = hash % 3 == 0 ? 0 : 1 + static_cast<int>((x / 8 + y / 4 + z / 3) % 3);
+                    grid.set({x, y, z}, static_cast<uint16_t>(mat));
+                }
+            }
+        }
+
+        checkMatchesReference(grid);
+    }
+}
+
+/// @brief Measures the time taken to triangulate a grid, in milliseconds.
+/// @tparam F Type of the mesher.
+/// @param grid Grid to triangulate.
+/// @param mesher Mesher with the same signature as @ref triangulate.
+/// @param[out] vertices Generated vertices.
+/// @param[out] indices Generated indices.
+/// @return Elapsed time.
+template <typename F>
+static double timeTriangulate(const VoxelGrid& grid, F mesher, std::vector<VoxelVertex>& vertices,
+                              std::vector<uint32_t>& indices)
+{
+    auto start = std::chrono::steady_clock::now();
+    mesher(grid, vertices, indices);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Skipped by default, as the reference mesher takes seconds on this grid. Run it with
+// `--test-case=renderer.triangulate.benchmark --no-skip` on an optimized build.
+TEST_CASE("renderer.triangulate.benchmark" * doctest::skip())
+{
+    // A sphere filling a 256^3 grid, with a different material on each quarter.
+    constexpr int Size = 256;
+    VoxelGrid grid{{Size, Size, Size}};
+    auto center = glm::vec3{Size / 2.0F};
+    for (int z = 0; z < Size; ++z)
+    {
+        for (int y = 0; y < Size; ++y)
+        {
+            for (int x = 0; x < Size; ++x)
+            {
+                auto position = glm::vec3(glm::ivec3{x, y, z}) + 0.5F;
+                if (glm::distance(position, center) <= Size / 2.0F)
+                {
+                    auto mat = 1 + (x < Size / 2 ? 0 : 1) + (y < Size / 2 ? 0 : 2);
+                    grid.set({x, y, z}, static_cast<uint16_t>(mat));
+                }
+            }
+        }
+    }
+
+    std::vector<VoxelVertex> expectedVertices;
+    std::vector<uint32_t> expectedIndices;
+    auto reference = timeTriangulate(grid, referenceTriangulate, expectedVertices, expectedIndices);
+
+    std::vector<VoxelVertex> vertices;
+    std::vector<uint32_t> indices;
+    auto bitmask = timeTriangulate(
+        grid,
+        [](const VoxelGrid& grid, std::vector<VoxelVertex>& vertices, std::vector<uint32_t>& indices) {
+            triangulate(grid, vertices, indices);
+        },
+        vertices, indices);
+
+    MESSAGE("reference mesher: " << reference << " ms, triangulate: " << bitmask << " ms");
+    CHECK(vertices.size() == expectedVertices.size());
+    CHECK(indices == expectedIndices);
+}
+
+/// @brief Sums the area of the quads of a mesh facing each direction.
+/// @param vertices Vertices of the mesh.
+/// @param[out] areas Area for each normal index, as in @ref PackedVoxelVertex.
+static void sumAreas(const std::vector<VoxelVertex>& vertices, unsigned int areas[6])
+{
+    for (std::size_t i = 0; i < vertices.size(); i += 4)
+    {
+        auto du = glm::ivec3{vertices[i + 1].position} - glm::ivec3{vertices[i].position};
+        auto dv = glm::ivec3{vertices[i + 3].position} - glm::ivec3{vertices[i].position};
+        auto normal = (PackedVoxelVertex::pack(vertices[i]).xyNormal >> 28) & 7;
+        areas[normal] += static_cast<unsigned int>((du.x + du.y + du.z) * (dv.x + dv.y + dv.z));
+    }
+}
+
+TEST_CASE("renderer.triangulate.region")
+{
+    // A sphere crossing region borders.
+    VoxelGrid grid{{40, 37, 35}};
+    for (int z = 0; z < 35; ++z)
+    {
+        for (int y = 0; y < 37; ++y)
+        {
+            for (int x = 0; x < 40; ++x)
+            {
+                auto d = glm::ivec3{x, y, z} - glm::ivec3{20, 18, 17};
+                grid.set({x, y, z}, static_cast<uint16_t>(d.x * d.x + d.y * d.y + d.z * d.z < 15 * 15 ? 1 + x % 2 : 0));
+            }
+        }
+    }
+
+    std::vector<VoxelVertex> vertices;
+    std::vector<uint32_t> indices;
+    triangulate(grid, vertices, indices);
+    unsigned int expected[6] = {};
+    sumAreas(vertices, expected);
+
+    // Triangulating each region separately must result in the same visible faces.
+    unsigned int areas[6] = {};
+    for (unsigned int z = 0; z < 35; z += 16)
+    {
+        for (unsigned int y = 0; y < 37; y += 16)
+        {
+            for (unsigned int x = 0; x < 40; x += 16)
+            {
+                glm::uvec3 origin{x, y, z};
+                auto size = glm::min(origin + 16U, grid.size()) - origin;
+
+                vertices.clear();
+                indices.clear();
+                triangulate(grid, origin, size, vertices, indices);
+                sumAreas(vertices, areas);
+            }
+        }
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        CHECK(areas[i] == expected[i]);
+    }
+}
+
+TEST_CASE("renderer.PackedVoxelVertex")
+{
+    VoxelGrid grid{{3, 2, 2}};
+    grid.set({0, 0, 0}, 1);
+    grid.set({2, 1, 1}, 65535);
+
+    std::vector<VoxelVertex> vertices;
+    std::vector<uint32_t> indices;
+    triangulate(grid, vertices, indices);
+
+    CHECK(sizeof(PackedVoxelVertex) == 8);
+
+    bool equal = true;
+    for (const auto& vertex : vertices)
+    {
+        auto unpacked = PackedVoxelVertex::pack(vertex).unpack();
+        equal = equal && unpacked.position == vertex.position && unpacked.normal == vertex.normal &&
+                unpacked.material == vertex.material;
+    }
+    CHECK(equal);
+
+    VoxelVertex large{{PackedVoxelVertex::MaxXY, PackedVoxelVertex::MaxXY, PackedVoxelVertex::MaxZ}, {0, 0, -1}, 7};
+    auto unpacked = PackedVoxelVertex::pack(large).unpack();
+    CHECK(unpacked.position == large.position);
+    CHECK(unpacked.normal == large.normal);
+    CHECK(unpacked.material == large.material);
+}
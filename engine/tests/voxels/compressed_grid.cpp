@@ -0,0 +1,79 @@
+#include <doctest/doctest.h>
+
+#include <cubos/engine/voxels/compressed_grid.hpp>
+
+using cubos::engine::CompressedVoxelGrid;
+using cubos::engine::VoxelGrid;
+
+TEST_CASE("voxels.compressed_grid")
+{
+    SUBCASE("empty grids only store a palette per brick")
+    {
+        CompressedVoxelGrid grid{glm::uvec3{64}};
+        CHECK(grid.get({63, 0, 17}) == 0);
+        CHECK(grid.memoryUsage() == 8 * 8 * 8 * sizeof(uint16_t));
+    }
+
+    SUBCASE("dense grids survive a round trip")
+    {
+        // Use a size which isn't a multiple of the brick size, to exercise the padding.
+        VoxelGrid dense{{19, 9, 17}};
+        for (int z = 0; z < 17; ++z)
+        {
+            for (int y = 0; y < 9; ++y)
+            {
+                for (int x = 0; x < 19; ++x)
+                {
+                    dense.set({x, y, z}, static_cast<uint16_t>(x < 10 ? 0 : (x * 7 + y * 3 + z) % 40));
+                }
+            }
+        }
+
+        CompressedVoxelGrid grid{dense};
+        CHECK(grid.size() == dense.size());
+
+        auto copy = grid.decompress();
+        bool equal = true;
+        for (int z = 0; z < 17; ++z)
+        {
+            for (int y = 0; y < 9; ++y)
+            {
+                for (int x = 0; x < 19; ++x)
+                {
+                    equal = equal && copy.get({x, y, z}) == dense.get({x, y, z}) &&
+                            grid.get({x, y, z}) == dense.get({x, y, z});
+                }
+            }
+        }
+        CHECK(equal);
+    }
+
+    SUBCASE("indices grow as materials are added and shrink when compacted")
+    {
+        CompressedVoxelGrid grid{glm::uvec3{8}};
+        auto empty = grid.memoryUsage();
+
+        grid.set({1, 2, 3}, 5);
+        CHECK(grid.get({1, 2, 3}) == 5);
+        CHECK(grid.get({0, 0, 0}) == 0);
+        auto oneBit = grid.memoryUsage();
+        CHECK(oneBit > empty);
+
+        for (uint16_t i = 0; i < 300; ++i)
+        {
+            grid.set({i % 8, (i / 8) % 8, i / 64}, static_cast<uint16_t>(i + 1));
+        }
+        CHECK(grid.get({3, 5, 4}) == 300);
+        CHECK(grid.get({7, 7, 7}) == 0);
+        CHECK(grid.memoryUsage() > oneBit);
+
+        grid.clear();
+        grid.set({1, 2, 3}, 5);
+        CHECK(grid.memoryUsage() == oneBit);
+
+        grid.set({1, 2, 3}, 0);
+        grid.compact();
+        CHECK(grid.get({1, 2, 3}) == 0);
+        CHECK(grid.memoryUsage() == empty);
+    }
+}
@@ -0,0 +1,147 @@
+#include <doctest/doctest.h>
+
+#include <cubos/engine/voxels/grid.hpp>
+#include <cubos/engine/voxels/palette.hpp>
+
+using cubos::engine::VoxelGrid;
+using cubos::engine::VoxelMaterial;
+using cubos::engine::VoxelPalette;
+
+TEST_CASE("voxels.grid")
+{
+    VoxelGrid grid{{70, 40, 10}};
+    CHECK(grid.regionCount() == glm::uvec3{3, 2, 1});
+
+    // Remember the initial versions of every region.
+    uint64_t versions[3][2];
+    for (unsigned int x = 0; x < 3; ++x)
+    {
+        for (unsigned int y = 0; y < 2; ++y)
+        {
+            versions[x][y] = grid.regionVersion({x, y, 0});
+        }
+    }
+
+    auto changed = [&](unsigned int x, unsigned int y) { return grid.regionVersion({x, y, 0}) != versions[x][y]; };
+
+    SUBCASE("setting a voxel to its current value changes nothing")
+    {
+        grid.set({5, 5, 5}, 0);
+        CHECK_FALSE(changed(0, 0));
+    }
+
+    SUBCASE("setting an inner voxel only changes its region")
+    {
+        grid.set({40, 5, 5}, 1);
+        CHECK(changed(1, 0));
+        CHECK_FALSE(changed(0, 0));
+        CHECK_FALSE(changed(2, 0));
+        CHECK_FALSE(changed(1, 1));
+    }
+
+    SUBCASE("setting a border voxel also changes the neighboring regions")
+    {
+        grid.set({31, 32, 5}, 1);
+        CHECK(changed(0, 1));
+        CHECK(changed(1, 1));
+        CHECK(changed(0, 0));
+        CHECK_FALSE(changed(1, 0));
+        CHECK_FALSE(changed(2, 1));
+    }
+
+    SUBCASE("copies share versions, but new grids don't")
+    {
+        VoxelGrid copy;
+        copy = grid;
+        CHECK(copy.regionVersion({2, 1, 0}) == grid.regionVersion({2, 1, 0}));
+
+        VoxelGrid other{{70, 40, 10}};
+        CHECK(other.regionVersion({2, 1, 0}) != grid.regionVersion({2, 1, 0}));
+    }
+}
+
+TEST_CASE("voxels.grid.downsample")
+{
+    // Materials 1 and 2 are almost the same red, while 3 is blue.
+    VoxelPalette palette{{
+        {{1.0F, 0.0F, 0.0F, 1.0F}},
+        {{0.9F, 0.0F, 0.0F, 1.0F}},
+        {{0.0F, 0.0F, 1.0F, 1.0F}},
+    }};
+
+    VoxelGrid grid{{6, 2, 3}};
+
+    // 3 blue voxels outvote 2 + 2 red voxels, unless the reds are similar enough to vote together.
+    grid.set({0, 0, 0}, 1);
+    grid.set({1, 0, 0}, 3);
+    grid.set({0, 1, 0}, 3);
+    grid.set({1, 1, 0}, 3);
+    grid.set({0, 0, 1}, 1);
+    grid.set({1, 0, 1}, 2);
+    grid.set({0, 1, 1}, 2);
+
+    // Half of the voxels are set, so the block isn't empty.
+    grid.set({2, 0, 0}, 1);
+    grid.set({3, 0, 0}, 1);
+    grid.set({2, 1, 1}, 1);
+    grid.set({3, 1, 1}, 1);
+
+    // Less than half of the voxels are set, so the block is empty.
+    grid.set({4, 0, 0}, 1);
+    grid.set({5, 0, 0}, 1);
+    grid.set({4, 1, 0}, 1);
+
+    // Only 4 voxels of the block are inside the grid, and just one of them is empty.
+    grid.set({2, 0, 2}, 2);
+    grid.set({3, 0, 2}, 1);
+    grid.set({3, 1, 2}, 2);
+
+    auto exact = grid.downsample(palette, 1.0F);
+    REQUIRE(exact.size() == glm::uvec3{3, 1, 2});
+    CHECK(exact.get({0, 0, 0}) == 3);
+    CHECK(exact.get({1, 0, 0}) == 1);
+    CHECK(exact.get({2, 0, 0}) == 0);
+    CHECK(exact.get({0, 0, 1}) == 0);
+    CHECK(exact.get({1, 0, 1}) == 2);
+    CHECK(exact.get({2, 0, 1}) == 0);
+
+    // The reds now win. When similar materials tie, the most used one is picked.
+    auto similar = grid.downsample(palette, 0.9F);
+    CHECK(similar.get({0, 0, 0}) == 1);
+    CHECK(similar.get({1, 0, 1}) == 2);
+}
+
+TEST_CASE("voxels.grid.convert")
+{
+    VoxelPalette src{{
+        {{1.0F, 0.0F, 0.0F, 1.0F}},
+        {{0.0F, 0.0F, 1.0F, 1.0F}},
+    }};
+    VoxelPalette dst{{
+        {{0.0F, 0.0F, 1.0F, 1.0F}},
+        {{0.9F, 0.0F, 0.0F, 1.0F}},
+    }};
+
+    VoxelGrid grid{{3, 1, 1}};
+    grid.set({1, 0, 0}, 1);
+    grid.set({2, 0, 0}, 2);
+
+    SUBCASE("materials are mapped to the most similar ones")
+    {
+        REQUIRE(grid.convert(src, dst, 0.9F));
+        CHECK(grid.get({0, 0, 0}) == 0);
+        CHECK(grid.get({1, 0, 0}) == 2);
+        CHECK(grid.get({2, 0, 0}) == 1);
+    }
+
+    SUBCASE("conversions fail if a material has no match")
+    {
+        CHECK_FALSE(grid.convert(src, dst, 1.0F));
+        CHECK(grid.get({1, 0, 0}) == 1);
+
+        // Materials outside of the palette never match.
+        grid.set({0, 0, 0}, 3);
+        CHECK_FALSE(grid.convert(src, dst, 0.9F));
+        CHECK(grid.get({2, 0, 0}) == 2);
+    }
+}
@@ -0,0 +1,80 @@
+#include <doctest/doctest.h>
+
+#include <cubos/engine/voxels/palette.hpp>
+
+using cubos::engine::VoxelMaterial;
+using cubos::engine::VoxelPalette;
+
+/// @brief Finds the index of the material most similar with the given material, by comparing it
+/// with every material in the palette.
+static uint16_t referenceFind(const VoxelPalette& palette, const VoxelMaterial& material)
+{
+    uint16_t bestI = 0;
+    float bestS = material.similarity(VoxelMaterial::Empty);
+    for (uint16_t i = 1; i <= palette.size(); ++i)
+    {
+        float s = material.similarity(palette.get(i));
+        if (s > bestS)
+        {
+            bestS = s;
+            bestI = i;
+        }
+    }
+    return bestI;
+}
+
+/// @brief Generates a material with a pseudo-random color, with few distinct values per channel so
+/// that ties between materials are common.
+static VoxelMaterial randomMaterial(uint32_t& seed)
+{
+    auto channel = [&]() {
+        seed = seed * 1664525U + 1013904223U;
+        return static_cast<float>((seed >> 16) % 9) / 8.0F;
+    };
+
+    VoxelMaterial material{};
+    material.color.r = channel();
+    material.color.g = channel();
+    material.color.b = channel();
+    material.color.a = 1.0F;
+    return material;
+}
+
+TEST_CASE("voxels.palette")
+{
+    uint32_t seed = 42;
+    VoxelPalette palette{};
+
+    // Add enough materials for the search tree to be rebuilt a few times.
+    for (int i = 0; i < 600; ++i)
+    {
+        palette.add(randomMaterial(seed), 0.95F);
+    }
+
+    SUBCASE("find matches a linear search")
+    {
+        bool equal = true;
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto material = randomMaterial(seed);
+            material.color.a = static_cast<float>(i % 3) / 2.0F;
+            equal = equal && palette.find(material) == referenceFind(palette, material);
+        }
+        CHECK(equal);
+    }
+
+    SUBCASE("changed materials are found")
+    {
+        VoxelMaterial material{{0.3F, 0.2F, 0.1F, 1.0F}};
+        palette.set(5, material);
+        CHECK(palette.find(material) == 5);
+
+        // Emptied materials are reused before new ones are added.
+        auto size = palette.size();
+        palette.set(3, VoxelMaterial::Empty);
+        palette.set(7, VoxelMaterial::Empty);
+        CHECK(palette.add(VoxelMaterial{{0.7F, 0.6F, 0.5F, 0.5F}}) == 3);
+        CHECK(palette.add(VoxelMaterial{{0.5F, 0.6F, 0.7F, 0.5F}}) == 7);
+        CHECK(palette.size() == size);
+    }
+}
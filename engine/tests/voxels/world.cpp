@@ -0,0 +1,173 @@
+#include <doctest/doctest.h>
+
+#include <cubos/engine/voxels/palette.hpp>
+#include <cubos/engine/voxels/world.hpp>
+
+using cubos::engine::VoxelGrid;
+using cubos::engine::VoxelPalette;
+using cubos::engine::VoxelWorld;
+
+TEST_CASE("voxels.world")
+{
+    VoxelWorld world{};
+
+    SUBCASE("empty chunks aren't stored")
+    {
+        CHECK(world.get({0, 0, 0}) == 0);
+        world.set({5, -40, 1000}, 0);
+        CHECK(world.chunkCount() == 0);
+        CHECK(world.dirtyChunks().empty());
+    }
+
+    SUBCASE("get returns what was set, including negative coordinates")
+    {
+        world.set({0, 0, 0}, 1);
+        world.set({-1, -1, -1}, 2);
+        world.set({31, 32, -32}, 3);
+        world.set({-33, 0, 0}, 4);
+
+        CHECK(world.get({0, 0, 0}) == 1);
+        CHECK(world.get({-1, -1, -1}) == 2);
+        CHECK(world.get({31, 32, -32}) == 3);
+        CHECK(world.get({-33, 0, 0}) == 4);
+        CHECK(world.get({1, 0, 0}) == 0);
+
+        CHECK(VoxelWorld::chunkOf({-1, -1, -1}) == glm::ivec3{-1, -1, -1});
+        CHECK(VoxelWorld::chunkOf({31, 32, -32}) == glm::ivec3{0, 1, -1});
+        CHECK(VoxelWorld::chunkOf({-33, 0, 0}) == glm::ivec3{-2, 0, 0});
+        CHECK(world.chunkCount() == 4);
+        CHECK(world.dirtyChunks().size() == 4);
+    }
+
+    SUBCASE("uniform and empty chunks are elided when compacted")
+    {
+        auto size = VoxelWorld::ChunkSize;
+        for (int z = 0; z < size; ++z)
+        {
+            for (int y = 0; y < size; ++y)
+            {
+                for (int x = 0; x < size; ++x)
+                {
+                    world.set({x, y, z}, 7);
+                    world.set({x + size, y, z}, 1);
+                }
+            }
+        }
+        world.set({size, 0, 0}, 0);
+        world.set({size, 0, 0}, 0);
+
+        CHECK(world.denseChunkCount() == 2);
+        world.compact();
+        CHECK(world.chunkCount() == 2);
+        CHECK(world.denseChunkCount() == 1);
+        CHECK(world.uniform({0, 0, 0}) == uint16_t{7});
+        CHECK_FALSE(world.uniform({1, 0, 0}).has_value());
+        CHECK(world.get({3, 4, 5}) == 7);
+
+        // Clearing the only non-empty voxel of the second chunk removes it.
+        world.clearDirty();
+        for (int z = 0; z < size; ++z)
+        {
+            for (int y = 0; y < size; ++y)
+            {
+                for (int x = 0; x < size; ++x)
+                {
+                    world.set({x + size, y, z}, 0);
+                }
+            }
+        }
+        world.compact();
+        CHECK(world.chunkCount() == 1);
+        CHECK(world.dirtyChunks().size() == 1);
+        CHECK(world.uniform({1, 0, 0}) == uint16_t{0});
+    }
+
+    SUBCASE("chunks and pasted grids match the voxels")
+    {
+        VoxelGrid grid{{2, 3, 4}};
+        grid.set({1, 2, 3}, 9);
+        world.paste(grid, {30, 30, 30});
+        CHECK(world.get({31, 32, 33}) == 9);
+        CHECK(world.chunkCount() == 1);
+
+        auto chunk = world.chunk({1, 1, 1});
+        CHECK(chunk.size() == glm::uvec3{VoxelWorld::ChunkSize});
+        CHECK(chunk.get({0, 0, 1}) == 9);
+    }
+
+    SUBCASE("pasting and converting compact the chunks they modify")
+    {
+        auto size = static_cast<unsigned int>(VoxelWorld::ChunkSize);
+        VoxelGrid grid{{size, size, size}};
+        for (int z = 0; z < VoxelWorld::ChunkSize; ++z)
+        {
+            for (int y = 0; y < VoxelWorld::ChunkSize; ++y)
+            {
+                for (int x = 0; x < VoxelWorld::ChunkSize; ++x)
+                {
+                    grid.set({x, y, z}, (x + y + z) % 2 == 0 ? 1 : 2);
+                }
+            }
+        }
+
+        // Both materials are mapped to the same one, so the chunk becomes uniform.
+        world.paste(grid, {0, 0, 0});
+        CHECK(world.denseChunkCount() == 1);
+        VoxelPalette src{{
+            {{1.0F, 0.0F, 0.0F, 1.0F}},
+            {{0.95F, 0.0F, 0.0F, 1.0F}},
+        }};
+        VoxelPalette dst{{
+            {{1.0F, 0.0F, 0.0F, 1.0F}},
+        }};
+        world.clearDirty();
+        REQUIRE(world.convert(src, dst, 0.9F));
+        CHECK(world.denseChunkCount() == 0);
+        CHECK(world.uniform({0, 0, 0}) == uint16_t{1});
+        CHECK(world.dirtyChunks().contains({0, 0, 0}));
+
+        // Pasting an empty grid over the chunk removes it.
+        world.paste(VoxelGrid{{size, size, size}}, {0, 0, 0});
+        CHECK(world.chunkCount() == 0);
+    }
+
+    SUBCASE("chunks with their apron include the voxels around them")
+    {
+        world.set({0, 0, 0}, 1);
+        world.set({-1, 0, 0}, 2);
+        world.set({32, 31, 0}, 3);
+        world.set({32, 32, 0}, 4);
+
+        auto chunk = world.chunkWithApron({0, 0, 0});
+        CHECK(chunk.size() == glm::uvec3{VoxelWorld::ChunkSize + 2});
+        CHECK(chunk.get({1, 1, 1}) == 1);
+        CHECK(chunk.get({0, 1, 1}) == 2);
+        CHECK(chunk.get({33, 32, 1}) == 3);
+        CHECK(chunk.get({33, 33, 1}) == 4);
+    }
+
+    SUBCASE("filling or emptying a voxel on a chunk border marks its neighbour as dirty")
+    {
+        world.set({0, 0, 0}, 1);
+        world.set({-1, 0, 0}, 1);
+        world.clearDirty();
+
+        // Voxels away from the border only affect their own chunk.
+        world.set({5, 5, 5}, 1);
+        CHECK(world.dirtyChunks().size() == 1);
+        world.clearDirty();
+
+        world.set({0, 5, 5}, 1);
+        CHECK(world.dirtyChunks().size() == 2);
+        CHECK(world.dirtyChunks().contains({-1, 0, 0}));
+        world.clearDirty();
+
+        // Changing the material of a border voxel doesn't change which faces of the neighbour are hidden.
+        world.set({0, 5, 5}, 2);
+        CHECK(world.dirtyChunks().size() == 1);
+        world.clearDirty();
+
+        world.set({0, 5, 5}, 0);
+        CHECK(world.dirtyChunks().size() == 2);
+    }
+}